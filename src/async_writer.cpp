@@ -0,0 +1,253 @@
+#include "async_writer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <unistd.h>
+
+#include "debug.h"
+
+/**
+ * 分配缓冲池并初始化 io_uring。
+ *
+ * @param buf_size 单个缓冲区字节数，较大的写入会被拆分。
+ * @param n_bufs 缓冲区个数，即最多同时在途的写请求数。
+ * @return 成功返回 true，失败返回 false。
+ */
+bool async_writer_t::init(size_t buf_size, int n_bufs)
+{
+    if (buf_size == 0 || n_bufs <= 0) {
+        LOG_ERR("bad async writer args: %zu x %d", buf_size, n_bufs);
+        return false;
+    }
+
+    this->buf_size = buf_size;
+
+#ifdef WHISPER_FUZZY_URING
+    if (ring_ok) {
+        drain();
+        io_uring_queue_exit(&ring);
+        ring_ok = false;
+    }
+
+    pool.assign(buf_size * n_bufs, 0);
+    pending.assign(n_bufs, 0);
+    free_bufs.clear();
+    for (int i = n_bufs - 1; i >= 0; i--) {
+        free_bufs.push_back(i);
+    }
+
+    const int err = io_uring_queue_init(n_bufs, &ring, 0);
+    if (err < 0) {
+        LOG_ERR("fail to init io_uring: %s", strerror(-err));
+        return false;
+    }
+    ring_ok = true;
+#endif
+
+    return true;
+}
+
+/**
+ * 提交一次写入，返回时数据已被拷贝，调用者可以立即复用 data。
+ *
+ * @param fd 文件描述符。
+ * @param data 数据。
+ * @param n 字节数。
+ * @param offset 文件偏移。
+ * @return 成功提交返回 true，失败返回 false。
+ */
+bool async_writer_t::write(int fd, const void *data, size_t n, uint64_t offset)
+{
+    const uint8_t *p = (const uint8_t *)data;
+
+    while (n > 0) {
+        const size_t k = std::min(n, buf_size);
+
+#ifdef WHISPER_FUZZY_URING
+        if (!ring_ok) {
+            n_errors++;
+            LOG_ERR("io_uring is not available");
+            return false;
+        }
+
+        // 先顺带回收已完成的请求，缓冲池用尽时才阻塞
+        if (!reap(false)) {
+            abandon();
+            return false;
+        }
+        while (free_bufs.empty()) {
+            if (!reap(true)) {
+                abandon();
+                return false;
+            }
+        }
+
+        const int idx = free_bufs.back();
+        free_bufs.pop_back();
+
+        uint8_t *buf = pool.data() + (size_t)idx * buf_size;
+        memcpy(buf, p, k);
+
+        struct io_uring_sqe *sqe = io_uring_get_sqe(&ring);
+        if (!sqe) {
+            free_bufs.push_back(idx);
+            n_errors++;
+            LOG_ERR("io_uring submission queue full");
+            return false;
+        }
+        io_uring_prep_write(sqe, fd, buf, (unsigned)k, offset);
+        io_uring_sqe_set_data(sqe, (void *)(intptr_t)idx);
+
+        int err;
+        do {
+            err = io_uring_submit(&ring);
+        } while (err == -EINTR);
+        if (err < 0) {
+            // 内核没有取走这个请求，但它已在提交队列中，下次提交时仍会执行：
+            // 改成不带缓冲区的空操作，完成事件回收时跳过，缓冲区立即归还
+            io_uring_prep_nop(sqe);
+            io_uring_sqe_set_data(sqe, (void *)(intptr_t)-1);
+            free_bufs.push_back(idx);
+            n_errors++;
+            LOG_ERR("fail to submit io_uring write: %s", strerror(-err));
+            return false;
+        }
+        // 只有提交成功的请求才会有完成事件
+        pending[idx] = k;
+        n_inflight++;
+#else
+        const ssize_t ret = pwrite(fd, p, k, (off_t)offset);
+        if (ret != (ssize_t)k) {
+            n_errors++;
+            LOG_ERR("fail to write %zu bytes at %llu: %s", k, (unsigned long long)offset,
+                ret < 0 ? strerror(errno) : "short write");
+            return false;
+        }
+#endif
+
+        p      += k;
+        n      -= k;
+        offset += k;
+    }
+
+    return true;
+}
+
+/**
+ * 等待所有在途写请求完成，关闭文件前必须调用。
+ *
+ * @return 期间没有新的写错误返回 true。
+ */
+bool async_writer_t::drain()
+{
+    const uint64_t n_errors_before = n_errors;
+    while (n_inflight > 0) {
+        if (!reap(true)) {
+            abandon();
+            break;
+        }
+    }
+    return n_errors == n_errors_before;
+}
+
+/**
+ * 回收已完成的写请求。
+ *
+ * @param wait 没有完成事件时是否阻塞等待一个。
+ * @return 成功返回 true，等待完成事件出错返回 false。
+ */
+bool async_writer_t::reap(bool wait)
+{
+#ifdef WHISPER_FUZZY_URING
+    if (!ring_ok || n_inflight == 0) {
+        return true;
+    }
+
+    struct io_uring_cqe *cqe = nullptr;
+    int err;
+    do {
+        err = wait ? io_uring_wait_cqe(&ring, &cqe) : io_uring_peek_cqe(&ring, &cqe);
+    } while (wait && err == -EINTR);
+    if (wait && err < 0) {
+        LOG_ERR("fail to wait for io_uring completion: %s", strerror(-err));
+        return false;
+    }
+
+    while (err == 0 && cqe) {
+        const int idx = (int)(intptr_t)io_uring_cqe_get_data(cqe);
+        if (idx < 0) {
+            // 提交失败后改成空操作的请求
+            io_uring_cqe_seen(&ring, cqe);
+            cqe = nullptr;
+            err = io_uring_peek_cqe(&ring, &cqe);
+            continue;
+        }
+        if (cqe->res < 0 || (size_t)cqe->res != pending[idx]) {
+            n_errors++;
+            LOG_ERR("io_uring write failed: %s", cqe->res < 0 ? strerror(-cqe->res) : "short write");
+        }
+        io_uring_cqe_seen(&ring, cqe);
+
+        pending[idx] = 0;
+        free_bufs.push_back(idx);
+        n_inflight--;
+
+        // 一次取完所有已完成的事件
+        cqe = nullptr;
+        err = n_inflight > 0 ? io_uring_peek_cqe(&ring, &cqe) : -EAGAIN;
+    }
+#else
+    (void)wait;
+#endif
+    return true;
+}
+
+/**
+ * 放弃全部在途写请求并关闭 ring，剩余请求计为写错误；之后的写入直接失败，直到重新 init()。
+ */
+void async_writer_t::abandon()
+{
+#ifdef WHISPER_FUZZY_URING
+    if (!ring_ok) {
+        return;
+    }
+
+    LOG_ERR("giving up %d in-flight io_uring writes", n_inflight);
+    n_errors += n_inflight;
+
+    // 关闭 ring 时内核取消还没完成的请求，缓冲池之后不再使用
+    io_uring_queue_exit(&ring);
+    ring_ok = false;
+    n_inflight = 0;
+    free_bufs.clear();
+    std::fill(pending.begin(), pending.end(), 0);
+#endif
+}
+
+/**
+ * 获取当前编译使用的实现名称，用于日志。
+ *
+ * @return io_uring 或 pwrite。
+ */
+const char *async_writer_t::impl()
+{
+#ifdef WHISPER_FUZZY_URING
+    return "io_uring";
+#else
+    return "pwrite";
+#endif
+}
+
+async_writer_t::~async_writer_t()
+{
+#ifdef WHISPER_FUZZY_URING
+    if (ring_ok) {
+        drain();
+        io_uring_queue_exit(&ring);
+        ring_ok = false;
+    }
+#endif
+}
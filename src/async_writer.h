@@ -0,0 +1,94 @@
+#ifndef ASYNC_WRITER_H_
+#define ASYNC_WRITER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#ifdef WHISPER_FUZZY_URING
+#include <liburing.h>
+#endif
+
+/**
+ * 异步文件写入器。
+ *
+ * 定义 WHISPER_FUZZY_URING 时通过 io_uring 提交写请求：数据先拷贝到固定的缓冲池，
+ * 提交后立即返回，完成事件在之后的调用中顺带回收，缓冲池用尽时才等待；
+ * 未启用 io_uring 时退化为在调用线程中同步 pwrite。
+ * 所有写入都带显式偏移，不依赖文件位置。只能在一个线程中使用。
+ */
+struct async_writer_t {
+    /**
+     * 分配缓冲池并初始化 io_uring。
+     *
+     * @param buf_size 单个缓冲区字节数，较大的写入会被拆分。
+     * @param n_bufs 缓冲区个数，即最多同时在途的写请求数。
+     * @return 成功返回 true，失败返回 false。
+     */
+    bool init(size_t buf_size, int n_bufs);
+
+    /**
+     * 提交一次写入，返回时数据已被拷贝，调用者可以立即复用 data。
+     *
+     * @param fd 文件描述符。
+     * @param data 数据。
+     * @param n 字节数。
+     * @param offset 文件偏移。
+     * @return 成功提交返回 true，失败返回 false。
+     */
+    bool write(int fd, const void *data, size_t n, uint64_t offset);
+
+    /**
+     * 等待所有在途写请求完成，关闭文件前必须调用。
+     *
+     * @return 期间没有新的写错误返回 true。
+     */
+    bool drain();
+
+    /**
+     * 获取累计的写错误次数（包括短写）。
+     *
+     * @return 错误次数。
+     */
+    uint64_t errors() const { return n_errors; }
+
+    /**
+     * 获取当前编译使用的实现名称，用于日志。
+     *
+     * @return io_uring 或 pwrite。
+     */
+    static const char *impl();
+
+    async_writer_t() {}
+    async_writer_t(const async_writer_t &) = delete;
+    async_writer_t &operator=(const async_writer_t &) = delete;
+    ~async_writer_t();
+
+private:
+    /**
+     * 回收已完成的写请求。
+     *
+     * @param wait 没有完成事件时是否阻塞等待一个。
+     * @return 成功返回 true，等待完成事件出错返回 false。
+     */
+    bool reap(bool wait);
+
+    /**
+     * 放弃全部在途写请求并关闭 ring，剩余请求计为写错误；之后的写入直接失败，直到重新 init()。
+     */
+    void abandon();
+
+    size_t buf_size = 0;                    ///< 单个缓冲区字节数
+    std::vector<uint8_t> pool;              ///< 缓冲池，n_bufs * buf_size 字节（仅 io_uring）
+    std::vector<int> free_bufs;             ///< 空闲缓冲区下标
+    std::vector<size_t> pending;            ///< 每个缓冲区在途写请求的字节数
+    int n_inflight = 0;                     ///< 在途写请求数
+    uint64_t n_errors = 0;                  ///< 写错误次数
+
+#ifdef WHISPER_FUZZY_URING
+    struct io_uring ring;                   ///< io_uring 实例
+    bool ring_ok = false;                   ///< ring 是否已初始化
+#endif
+};
+
+#endif  // ASYNC_WRITER_H_
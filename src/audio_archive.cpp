@@ -0,0 +1,399 @@
+#include "audio_archive.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "debug.h"
+#include "wav_file.h"
+
+#define ARCHIVE_FRAME_MS      20            ///< 语音判决帧长（毫秒）
+#define ARCHIVE_WRITE_SAMPLES 32768         ///< 暂存区攒够多少样本提交一次写入
+#define ARCHIVE_WRITE_BUFS    8             ///< 最多同时在途的写请求数
+#define ARCHIVE_INDEX_NAME    "index.tsv"   ///< 索引文件名
+
+/**
+ * 创建存档目录、打开索引并启动存档线程。
+ *
+ * @param params 存档参数。
+ * @return 成功返回 true，失败返回 false。
+ */
+bool audio_archive_t::open(const audio_archive_params_t &params)
+{
+    close();
+
+    if (params.dir.empty() || params.sample_rate <= 0 || params.pad_ms < 0) {
+        LOG_ERR("bad archive args: dir = '%s', rate = %d, pad = %d ms",
+            params.dir.c_str(), params.sample_rate, params.pad_ms);
+        return false;
+    }
+
+    this->params = params;
+
+    if (mkdir(params.dir.c_str(), 0755) != 0 && errno != EEXIST) {
+        LOG_ERR("fail to create archive dir %s: %s", params.dir.c_str(), strerror(errno));
+        return false;
+    }
+
+    const size_t queue_samples = params.queue_samples > 0 ? params.queue_samples : (size_t)10 * params.sample_rate;
+    if (!queue.init(queue_samples)) {
+        LOG_ERR("fail to init archive queue, samples: %zu", queue_samples);
+        return false;
+    }
+
+    if (!writer.init(ARCHIVE_WRITE_SAMPLES * sizeof(int16_t), ARCHIVE_WRITE_BUFS)) {
+        return false;
+    }
+
+    // 索引只追加，每次启动接在已有内容之后
+    const std::string index_path = params.dir + "/" + ARCHIVE_INDEX_NAME;
+    fd_index = ::open(index_path.c_str(), O_WRONLY | O_CREAT, 0644);
+    if (fd_index < 0) {
+        LOG_ERR("fail to open %s: %s", index_path.c_str(), strerror(errno));
+        return false;
+    }
+    struct stat st;
+    index_off = fstat(fd_index, &st) == 0 ? (uint64_t)st.st_size : 0;
+    if (index_off == 0) {
+        static const char header[] = "# file\toffset\tsamples\tstart_sample\tstart_ms\n";
+        writer.write(fd_index, header, sizeof(header) - 1, 0);
+        index_off = sizeof(header) - 1;
+    }
+
+    n_frame      = std::max(1, params.sample_rate * ARCHIVE_FRAME_MS / 1000);
+    n_pad_frames = (params.pad_ms + ARCHIVE_FRAME_MS - 1) / ARCHIVE_FRAME_MS;
+    t_open_ms    = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    n_clock      = 0;
+    n_gap        = 0;
+
+    gate.init(params.sample_rate, params.freq_thold, params.gate_db, params.floor_db);
+
+    lookback.assign((size_t)n_pad_frames * n_frame, 0);
+    lookback_pos = 0;
+    lookback_len = 0;
+    in_span  = false;
+    hangover = 0;
+
+    staging.clear();
+    staging.reserve(ARCHIVE_WRITE_SAMPLES + n_frame);
+    fd_seg    = -1;
+    seg_seq   = 0;
+    span_open = false;
+
+    n_spans          = 0;
+    n_segments       = 0;
+    n_samples_in     = 0;
+    n_samples_kept   = 0;
+    n_dropped_blocks = 0;
+    n_io_errors      = 0;
+
+    worker = std::thread(&audio_archive_t::run, this);
+
+    LOG_INFO("archiving speech to %s (%s), pad %d ms, segment %d sec / %llu bytes",
+        params.dir.c_str(), async_writer_t::impl(), params.pad_ms,
+        params.segment_sec, (unsigned long long)params.segment_bytes);
+
+    return true;
+}
+
+/**
+ * 放入一块样本（仅限采集线程调用），不阻塞。
+ *
+ * @param data 样本数据。
+ * @param n 样本数。
+ * @return 放入队列返回 true，队列已满而丢弃返回 false。
+ */
+bool audio_archive_t::push(const int16_t *data, size_t n)
+{
+    n_samples_in.fetch_add(n, std::memory_order_relaxed);
+
+    if (queue.space() < n) {
+        // 丢弃的样本仍然推进采集时钟，之后的时间戳不会漂移
+        n_gap.fetch_add(n, std::memory_order_relaxed);
+        n_dropped_blocks.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    queue.write(data, n);
+    return true;
+}
+
+/**
+ * 处理完队列中剩余的样本，结束当前片段，停止存档线程并关闭文件。
+ * 调用前采集线程必须已停止调用 push()。
+ */
+void audio_archive_t::close()
+{
+    if (!worker.joinable()) {
+        return;
+    }
+
+    queue.close();
+    worker.join();
+}
+
+/**
+ * 存档线程主循环。
+ */
+void audio_archive_t::run()
+{
+    std::vector<int16_t> frame(n_frame);
+
+    while (true) {
+        const size_t n_avail = queue.wait(n_frame, 1000);
+        if (n_avail < n_frame && !queue.is_closed()) {
+            continue;
+        }
+        if (n_avail == 0) {
+            break;
+        }
+
+        // 关闭后不足一帧的尾部也按一帧处理
+        const audio_ring_view_t view = queue.peek(std::min(n_avail, n_frame));
+        std::copy(view.data[0], view.data[0] + view.size[0], frame.begin());
+        std::copy(view.data[1], view.data[1] + view.size[1], frame.begin() + view.size[0]);
+        queue.consume(view.total());
+
+        const uint64_t gap = n_gap.exchange(0, std::memory_order_relaxed);
+        if (gap > 0) {
+            // 队列满时丢过样本，音频不连续：结束当前片段，丢掉前部留白
+            if (in_span) {
+                end_span();
+                in_span = false;
+            }
+            lookback_len = 0;
+            n_clock += gap;
+        }
+
+        process_frame(frame.data(), view.total());
+    }
+
+    if (in_span) {
+        end_span();
+        in_span = false;
+    }
+    close_segment();
+
+    writer.drain();
+    n_io_errors = writer.errors();
+
+    ::close(fd_index);
+    fd_index = -1;
+}
+
+/**
+ * 处理一帧样本：语音判决并按需写入。
+ *
+ * @param frame 帧数据。
+ * @param n 帧长度（样本数）。
+ */
+void audio_archive_t::process_frame(const int16_t *frame, size_t n)
+{
+    const bool speech = gate.process(frame, n);
+
+    if (speech) {
+        if (!in_span) {
+            in_span = true;
+            n_spans.fetch_add(1, std::memory_order_relaxed);
+
+            // 先写入语音开始之前保留的音频
+            const size_t cap   = lookback.size();
+            const size_t start = (lookback_pos + cap - lookback_len) % std::max<size_t>(cap, 1);
+            const size_t n0    = std::min(lookback_len, cap - start);
+            uint64_t at = n_clock - lookback_len;
+            if (n0 > 0) {
+                append(lookback.data() + start, n0, at);
+                at += n0;
+            }
+            if (lookback_len > n0) {
+                append(lookback.data(), lookback_len - n0, at);
+            }
+            lookback_len = 0;
+        }
+        append(frame, n, n_clock);
+        hangover = n_pad_frames;
+    } else if (in_span && hangover > 0) {
+        append(frame, n, n_clock);
+        hangover--;
+    } else {
+        if (in_span) {
+            end_span();
+            in_span = false;
+        }
+
+        // 记入前部留白的环形缓冲
+        const size_t cap = lookback.size();
+        for (size_t i = 0; i < n && cap > 0; ++i) {
+            lookback[lookback_pos] = frame[i];
+            lookback_pos = (lookback_pos + 1) % cap;
+        }
+        lookback_len = std::min(lookback_len + n, cap);
+    }
+
+    n_clock += n;
+}
+
+/**
+ * 把样本追加到当前片段，必要时先轮转分段文件。
+ *
+ * @param data 样本数据。
+ * @param n 样本数。
+ * @param at 第一个样本的采样时钟。
+ */
+void audio_archive_t::append(const int16_t *data, size_t n, uint64_t at)
+{
+    if (fd_seg >= 0) {
+        const uint64_t bytes = seg_bytes + staging.size() * sizeof(int16_t);
+        const bool full_bytes = params.segment_bytes > 0 && bytes > 0 &&
+            WAV_HEADER_SIZE + bytes + n * sizeof(int16_t) > params.segment_bytes;
+        const bool full_time = params.segment_sec > 0 &&
+            at - seg_clock >= (uint64_t)params.segment_sec * params.sample_rate;
+        if (full_bytes || full_time) {
+            // 片段跨越两个分段时拆成两条索引
+            close_segment();
+        }
+    }
+
+    if (fd_seg < 0 && !open_segment(at)) {
+        return;
+    }
+
+    if (!span_open) {
+        span_open    = true;
+        span_offset  = WAV_HEADER_SIZE + seg_bytes + staging.size() * sizeof(int16_t);
+        span_samples = 0;
+        span_clock   = at;
+    }
+
+    staging.insert(staging.end(), data, data + n);
+    span_samples += n;
+    n_samples_kept.fetch_add(n, std::memory_order_relaxed);
+
+    if (staging.size() >= ARCHIVE_WRITE_SAMPLES) {
+        flush();
+    }
+}
+
+/**
+ * 结束当前片段：写出暂存数据并追加一条索引。
+ */
+void audio_archive_t::end_span()
+{
+    if (!span_open) {
+        return;
+    }
+    span_open = false;
+
+    flush();
+
+    char line[512];
+    const int len = snprintf(line, sizeof(line), "%s\t%llu\t%llu\t%llu\t%lld\n",
+        seg_name.c_str(), (unsigned long long)span_offset, (unsigned long long)span_samples,
+        (unsigned long long)span_clock, (long long)clock_to_ms(span_clock));
+    if (len <= 0 || len >= (int)sizeof(line)) {
+        return;
+    }
+
+    writer.write(fd_index, line, len, index_off);
+    index_off += len;
+    n_io_errors = writer.errors();
+}
+
+/**
+ * 提交暂存区中的样本。
+ */
+void audio_archive_t::flush()
+{
+    if (staging.empty() || fd_seg < 0) {
+        staging.clear();
+        return;
+    }
+
+    const size_t bytes = staging.size() * sizeof(int16_t);
+    writer.write(fd_seg, staging.data(), bytes, WAV_HEADER_SIZE + seg_bytes);
+    seg_bytes += bytes;
+    staging.clear();
+    n_io_errors = writer.errors();
+}
+
+/**
+ * 创建新的分段文件。
+ *
+ * @param at 分段第一个样本的采样时钟。
+ * @return 成功返回 true，失败返回 false。
+ */
+bool audio_archive_t::open_segment(uint64_t at)
+{
+    const time_t t = (time_t)(clock_to_ms(at) / 1000);
+    struct tm tm;
+    localtime_r(&t, &tm);
+
+    char name[64];
+    const size_t len = strftime(name, sizeof(name), "%Y%m%d%H%M%S", &tm);
+    snprintf(name + len, sizeof(name) - len, "-%04d.wav", seg_seq++);
+
+    const std::string path = params.dir + "/" + name;
+    fd_seg = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd_seg < 0) {
+        LOG_ERR("fail to create %s: %s", path.c_str(), strerror(errno));
+        n_io_errors.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    // 长度先写 0，异常退出时读取端按“读到文件结尾”处理
+    uint8_t hdr[WAV_HEADER_SIZE];
+    wav_make_header(hdr, params.sample_rate, 1, 0);
+    writer.write(fd_seg, hdr, sizeof(hdr), 0);
+
+    seg_name  = name;
+    seg_bytes = 0;
+    seg_clock = at;
+    n_segments.fetch_add(1, std::memory_order_relaxed);
+
+    LOG_DBG("archive segment %s", path.c_str());
+
+    return true;
+}
+
+/**
+ * 回填文件头并关闭当前分段文件。
+ */
+void audio_archive_t::close_segment()
+{
+    if (fd_seg < 0) {
+        return;
+    }
+
+    end_span();
+    flush();
+
+    uint8_t hdr[WAV_HEADER_SIZE];
+    wav_make_header(hdr, params.sample_rate, 1, (uint32_t)std::min<uint64_t>(seg_bytes, UINT32_MAX - 36));
+    writer.write(fd_seg, hdr, sizeof(hdr), 0);
+
+    // 在途的写请求还引用着 fd，全部完成后才能关闭
+    writer.drain();
+    n_io_errors = writer.errors();
+
+    ::close(fd_seg);
+    fd_seg = -1;
+}
+
+/**
+ * 采样时钟对应的 Unix 时间（毫秒）。
+ *
+ * @param at 采样时钟。
+ * @return Unix 时间（毫秒）。
+ */
+int64_t audio_archive_t::clock_to_ms(uint64_t at) const
+{
+    return t_open_ms + (int64_t)(at * 1000 / params.sample_rate);
+}
@@ -0,0 +1,210 @@
+#ifndef AUDIO_ARCHIVE_H_
+#define AUDIO_ARCHIVE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "async_writer.h"
+#include "audio_ring.h"
+#include "audio_tap.h"
+#include "energy_gate.h"
+
+/**
+ * 语音存档参数。
+ */
+struct audio_archive_params_t {
+    std::string dir;                ///< 存档目录，不存在时自动创建
+    int sample_rate     = 16000;    ///< 采样率
+    int pad_ms          = 300;      ///< 语音段前后各保留的时长（毫秒）
+    int segment_sec     = 600;      ///< 单个分段文件最多包含的时长（秒，按采样时钟），0 表示不限
+    uint64_t segment_bytes = 0;     ///< 单个分段文件的最大字节数，0 表示不限
+    size_t queue_samples = 0;       ///< 采集线程到存档线程的队列容量，0 表示 10 秒
+    float freq_thold    = 100.0f;   ///< 判决前高通滤波的截止频率（Hz）
+    float gate_db       = 10.0f;    ///< 帧能量高出噪声底多少 dB 判为语音
+    float floor_db      = -60.0f;   ///< 低于该能量（dBFS）的帧一律判为静音
+};
+
+/**
+ * 只保存语音片段的分段音频存档。
+ *
+ * 采集线程通过 push() 把样本放入有界队列，从不阻塞、不访问磁盘；
+ * 独立的存档线程按 20 ms 帧做语音判决，只把语音段（前后各加 pad_ms）写入分段 WAV 文件，
+ * 分段按时长或大小轮转。所有写入通过 async_writer_t 提交（启用时为 io_uring）。
+ * 目录下的 index.tsv 记录每个片段所在的文件、字节偏移、样本数和时间戳。
+ *
+ * 时间戳来自采样时钟：以 open() 时的系统时间为起点，按已接收（包括丢弃）的样本数推算。
+ */
+struct audio_archive_t : audio_tap_t {
+    /**
+     * 创建存档目录、打开索引并启动存档线程。
+     *
+     * @param params 存档参数。
+     * @return 成功返回 true，失败返回 false。
+     */
+    bool open(const audio_archive_params_t &params);
+
+    /**
+     * 放入一块样本（仅限采集线程调用），不阻塞。
+     *
+     * @param data 样本数据。
+     * @param n 样本数。
+     * @return 放入队列返回 true，队列已满而丢弃返回 false。
+     */
+    bool push(const int16_t *data, size_t n) override;
+
+    /**
+     * 处理完队列中剩余的样本，结束当前片段，停止存档线程并关闭文件。
+     * 调用前采集线程必须已停止调用 push()。
+     */
+    void close();
+
+    /**
+     * 判断存档是否已打开。
+     *
+     * @return 已打开返回 true。
+     */
+    bool is_open() const { return worker.joinable(); }
+
+    /**
+     * 获取已保存的语音段数。
+     *
+     * @return 已保存的语音段数。
+     */
+    uint64_t spans() const { return n_spans.load(std::memory_order_relaxed); }
+
+    /**
+     * 获取已创建的分段文件数。
+     *
+     * @return 已创建的分段文件数。
+     */
+    uint64_t segments() const { return n_segments.load(std::memory_order_relaxed); }
+
+    /**
+     * 获取已接收的样本数（包括丢弃）。
+     *
+     * @return 已接收的样本数（包括丢弃）。
+     */
+    uint64_t samples_in() const { return n_samples_in.load(std::memory_order_relaxed); }
+
+    /**
+     * 获取已写入分段文件的样本数。
+     *
+     * @return 已写入分段文件的样本数。
+     */
+    uint64_t samples_kept() const { return n_samples_kept.load(std::memory_order_relaxed); }
+
+    /**
+     * 获取因队列满而丢弃的块数。
+     *
+     * @return 因队列满而丢弃的块数。
+     */
+    uint64_t dropped_blocks() const { return n_dropped_blocks.load(std::memory_order_relaxed); }
+
+    /**
+     * 获取写错误次数。
+     *
+     * @return 写错误次数。
+     */
+    uint64_t io_errors() const { return n_io_errors.load(std::memory_order_relaxed); }
+
+
+    ~audio_archive_t() { close(); }
+
+private:
+    /**
+     * 存档线程主循环。
+     */
+    void run();
+
+    /**
+     * 处理一帧样本：语音判决并按需写入。
+     *
+     * @param frame 帧数据。
+     * @param n 帧长度（样本数）。
+     */
+    void process_frame(const int16_t *frame, size_t n);
+
+    /**
+     * 把样本追加到当前片段，必要时先轮转分段文件。
+     *
+     * @param data 样本数据。
+     * @param n 样本数。
+     * @param at 第一个样本的采样时钟。
+     */
+    void append(const int16_t *data, size_t n, uint64_t at);
+
+    /**
+     * 结束当前片段：写出暂存数据并追加一条索引。
+     */
+    void end_span();
+
+    /**
+     * 提交暂存区中的样本。
+     */
+    void flush();
+
+    /**
+     * 创建新的分段文件。
+     *
+     * @param at 分段第一个样本的采样时钟。
+     * @return 成功返回 true，失败返回 false。
+     */
+    bool open_segment(uint64_t at);
+
+    /**
+     * 回填文件头并关闭当前分段文件。
+     */
+    void close_segment();
+
+    /**
+     * 采样时钟对应的 Unix 时间（毫秒）。
+     *
+     * @param at 采样时钟。
+     * @return Unix 时间（毫秒）。
+     */
+    int64_t clock_to_ms(uint64_t at) const;
+
+    audio_archive_params_t params;              ///< 存档参数
+    audio_ring_t queue;                         ///< 采集线程到存档线程的有界队列
+    std::thread worker;                         ///< 存档线程
+    async_writer_t writer;                      ///< 异步写入器，只在存档线程中使用
+
+    size_t n_frame = 0;                         ///< 判决帧长（样本数）
+    int    n_pad_frames = 0;                    ///< 前后保留的帧数
+    int64_t t_open_ms = 0;                      ///< 采样时钟零点对应的 Unix 时间（毫秒）
+    uint64_t n_clock = 0;                       ///< 存档线程已处理到的采样时钟
+    std::atomic<uint64_t> n_gap{0};             ///< 尚未计入采样时钟的丢弃样本数
+
+    energy_gate_t gate;                         ///< 语音判决
+
+    std::vector<int16_t> lookback;              ///< 最近 pad_ms 音频的环形缓冲，用于片段前部留白
+    size_t lookback_pos = 0;                    ///< lookback 写入位置
+    size_t lookback_len = 0;                    ///< lookback 有效样本数
+    bool in_span = false;                       ///< 是否处于语音段中
+    int  hangover = 0;                          ///< 语音结束后还要保留的帧数
+
+    std::vector<int16_t> staging;               ///< 待提交的样本
+    int fd_seg = -1;                            ///< 当前分段文件
+    int fd_index = -1;                          ///< 索引文件
+    std::string seg_name;                       ///< 当前分段文件名（不含目录）
+    uint64_t seg_bytes = 0;                     ///< 当前分段的数据字节数（不含文件头）
+    uint64_t seg_clock = 0;                     ///< 当前分段第一个样本的采样时钟
+    int seg_seq = 0;                            ///< 分段序号
+    uint64_t index_off = 0;                     ///< 索引文件的追加位置
+    bool span_open = false;                     ///< 当前分段中是否有未结束的索引条目
+    uint64_t span_offset = 0;                   ///< 索引条目在分段文件中的字节偏移
+    uint64_t span_samples = 0;                  ///< 索引条目的样本数
+    uint64_t span_clock = 0;                    ///< 索引条目第一个样本的采样时钟
+
+    std::atomic<uint64_t> n_spans{0};           ///< 语音段数
+    std::atomic<uint64_t> n_segments{0};        ///< 分段文件数
+    std::atomic<uint64_t> n_samples_in{0};      ///< 接收的样本数
+    std::atomic<uint64_t> n_samples_kept{0};    ///< 保存的样本数
+    std::atomic<uint64_t> n_dropped_blocks{0};  ///< 丢弃的块数
+    std::atomic<uint64_t> n_io_errors{0};       ///< 写错误次数
+};
+
+#endif  // AUDIO_ARCHIVE_H_
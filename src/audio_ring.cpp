@@ -0,0 +1,270 @@
+#include "audio_ring.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include "debug.h"
+
+#define AUDIO_RING_GAPS 64  ///< 丢样记录队列长度（2 的幂）
+
+/**
+ * 初始化缓冲区。
+ *
+ * @param capacity 期望容量（样本数），实际容量向上取整为 2 的幂。
+ * @return 成功返回 true，失败返回 false。
+ */
+bool audio_ring_t::init(size_t capacity)
+{
+    if (capacity == 0) {
+        LOG_ERR("capacity is 0");
+        return false;
+    }
+
+    size_t n = 1;
+    while (n < capacity) {
+        n <<= 1;
+    }
+
+    buf.assign(n, 0);
+    mask = n - 1;
+
+    head.store(0);
+    tail.store(0);
+    want.store(0);
+    want_space.store(0);
+    n_dropped.store(0);
+    closed.store(false);
+    kicked.store(false);
+
+    gaps.assign(AUDIO_RING_GAPS, gap_t());
+    gap_head.store(0);
+    gap_tail.store(0);
+    gap_carry = 0;
+    clock_offset = 0;
+
+    return true;
+}
+
+/**
+ * 写入样本（仅限生产者线程调用）。
+ * 空间不足时丢弃放不下的样本，并计入丢弃计数。
+ *
+ * @param data 样本数据。
+ * @param n 样本数。
+ * @return 实际写入的样本数。
+ */
+size_t audio_ring_t::write(const int16_t *data, size_t n)
+{
+    const uint64_t h = head.load(std::memory_order_relaxed);
+    const uint64_t t = tail.load(std::memory_order_acquire);
+
+    const size_t space = buf.size() - (size_t)(h - t);
+    const size_t n_write = std::min(n, space);
+    if (n_write < n) {
+        n_dropped.fetch_add(n - n_write, std::memory_order_relaxed);
+        add_gap(h + n_write, n - n_write);
+    }
+
+    if (n_write > 0) {
+        const size_t pos = (size_t)h & mask;
+        const size_t n_first = std::min(n_write, buf.size() - pos);
+
+        memcpy(buf.data() + pos, data, n_first * sizeof(int16_t));
+        memcpy(buf.data(), data + n_first, (n_write - n_first) * sizeof(int16_t));
+
+        // seq_cst: 与消费者写 want 再读 head 的顺序配对，避免丢失唤醒
+        head.store(h + n_write);
+    }
+
+    const size_t w = want.load();
+    if (w > 0 && (size_t)(h + n_write - t) >= w) {
+        { std::lock_guard<std::mutex> lock(mtx); }
+        cv.notify_one();
+    }
+
+    return n_write;
+}
+
+/**
+ * 记录 n 个没有写入的样本（仅限生产者线程调用），例如设备 xrun 时丢失的样本。
+ * 与缓冲区满时一样记为丢样，消费者读到该位置时采样时钟跳过它们，但不计入 dropped()。
+ *
+ * @param n 丢失的样本数。
+ */
+void audio_ring_t::skip(size_t n)
+{
+    if (n > 0) {
+        add_gap(head.load(std::memory_order_relaxed), n);
+    }
+}
+
+/**
+ * 写入一条丢样记录（仅限生产者线程调用）。
+ *
+ * @param pos 丢样之后第一个样本在 ring 中的累计位置。
+ * @param n 丢弃的样本数。
+ */
+void audio_ring_t::add_gap(uint64_t pos, uint64_t n)
+{
+    // 消费者据此保持采样时钟连续；记录队列满时并入下一条，位置略有偏差但总数不丢
+    const uint64_t gh = gap_head.load(std::memory_order_relaxed);
+    if (gh - gap_tail.load(std::memory_order_acquire) < gaps.size()) {
+        gaps[gh & (gaps.size() - 1)] = { pos, n + gap_carry };
+        gap_carry = 0;
+        gap_head.store(gh + 1, std::memory_order_release);
+    } else {
+        gap_carry += n;
+    }
+}
+
+/**
+ * 阻塞等待至少 n 个可写空间（仅限生产者线程调用）。
+ * 用于不能丢弃样本的生产者（例如不限速读取文件）。
+ *
+ * @param n 需要的空间（样本数），超过容量时按容量计算。
+ * @param timeout_ms 超时时间（毫秒），超时或缓冲区关闭后返回。
+ * @return 返回时可写的样本数，可能小于 n。
+ */
+size_t audio_ring_t::wait_space(size_t n, int timeout_ms)
+{
+    n = std::min(n, buf.size());
+
+    if (space() >= n || is_closed()) {
+        return space();
+    }
+
+    std::unique_lock<std::mutex> lock(mtx);
+    want_space.store(std::max<size_t>(n, 1));
+
+    cv_space.wait_for(lock, std::chrono::milliseconds(timeout_ms), [&] {
+        return space() >= n || is_closed();
+    });
+
+    want_space.store(0);
+
+    return space();
+}
+
+/**
+ * 阻塞等待至少 n 个可读样本（仅限消费者线程调用）。
+ *
+ * @param n 需要的样本数。
+ * @param timeout_ms 超时时间（毫秒），超时或缓冲区关闭后返回。
+ * @return 返回时可读的样本数，可能小于 n。
+ */
+size_t audio_ring_t::wait(size_t n, int timeout_ms)
+{
+    size_t n_avail = available();
+    if (n_avail >= n || is_closed() || kicked.exchange(false)) {
+        return n_avail;
+    }
+
+    std::unique_lock<std::mutex> lock(mtx);
+    want.store(std::max<size_t>(n, 1));
+
+    cv.wait_for(lock, std::chrono::milliseconds(timeout_ms), [&] {
+        return available() >= n || is_closed() || kicked.exchange(false);
+    });
+
+    want.store(0);
+
+    return available();
+}
+
+/**
+ * 获取前 n 个可读样本的视图，不拷贝数据（仅限消费者线程调用）。
+ * 视图在调用 consume() 之前有效。
+ *
+ * @param n 需要的样本数，超过可读数量时截断。
+ * @return 样本视图。
+ */
+audio_ring_view_t audio_ring_t::peek(size_t n) const
+{
+    audio_ring_view_t view;
+
+    n = std::min(n, available());
+    if (n == 0) {
+        return view;
+    }
+
+    const size_t pos = (size_t)tail.load(std::memory_order_relaxed) & mask;
+    const size_t n_first = std::min(n, buf.size() - pos);
+
+    view.data[0] = buf.data() + pos;
+    view.size[0] = n_first;
+    view.data[1] = buf.data();
+    view.size[1] = n - n_first;
+
+    return view;
+}
+
+/**
+ * 释放前 n 个已读样本（仅限消费者线程调用）。
+ *
+ * @param n 释放的样本数，超过可读数量时截断。
+ */
+void audio_ring_t::consume(size_t n)
+{
+    n = std::min(n, available());
+
+    const uint64_t t = tail.load(std::memory_order_relaxed) + n;
+    tail.store(t);
+
+    // 读过丢样位置后把丢弃数计入采样时钟
+    uint64_t gt = gap_tail.load(std::memory_order_relaxed);
+    while (gt < gap_head.load(std::memory_order_acquire) && gaps[gt & (gaps.size() - 1)].pos <= t) {
+        clock_offset += gaps[gt & (gaps.size() - 1)].n;
+        gap_tail.store(++gt, std::memory_order_release);
+    }
+
+    const size_t w = want_space.load();
+    if (w > 0 && buf.size() - (size_t)(head.load(std::memory_order_relaxed) - t) >= w) {
+        { std::lock_guard<std::mutex> lock(mtx); }
+        cv_space.notify_one();
+    }
+}
+
+/**
+ * 获取当前可读样本数。
+ *
+ * @return 可读样本数。
+ */
+size_t audio_ring_t::available() const
+{
+    const uint64_t t = tail.load(std::memory_order_relaxed);
+    // seq_cst: wait() 中先写 want 再读 head，需要与生产者的 store/load 全序配对
+    return (size_t)(head.load() - t);
+}
+
+/**
+ * 获取当前可写空间，不阻塞（仅限生产者线程调用）。
+ *
+ * @return 可写样本数。
+ */
+size_t audio_ring_t::space() const
+{
+    return buf.size() - (size_t)(head.load(std::memory_order_relaxed) - tail.load());
+}
+
+/**
+ * 关闭缓冲区并唤醒正在等待的消费者，之后 wait() 不再阻塞。
+ */
+void audio_ring_t::close()
+{
+    closed.store(true, std::memory_order_release);
+    { std::lock_guard<std::mutex> lock(mtx); }
+    cv.notify_all();
+    cv_space.notify_all();
+}
+
+/**
+ * 提前唤醒正在 wait() 的消费者，即使样本数还不够（可在任意线程调用）。
+ * 消费者当时没有在等待时，下一次 wait() 立即返回。
+ */
+void audio_ring_t::kick()
+{
+    kicked.store(true);
+    { std::lock_guard<std::mutex> lock(mtx); }
+    cv.notify_one();
+}
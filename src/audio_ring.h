@@ -0,0 +1,194 @@
+#ifndef AUDIO_RING_H_
+#define AUDIO_RING_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+/**
+ * 环形缓冲区中一段可读数据的只读视图。
+ * 数据可能跨越缓冲区末尾，因此最多分为两段，按顺序拼接即为完整数据。
+ */
+struct audio_ring_view_t {
+    const int16_t *data[2] = { nullptr, nullptr };  ///< 两段数据的起始地址
+    size_t       size[2] = { 0, 0 };              ///< 两段数据的样本数
+
+    /**
+     * 获取视图中的样本总数。
+     *
+     * @return 两段数据样本数之和。
+     */
+    size_t total() const { return size[0] + size[1]; }
+};
+
+/**
+ * 单生产者/单消费者（SPSC）无锁音频环形缓冲区。
+ * 样本以 16 位整数保存，只在交给推理时才转换为浮点。
+ *
+ * 生产者（采集回调线程）只修改 head，消费者（推理线程）只修改 tail，
+ * 读写路径均不加锁。消费者可以阻塞等待“至少 N 个新样本”，
+ * 仅当消费者正在等待且条件满足时，生产者才会短暂加锁唤醒它。
+ */
+struct audio_ring_t {
+    /**
+     * 初始化缓冲区。
+     *
+     * @param capacity 期望容量（样本数），实际容量向上取整为 2 的幂。
+     * @return 成功返回 true，失败返回 false。
+     */
+    bool init(size_t capacity);
+
+    /**
+     * 写入样本（仅限生产者线程调用）。
+     * 空间不足时丢弃放不下的样本，并计入丢弃计数。
+     *
+     * @param data 样本数据。
+     * @param n 样本数。
+     * @return 实际写入的样本数。
+     */
+    size_t write(const int16_t *data, size_t n);
+
+    /**
+     * 记录 n 个没有写入的样本（仅限生产者线程调用），例如设备 xrun 时丢失的样本。
+     * 与缓冲区满时一样记为丢样，消费者读到该位置时采样时钟跳过它们，但不计入 dropped()。
+     *
+     * @param n 丢失的样本数。
+     */
+    void skip(size_t n);
+
+    /**
+     * 阻塞等待至少 n 个可写空间（仅限生产者线程调用）。
+     * 用于不能丢弃样本的生产者（例如不限速读取文件）。
+     *
+     * @param n 需要的空间（样本数），超过容量时按容量计算。
+     * @param timeout_ms 超时时间（毫秒），超时或缓冲区关闭后返回。
+     * @return 返回时可写的样本数，可能小于 n。
+     */
+    size_t wait_space(size_t n, int timeout_ms);
+
+    /**
+     * 阻塞等待至少 n 个可读样本（仅限消费者线程调用）。
+     *
+     * @param n 需要的样本数。
+     * @param timeout_ms 超时时间（毫秒），超时或缓冲区关闭后返回。
+     * @return 返回时可读的样本数，可能小于 n。
+     */
+    size_t wait(size_t n, int timeout_ms);
+
+    /**
+     * 获取前 n 个可读样本的视图，不拷贝数据（仅限消费者线程调用）。
+     * 视图在调用 consume() 之前有效。
+     *
+     * @param n 需要的样本数，超过可读数量时截断。
+     * @return 样本视图。
+     */
+    audio_ring_view_t peek(size_t n) const;
+
+    /**
+     * 释放前 n 个已读样本（仅限消费者线程调用）。
+     *
+     * @param n 释放的样本数，超过可读数量时截断。
+     */
+    void consume(size_t n);
+
+    /**
+     * 获取当前可读样本数。
+     *
+     * @return 可读样本数。
+     */
+    size_t available() const;
+
+    /**
+     * 获取当前可写空间，不阻塞（仅限生产者线程调用）。
+     *
+     * @return 可写样本数。
+     */
+    size_t space() const;
+
+    /**
+     * 获取缓冲区容量。
+     *
+     * @return 容量（样本数）。
+     */
+    size_t capacity() const { return buf.size(); }
+
+    /**
+     * 获取因缓冲区满而被丢弃的样本总数。
+     *
+     * @return 丢弃的样本数。
+     */
+    uint64_t dropped() const { return n_dropped.load(std::memory_order_relaxed); }
+
+    /**
+     * 获取下一个可读样本的采样时钟（仅限消费者线程调用）。
+     * 采样时钟是生产者写入的累计样本序号，包括因缓冲区满被丢弃的样本，
+     * 因此丢样后仍与采集端的样本计数一致。
+     *
+     * @return 采样时钟。
+     */
+    uint64_t clock() const { return tail.load(std::memory_order_relaxed) + clock_offset; }
+
+    /**
+     * 关闭缓冲区并唤醒正在等待的消费者，之后 wait() 不再阻塞。
+     */
+    void close();
+
+    /**
+     * 提前唤醒正在 wait() 的消费者，即使样本数还不够（可在任意线程调用）。
+     * 消费者当时没有在等待时，下一次 wait() 立即返回。
+     */
+    void kick();
+
+    /**
+     * 判断缓冲区是否已关闭。
+     *
+     * @return 已关闭返回 true。
+     */
+    bool is_closed() const { return closed.load(std::memory_order_acquire); }
+
+private:
+    std::vector<int16_t> buf;                   ///< 样本存储（16 位整数）
+    size_t mask = 0;                            ///< 下标掩码（容量 - 1）
+
+    // head/tail 分别由两个线程写入，用填充隔开，避免伪共享
+    // （C++11 的 new 不保证 alignas(64) 的对齐）
+    char pad0[64];
+    std::atomic<uint64_t> head{0};              ///< 累计写入样本数，仅生产者修改
+    char pad1[64 - sizeof(std::atomic<uint64_t>)];
+    std::atomic<uint64_t> tail{0};              ///< 累计读取样本数，仅消费者修改
+    char pad2[64 - sizeof(std::atomic<uint64_t>)];
+    std::atomic<size_t>   want{0};              ///< 消费者正在等待的样本数，0 表示未等待
+    std::atomic<size_t> want_space{0};          ///< 生产者正在等待的空间，0 表示未等待
+
+    std::atomic<uint64_t> n_dropped{0};         ///< 丢弃的样本数
+
+    // 丢样记录：生产者在丢样处记下 {位置, 丢弃数}，消费者读过该位置后计入 clock_offset
+    struct gap_t {
+        uint64_t pos;                           ///< 丢样之后第一个样本在 ring 中的累计位置
+        uint64_t n;                             ///< 丢弃的样本数
+    };
+    std::vector<gap_t>    gaps;                 ///< 丢样记录队列（SPSC）
+    std::atomic<uint64_t> gap_head{0};          ///< 累计写入的丢样记录数，仅生产者修改
+    std::atomic<uint64_t> gap_tail{0};          ///< 累计读取的丢样记录数，仅消费者修改
+    uint64_t gap_carry = 0;                     ///< 记录队列满时暂存的丢弃数，并入下一条记录（仅生产者）
+    uint64_t clock_offset = 0;                  ///< 已读过的丢弃样本数（仅消费者）
+    std::atomic<bool>     closed{false};        ///< 是否已关闭
+    std::atomic<bool>     kicked{false};        ///< kick() 之后是否还没有 wait() 返回过
+
+    /**
+     * 写入一条丢样记录（仅限生产者线程调用）。
+     *
+     * @param pos 丢样之后第一个样本在 ring 中的累计位置。
+     * @param n 丢弃的样本数。
+     */
+    void add_gap(uint64_t pos, uint64_t n);
+
+    std::mutex              mtx;                ///< 仅用于阻塞等待
+    std::condition_variable cv;                 ///< 数据就绪通知
+    std::condition_variable cv_space;           ///< 空间就绪通知
+};
+
+#endif  // AUDIO_RING_H_
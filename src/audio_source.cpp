@@ -0,0 +1,245 @@
+#include "audio_source.h"
+
+#include <chrono>
+
+#include "debug.h"
+#include "rt_sched.h"
+
+/**
+ * 初始化重采样阶段，采样率相同时不做任何处理。
+ *
+ * @param rate_in 设备或文件采样率。
+ * @param rate_out 输出采样率。
+ * @param max_block 单次 emit() 的最大样本数，用于预分配缓冲区。
+ * @return 成功返回 true，失败返回 false。
+ */
+bool audio_source_t::init_resampler(int rate_in, int rate_out, size_t max_block)
+{
+    if (!resampler.init(rate_in, rate_out, max_block)) {
+        return false;
+    }
+    if (resampler.active()) {
+        resampled.resize(resampler.max_output(max_block));
+    }
+    return true;
+}
+
+/**
+ * 经过重采样阶段后把样本交给所有旁路并写入 ring，只能在生产者线程调用。
+ *
+ * @param data 设备或文件采样率下的样本。
+ * @param n 样本数。
+ * @return 写入 ring 的样本数（输出采样率下）。
+ */
+size_t audio_source_t::emit(const int16_t *data, size_t n)
+{
+    if (!resampler.active()) {
+        for (audio_tap_t *tap : taps) {
+            tap->push(data, n);
+        }
+        const size_t n_write = ring.write(data, n);
+        stamp(n);
+        return n_write;
+    }
+
+    // 块大小一般固定，只有设备返回比预期更大的块时才会重新分配
+    if (resampled.size() < resampler.max_output(n)) {
+        resampled.resize(resampler.max_output(n));
+    }
+
+    const size_t n_out = resampler.process(data, n, resampled.data());
+    for (audio_tap_t *tap : taps) {
+        tap->push(resampled.data(), n_out);
+    }
+    const size_t n_write = ring.write(resampled.data(), n_out);
+    stamp(n_out);
+    return n_write;
+}
+
+/**
+ * 在采集线程中调用，按需把当前线程切换到实时调度，只在第一次调用时生效。
+ */
+void audio_source_t::rt_enter()
+{
+    if (rt_entered) {
+        return;
+    }
+    rt_entered = true;
+
+    if (rt_priority > 0) {
+        rt_sched_fifo(rt_priority, name());
+    }
+}
+
+/**
+ * 记录一块样本写入时的采样时钟和时间，只能在生产者线程调用。
+ *
+ * @param n 本块样本数（输出采样率下）。
+ */
+void audio_source_t::stamp(size_t n)
+{
+    n_emitted += n;
+    if (stamp_hw_used) {
+        return;
+    }
+
+    const int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    stamp_store(n_emitted, now);
+}
+
+/**
+ * 记录设备丢失的样本（例如 ALSA xrun），只能在生产者线程调用。
+ * 丢失的样本不写入 ring，只记为丢样，让采样时钟跟上实际时间。
+ *
+ * @param n 设备采样率下丢失的样本数。
+ */
+void audio_source_t::skip(size_t n)
+{
+    const size_t n_out = resampler.active() ? (size_t)((uint64_t)n * resampler.rate_out / resampler.rate_in) : n;
+    ring.skip(n_out);
+    n_emitted += n_out;
+}
+
+/**
+ * 发布硬件时间戳，只能在生产者线程调用。调用之后 emit() 不再用写入时间覆盖时间戳。
+ *
+ * @param sample 时间戳对应的采样时钟（输出采样率下）。
+ * @param ns 硬件时间戳（CLOCK_MONOTONIC，纳秒）。
+ */
+void audio_source_t::stamp_hw(uint64_t sample, int64_t ns)
+{
+    stamp_hw_used = true;
+    stamp_store(sample, ns);
+}
+
+/**
+ * 通过顺序锁发布时间戳，只能在生产者线程调用。
+ *
+ * @param sample 时间戳对应的采样时钟。
+ * @param ns 时间戳（纳秒）。
+ */
+void audio_source_t::stamp_store(uint64_t sample, int64_t ns)
+{
+    // 顺序锁：消费者读到奇数或前后序号不一致时重读
+    const uint32_t seq = stamp_seq.load(std::memory_order_relaxed);
+    stamp_seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    stamp_sample.store(sample, std::memory_order_relaxed);
+    stamp_ns.store(ns, std::memory_order_relaxed);
+    stamp_seq.store(seq + 2, std::memory_order_release);
+}
+
+/**
+ * 获取最近一块样本的采集时间戳，可与 ring.clock() 一起把任意样本位置换算成采集时刻。
+ * 默认实现是 emit() 写入该块时的时间；支持硬件时间戳的音频源（ALSA）返回硬件时间。
+ *
+ * @param sample 时间戳对应的采样时钟（输出采样率下的累计样本位置）。
+ * @param ns 时间戳（CLOCK_MONOTONIC，纳秒）。
+ * @return 已有数据时返回 true。
+ */
+bool audio_source_t::timestamp(uint64_t &sample, int64_t &ns) const
+{
+    uint32_t seq0, seq1;
+    do {
+        seq0   = stamp_seq.load(std::memory_order_acquire);
+        sample = stamp_sample.load(std::memory_order_relaxed);
+        ns     = stamp_ns.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        seq1   = stamp_seq.load(std::memory_order_relaxed);
+    } while ((seq0 & 1) || seq0 != seq1);
+
+    return seq0 != 0;
+}
+
+/**
+ * 根据参数创建并初始化音频源。
+ *
+ * @param params 音频源参数。
+ * @return 成功返回音频源指针（由调用者 delete），失败返回 nullptr。
+ */
+audio_source_t *audio_source_create(const audio_source_params_t &params)
+{
+    audio_source_t *source = nullptr;
+
+    switch (params.type) {
+        case AUDIO_SOURCE_SDL:
+#ifdef WHISPER_FUZZY_SDL2
+            source = audio_source_sdl_create(params);
+#else
+            LOG_ERR("built without SDL2 support");
+#endif
+            break;
+        case AUDIO_SOURCE_ALSA:
+#ifdef WHISPER_FUZZY_ALSA
+            source = audio_source_alsa_create(params);
+#else
+            LOG_ERR("built without ALSA support");
+#endif
+            break;
+        case AUDIO_SOURCE_WAV:
+        case AUDIO_SOURCE_S16:
+        case AUDIO_SOURCE_F32:
+            source = audio_source_file_create(params);
+            break;
+    }
+
+    if (!source) {
+        LOG_ERR("fail to create audio source, type: %d", params.type);
+        return nullptr;
+    }
+
+    source->set_rt_priority(params.rt_priority);
+
+    LOG_INFO("audio source: %s", source->name());
+
+    return source;
+}
+
+/**
+ * 解析采集后端名称。
+ *
+ * @param name 后端名称：sdl 或 alsa。
+ * @param type 输出的音频源类型。
+ * @return 成功返回 true，未知或未编译的后端返回 false。
+ */
+bool audio_source_backend_parse(const std::string &name, audio_source_type_t &type)
+{
+    (void) name;
+    (void) type;
+
+#ifdef WHISPER_FUZZY_SDL2
+    if (name == "sdl") {
+        type = AUDIO_SOURCE_SDL;
+        return true;
+    }
+#endif
+#ifdef WHISPER_FUZZY_ALSA
+    if (name == "alsa") {
+        type = AUDIO_SOURCE_ALSA;
+        return true;
+    }
+#endif
+    return false;
+}
+
+/**
+ * 解析音频文件格式名称。
+ *
+ * @param name 格式名称：wav、s16 或 f32。
+ * @param type 输出的音频源类型。
+ * @return 成功返回 true，未知格式返回 false。
+ */
+bool audio_source_type_parse(const std::string &name, audio_source_type_t &type)
+{
+    if (name == "wav") {
+        type = AUDIO_SOURCE_WAV;
+    } else if (name == "s16") {
+        type = AUDIO_SOURCE_S16;
+    } else if (name == "f32") {
+        type = AUDIO_SOURCE_F32;
+    } else {
+        return false;
+    }
+    return true;
+}
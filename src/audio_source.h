@@ -0,0 +1,240 @@
+#ifndef AUDIO_SOURCE_H_
+#define AUDIO_SOURCE_H_
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "audio_ring.h"
+#include "audio_tap.h"
+#include "resampler.h"
+
+/**
+ * 音频源类型。
+ */
+typedef enum {
+    AUDIO_SOURCE_SDL = 0,   ///< SDL 麦克风采集
+    AUDIO_SOURCE_WAV,       ///< WAV 文件
+    AUDIO_SOURCE_S16,       ///< 裸 PCM，16 位有符号整数
+    AUDIO_SOURCE_F32,       ///< 裸 PCM，32 位浮点
+    AUDIO_SOURCE_ALSA,      ///< ALSA mmap 直接采集
+} audio_source_type_t;
+
+/**
+ * 音频源创建参数。
+ */
+struct audio_source_params_t {
+    audio_source_type_t type = AUDIO_SOURCE_SDL;    ///< 音频源类型
+    int capture_id   = -1;                          ///< SDL 采集设备 ID，-1 表示默认设备
+    std::string device;                             ///< ALSA 设备名，空表示 "default"
+    int period_ms    = 10;                          ///< ALSA 周期长度（毫秒）
+    int buffer_ms    = 80;                          ///< ALSA 缓冲区长度（毫秒）
+    int sample_rate  = 16000;                       ///< 输出采样率
+    int capture_rate = 0;                           ///< 设备/文件采样率，0 表示设备原生采样率或 WAV 文件头
+    size_t ring_samples = 0;                        ///< 环形缓冲区容量（样本数）
+    std::string path;                               ///< 文件路径，"-" 表示标准输入
+    bool paced       = true;                        ///< 文件源是否按实时速度输出
+    int rt_priority  = 0;                           ///< 采集线程的 SCHED_FIFO 优先级，0 表示不切换
+};
+
+/**
+ * 音频源接口。
+ *
+ * 每个音频源拥有一个 SPSC 环形缓冲区 ring，自身（采集回调或读取线程）是唯一生产者，
+ * 流处理循环是唯一消费者。文件类音频源读到结尾后关闭 ring，消费者据此结束处理。
+ *
+ * 设备或文件采样率与输出采样率不同时，生产者通过 emit() 先经过重采样阶段再写入 ring。
+ * emit() 同时把同一块样本交给所有旁路（录音、存档），每个样本只交付一次。
+ */
+struct audio_source_t {
+    audio_ring_t ring;                  ///< 样本环形缓冲区
+
+    virtual ~audio_source_t() {}
+
+    /**
+     * 开始输出音频。
+     *
+     * @return 成功返回 true，失败返回 false。
+     */
+    virtual bool resume() = 0;
+
+    /**
+     * 暂停输出音频。
+     *
+     * @return 成功返回 true，失败返回 false。
+     */
+    virtual bool pause() = 0;
+
+    /**
+     * 是否按实时速度产生音频。
+     * 非实时的音频源（不限速读取文件）积压样本是正常现象，不应被当作处理不过来而丢弃。
+     *
+     * @return 实时音频源返回 true。
+     */
+    virtual bool realtime() const { return true; }
+
+    /**
+     * 获取最近一块样本的采集时间戳，可与 ring.clock() 一起把任意样本位置换算成采集时刻。
+     * 默认实现是 emit() 写入该块时的时间；支持硬件时间戳的音频源（ALSA）返回硬件时间。
+     *
+     * @param sample 时间戳对应的采样时钟（输出采样率下的累计样本位置）。
+     * @param ns 时间戳（CLOCK_MONOTONIC，纳秒）。
+     * @return 已有数据时返回 true。
+     */
+    virtual bool timestamp(uint64_t &sample, int64_t &ns) const;
+
+    /**
+     * 获取音频源名称，用于日志。
+     *
+     * @return 名称字符串。
+     */
+    virtual const char *name() const = 0;
+
+    /**
+     * 获取重采样阶段，用于输出耗时统计。
+     *
+     * @return 需要重采样时返回重采样器，否则返回 nullptr。
+     */
+    const resampler_t *resample_stage() const { return resampler.active() ? &resampler : nullptr; }
+
+    /**
+     * 添加采集数据旁路，必须在 resume() 之前调用。
+     *
+     * @param tap 旁路，生命周期必须长于音频源。
+     */
+    void add_tap(audio_tap_t *tap) { taps.push_back(tap); }
+
+    /**
+     * 设置采集线程的实时优先级，必须在 resume() 之前调用。
+     * 采集线程在第一次产生数据前切换到 SCHED_FIFO，文件音频源忽略该设置。
+     *
+     * @param priority SCHED_FIFO 优先级，0 表示不切换。
+     */
+    void set_rt_priority(int priority) { rt_priority = priority; }
+
+protected:
+    /**
+     * 初始化重采样阶段，采样率相同时不做任何处理。
+     *
+     * @param rate_in 设备或文件采样率。
+     * @param rate_out 输出采样率。
+     * @param max_block 单次 emit() 的最大样本数，用于预分配缓冲区。
+     * @return 成功返回 true，失败返回 false。
+     */
+    bool init_resampler(int rate_in, int rate_out, size_t max_block);
+
+    /**
+     * 经过重采样阶段后把样本交给所有旁路并写入 ring，只能在生产者线程调用。
+     *
+     * @param data 设备或文件采样率下的样本。
+     * @param n 样本数。
+     * @return 写入 ring 的样本数（输出采样率下）。
+     */
+    size_t emit(const int16_t *data, size_t n);
+
+    /**
+     * 记录设备丢失的样本（例如 ALSA xrun），只能在生产者线程调用。
+     * 丢失的样本不写入 ring，只记为丢样，让采样时钟跟上实际时间。
+     *
+     * @param n 设备采样率下丢失的样本数。
+     */
+    void skip(size_t n);
+
+    /**
+     * 发布硬件时间戳，只能在生产者线程调用。调用之后 emit() 不再用写入时间覆盖时间戳。
+     *
+     * @param sample 时间戳对应的采样时钟（输出采样率下）。
+     * @param ns 硬件时间戳（CLOCK_MONOTONIC，纳秒）。
+     */
+    void stamp_hw(uint64_t sample, int64_t ns);
+
+    /**
+     * 在采集线程中调用，按需把当前线程切换到实时调度，只在第一次调用时生效。
+     */
+    void rt_enter();
+
+    resampler_t resampler;              ///< 重采样阶段
+    std::vector<int16_t> resampled;     ///< 重采样输出缓冲
+    std::vector<audio_tap_t *> taps;    ///< 采集数据旁路
+
+private:
+    /**
+     * 记录一块样本写入时的采样时钟和时间，只能在生产者线程调用。
+     *
+     * @param n 本块样本数（输出采样率下）。
+     */
+    void stamp(size_t n);
+
+    /**
+     * 通过顺序锁发布时间戳，只能在生产者线程调用。
+     *
+     * @param sample 时间戳对应的采样时钟。
+     * @param ns 时间戳（纳秒）。
+     */
+    void stamp_store(uint64_t sample, int64_t ns);
+
+    int  rt_priority = 0;                       ///< 采集线程的 SCHED_FIFO 优先级，0 表示不切换
+    bool rt_entered = false;                    ///< 采集线程是否已处理过实时调度，仅生产者修改
+    uint64_t n_emitted = 0;                     ///< 已输出的样本数（包括 ring 丢弃的），仅生产者修改
+    bool stamp_hw_used = false;                 ///< 是否已发布过硬件时间戳，仅生产者修改
+    std::atomic<uint32_t> stamp_seq{0};         ///< 时间戳顺序锁，奇数表示正在更新
+    std::atomic<uint64_t> stamp_sample{0};      ///< 最近一块末尾的采样时钟
+    std::atomic<int64_t>  stamp_ns{0};          ///< 最近一块写入时的时间（纳秒）
+};
+
+/**
+ * 未指定采集采样率时向设备请求的采样率，大多数 USB 麦克风原生支持 48 kHz。
+ */
+#define AUDIO_SOURCE_NATIVE_RATE 48000
+
+/**
+ * 根据参数创建并初始化音频源。
+ *
+ * @param params 音频源参数。
+ * @return 成功返回音频源指针（由调用者 delete），失败返回 nullptr。
+ */
+audio_source_t *audio_source_create(const audio_source_params_t &params);
+
+/**
+ * 创建 SDL 麦克风音频源。
+ *
+ * @param params 音频源参数。
+ * @return 成功返回音频源指针，失败返回 nullptr。
+ */
+audio_source_t *audio_source_sdl_create(const audio_source_params_t &params);
+
+/**
+ * 创建 ALSA mmap 采集音频源。
+ *
+ * @param params 音频源参数。
+ * @return 成功返回音频源指针，失败返回 nullptr。
+ */
+audio_source_t *audio_source_alsa_create(const audio_source_params_t &params);
+
+/**
+ * 创建文件音频源（WAV、裸 s16/f32 PCM，或标准输入）。
+ *
+ * @param params 音频源参数。
+ * @return 成功返回音频源指针，失败返回 nullptr。
+ */
+audio_source_t *audio_source_file_create(const audio_source_params_t &params);
+
+/**
+ * 解析采集后端名称。
+ *
+ * @param name 后端名称：sdl 或 alsa。
+ * @param type 输出的音频源类型。
+ * @return 成功返回 true，未知或未编译的后端返回 false。
+ */
+bool audio_source_backend_parse(const std::string &name, audio_source_type_t &type);
+
+/**
+ * 解析音频文件格式名称。
+ *
+ * @param name 格式名称：wav、s16 或 f32。
+ * @param type 输出的音频源类型。
+ * @return 成功返回 true，未知格式返回 false。
+ */
+bool audio_source_type_parse(const std::string &name, audio_source_type_t &type);
+
+#endif  // AUDIO_SOURCE_H_
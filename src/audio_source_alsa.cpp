@@ -0,0 +1,414 @@
+#ifdef WHISPER_FUZZY_ALSA
+
+#include "audio_source.h"
+
+#include <alsa/asoundlib.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "debug.h"
+
+/**
+ * 基于 ALSA mmap 的采集音频源。
+ *
+ * 直接在驱动的 mmap 周期缓冲区上读取样本写入 ring，绕过 SDL 的额外缓冲和回调线程，
+ * 周期和缓冲区大小可配置，并记录每个周期的硬件时间戳。
+ */
+struct audio_source_alsa_t : audio_source_t {
+    /**
+     * 打开 ALSA 设备并配置硬件/软件参数。
+     *
+     * @param params 音频源参数。
+     * @return 成功返回 true，失败返回 false。
+     */
+    bool init(const audio_source_params_t &params);
+
+    bool resume() override;
+    bool pause() override;
+    const char *name() const override { return "alsa"; }
+
+    ~audio_source_alsa_t();
+
+private:
+    /**
+     * 采集线程主循环。
+     */
+    void run();
+
+    /**
+     * 处理 xrun 等错误并重新开始采集，把估计丢失的帧记为 ring 的丢样。
+     *
+     * @param err ALSA 错误码。
+     * @return 恢复成功返回 true。
+     */
+    bool recover(int err);
+
+    snd_pcm_t *pcm = nullptr;               ///< PCM 设备句柄
+    unsigned int channels = 1;              ///< 实际声道数，多声道时混为单声道
+    unsigned int device_rate = 0;           ///< 实际采样率
+    snd_pcm_uframes_t period_size = 0;      ///< 周期大小（帧）
+    snd_pcm_uframes_t buffer_size = 0;      ///< 缓冲区大小（帧）
+
+    uint64_t n_captured = 0;                ///< 已采集的设备帧数
+    std::vector<int16_t> mix;               ///< 多声道混音缓冲
+
+    std::thread worker;                     ///< 采集线程
+    std::atomic<bool> running{false};       ///< 采集线程是否运行
+};
+
+/**
+ * 打开 ALSA 设备并配置硬件/软件参数。
+ *
+ * @param params 音频源参数。
+ * @return 成功返回 true，失败返回 false。
+ */
+bool audio_source_alsa_t::init(const audio_source_params_t &params)
+{
+    if (!ring.init(params.ring_samples)) {
+        LOG_ERR("fail to init ring, samples: %zu", params.ring_samples);
+        return false;
+    }
+
+    const char *device = params.device.empty() ? "default" : params.device.c_str();
+
+    int err = snd_pcm_open(&pcm, device, SND_PCM_STREAM_CAPTURE, 0);
+    if (err < 0) {
+        LOG_ERR("fail to open alsa device %s: %s", device, snd_strerror(err));
+        pcm = nullptr;
+        return false;
+    }
+
+    snd_pcm_hw_params_t *hw = nullptr;
+    snd_pcm_sw_params_t *sw = nullptr;
+    unsigned int rate = params.capture_rate > 0 ? params.capture_rate : AUDIO_SOURCE_NATIVE_RATE;
+    bool ok = false;
+
+    do {
+        if ((err = snd_pcm_hw_params_malloc(&hw)) < 0 ||
+            (err = snd_pcm_hw_params_any(pcm, hw)) < 0) {
+            LOG_ERR("fail to init hw params: %s", snd_strerror(err));
+            break;
+        }
+
+        if ((err = snd_pcm_hw_params_set_access(pcm, hw, SND_PCM_ACCESS_MMAP_INTERLEAVED)) < 0) {
+            LOG_ERR("device %s does not support mmap access: %s", device, snd_strerror(err));
+            break;
+        }
+
+        if ((err = snd_pcm_hw_params_set_format(pcm, hw, SND_PCM_FORMAT_S16_LE)) < 0) {
+            LOG_ERR("device %s does not support S16_LE: %s", device, snd_strerror(err));
+            break;
+        }
+
+        if ((err = snd_pcm_hw_params_set_channels_near(pcm, hw, &channels)) < 0) {
+            LOG_ERR("fail to set channels: %s", snd_strerror(err));
+            break;
+        }
+
+        if ((err = snd_pcm_hw_params_set_rate_near(pcm, hw, &rate, nullptr)) < 0) {
+            LOG_ERR("fail to set rate: %s", snd_strerror(err));
+            break;
+        }
+
+        period_size = (snd_pcm_uframes_t)params.period_ms * rate / 1000;
+        buffer_size = (snd_pcm_uframes_t)params.buffer_ms * rate / 1000;
+
+        if ((err = snd_pcm_hw_params_set_period_size_near(pcm, hw, &period_size, nullptr)) < 0 ||
+            (err = snd_pcm_hw_params_set_buffer_size_near(pcm, hw, &buffer_size)) < 0) {
+            LOG_ERR("fail to set period/buffer size: %s", snd_strerror(err));
+            break;
+        }
+
+        if ((err = snd_pcm_hw_params(pcm, hw)) < 0) {
+            LOG_ERR("fail to apply hw params: %s", snd_strerror(err));
+            break;
+        }
+
+        if ((err = snd_pcm_sw_params_malloc(&sw)) < 0 ||
+            (err = snd_pcm_sw_params_current(pcm, sw)) < 0 ||
+            (err = snd_pcm_sw_params_set_avail_min(pcm, sw, period_size)) < 0 ||
+            (err = snd_pcm_sw_params_set_tstamp_mode(pcm, sw, SND_PCM_TSTAMP_ENABLE)) < 0 ||
+            (err = snd_pcm_sw_params_set_tstamp_type(pcm, sw, SND_PCM_TSTAMP_TYPE_MONOTONIC)) < 0 ||
+            (err = snd_pcm_sw_params(pcm, sw)) < 0) {
+            LOG_ERR("fail to apply sw params: %s", snd_strerror(err));
+            break;
+        }
+
+        if ((err = snd_pcm_prepare(pcm)) < 0) {
+            LOG_ERR("fail to prepare: %s", snd_strerror(err));
+            break;
+        }
+
+        ok = true;
+    } while (0);
+
+    if (hw) {
+        snd_pcm_hw_params_free(hw);
+    }
+    if (sw) {
+        snd_pcm_sw_params_free(sw);
+    }
+
+    if (!ok) {
+        snd_pcm_close(pcm);
+        pcm = nullptr;
+        return false;
+    }
+
+    device_rate = rate;
+    mix.resize(buffer_size);
+
+    // 设备采样率与输出不同时由内置重采样器转换，不依赖 plug 插件
+    if (!init_resampler(rate, params.sample_rate, buffer_size)) {
+        snd_pcm_close(pcm);
+        pcm = nullptr;
+        return false;
+    }
+
+    LOG_INFO("alsa capture device %s:", device);
+    LOG_INFO("    - sample rate:       %u", rate);
+    LOG_INFO("    - channels:          %u", channels);
+    LOG_INFO("    - period:            %lu frames (%.1f ms)", (unsigned long)period_size, 1000.0 * period_size / rate);
+    LOG_INFO("    - buffer:            %lu frames (%.1f ms)", (unsigned long)buffer_size, 1000.0 * buffer_size / rate);
+    LOG_INFO("    - ring capacity:     %zu", ring.capacity());
+    LOG_INFO("    - resampling:        %s", resampler.active() ? "polyphase" : "none");
+
+    return true;
+}
+
+/**
+ * 开始采集。
+ *
+ * @return 成功返回 true，失败返回 false。
+ */
+bool audio_source_alsa_t::resume()
+{
+    if (!pcm) {
+        LOG_ERR("no audio device to resume!");
+        return false;
+    }
+
+    if (running) {
+        LOG_ERR("already running!");
+        return false;
+    }
+
+    int err = snd_pcm_start(pcm);
+    if (err < 0) {
+        LOG_ERR("fail to start capture: %s", snd_strerror(err));
+        return false;
+    }
+
+    running = true;
+    worker = std::thread(&audio_source_alsa_t::run, this);
+
+    return true;
+}
+
+/**
+ * 暂停采集。
+ *
+ * @return 成功返回 true，失败返回 false。
+ */
+bool audio_source_alsa_t::pause()
+{
+    if (!running) {
+        LOG_ERR("already paused!");
+        return false;
+    }
+
+    running = false;
+    if (worker.joinable()) {
+        worker.join();
+    }
+
+    snd_pcm_drop(pcm);
+    snd_pcm_prepare(pcm);
+
+    return true;
+}
+
+audio_source_alsa_t::~audio_source_alsa_t()
+{
+    running = false;
+    if (worker.joinable()) {
+        worker.join();
+    }
+    ring.close();
+
+    if (pcm) {
+        snd_pcm_drop(pcm);
+        snd_pcm_close(pcm);
+        pcm = nullptr;
+    }
+}
+
+/**
+ * 获取 ALSA 时间戳的纳秒数。
+ *
+ * @param ts 时间戳。
+ * @return 纳秒。
+ */
+static int64_t audio_source_alsa_ns(const snd_htimestamp_t &ts)
+{
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/**
+ * 处理 xrun 等错误并重新开始采集，把估计丢失的帧记为 ring 的丢样。
+ *
+ * @param err ALSA 错误码。
+ * @return 恢复成功返回 true。
+ */
+bool audio_source_alsa_t::recover(int err)
+{
+    LOG_ERR("alsa capture error: %s, recovering", snd_strerror(err));
+
+    // 丢失的帧 = 停止时 hw 指针领先已读位置的帧（prepare 时丢弃）+ 停止到重新开始之间的帧。
+    // xrun/挂起时停止时刻是状态的触发时间戳，其余错误按当前时间计
+    snd_pcm_status_t *status = nullptr;
+    snd_pcm_status_alloca(&status);
+
+    snd_pcm_uframes_t n_lost = 0;
+    int64_t stop_ns = -1;
+    if (snd_pcm_status(pcm, status) == 0) {
+        snd_htimestamp_t ts;
+        const snd_pcm_state_t state = snd_pcm_status_get_state(status);
+        if (state == SND_PCM_STATE_XRUN || state == SND_PCM_STATE_SUSPENDED) {
+            snd_pcm_status_get_trigger_htstamp(status, &ts);
+        } else {
+            snd_pcm_status_get_htstamp(status, &ts);
+        }
+        n_lost  = std::min(snd_pcm_status_get_avail(status), buffer_size);
+        stop_ns = audio_source_alsa_ns(ts);
+    }
+
+    err = snd_pcm_recover(pcm, err, 1);
+    if (err < 0) {
+        LOG_ERR("fail to recover: %s", snd_strerror(err));
+        return false;
+    }
+
+    err = snd_pcm_start(pcm);
+    if (err < 0) {
+        LOG_ERR("fail to restart capture: %s", snd_strerror(err));
+        return false;
+    }
+
+    if (stop_ns > 0 && snd_pcm_status(pcm, status) == 0) {
+        snd_htimestamp_t ts;
+        snd_pcm_status_get_trigger_htstamp(status, &ts);
+        const int64_t start_ns = audio_source_alsa_ns(ts);
+        if (start_ns > stop_ns) {
+            n_lost += (snd_pcm_uframes_t)((start_ns - stop_ns) * device_rate / 1000000000);
+        }
+    }
+
+    // 不记下丢失的帧，采样时钟会一直落后于实际时间
+    if (n_lost > 0) {
+        LOG_ERR("alsa capture lost about %lu frames (%.1f ms)", (unsigned long)n_lost, 1000.0 * n_lost / device_rate);
+        n_captured += n_lost;
+        skip(n_lost);
+    }
+    return true;
+}
+
+/**
+ * 采集线程主循环。
+ */
+void audio_source_alsa_t::run()
+{
+    rt_enter();
+
+    while (running) {
+        int err = snd_pcm_wait(pcm, 100);
+        if (err == 0) {
+            continue;
+        }
+        if (err < 0 && !recover(err)) {
+            break;
+        }
+
+        snd_pcm_sframes_t avail = snd_pcm_avail_update(pcm);
+        if (avail < 0) {
+            if (!recover((int)avail)) {
+                break;
+            }
+            continue;
+        }
+
+        while (avail >= (snd_pcm_sframes_t)period_size) {
+            const snd_pcm_channel_area_t *areas = nullptr;
+            snd_pcm_uframes_t offset = 0;
+            snd_pcm_uframes_t frames = (snd_pcm_uframes_t)avail;
+
+            err = snd_pcm_mmap_begin(pcm, &areas, &offset, &frames);
+            if (err < 0) {
+                recover(err);
+                break;
+            }
+
+            // 交错格式：所有声道共用 areas[0]，step 是一帧的位数
+            const uint8_t *base = (const uint8_t *)areas[0].addr + areas[0].first / 8 + offset * areas[0].step / 8;
+            const size_t frame_bytes = areas[0].step / 8;
+
+            if (channels == 1) {
+                // 单声道无需混音，在 commit 归还缓冲区之前直接从 mmap 区域写出
+                emit((const int16_t *)base, frames);
+            } else {
+                frames = std::min<snd_pcm_uframes_t>(frames, mix.size());
+                for (snd_pcm_uframes_t i = 0; i < frames; i++) {
+                    const int16_t *p = (const int16_t *)(base + i * frame_bytes);
+                    int sum = 0;
+                    for (unsigned int c = 0; c < channels; c++) {
+                        sum += p[c];
+                    }
+                    mix[i] = (int16_t)(sum / (int)channels);
+                }
+                emit(mix.data(), frames);
+            }
+            n_captured += frames;
+
+            const snd_pcm_sframes_t committed = snd_pcm_mmap_commit(pcm, offset, frames);
+            if (committed < 0 || (snd_pcm_uframes_t)committed != frames) {
+                recover(committed < 0 ? (int)committed : -EPIPE);
+                break;
+            }
+
+            avail -= frames;
+        }
+
+        // 硬件时间戳对应 hw 指针位置，即已读样本数加上仍在缓冲区中的样本数
+        snd_pcm_uframes_t ts_avail = 0;
+        snd_htimestamp_t tstamp;
+        if (snd_pcm_htimestamp(pcm, &ts_avail, &tstamp) == 0) {
+            // 换算成输出采样率下的样本位置，与 ring 中的样本计数一致
+            const uint64_t sample = n_captured + ts_avail;
+            stamp_hw(resampler.active() ? sample * resampler.rate_out / resampler.rate_in : sample,
+                audio_source_alsa_ns(tstamp));
+        }
+    }
+}
+
+/**
+ * 创建 ALSA 采集音频源。
+ *
+ * @param params 音频源参数。
+ * @return 成功返回音频源指针，失败返回 nullptr。
+ */
+audio_source_t *audio_source_alsa_create(const audio_source_params_t &params)
+{
+    audio_source_alsa_t *source = new audio_source_alsa_t;
+    if (!source->init(params)) {
+        delete source;
+        return nullptr;
+    }
+    return source;
+}
+
+#endif  // WHISPER_FUZZY_ALSA
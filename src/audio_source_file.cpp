@@ -0,0 +1,251 @@
+#include "audio_source.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "pcm_convert.h"
+#include "wav_file.h"
+#include "debug.h"
+
+static const size_t file_block_frames = 1024;   ///< 每次读取的帧数
+
+/**
+ * 文件音频源：WAV、裸 s16/f32 PCM 或标准输入。
+ *
+ * 读取线程作为唯一生产者把样本写入 ring。
+ * paced 模式按实时速度输出，模拟麦克风；非 paced 模式在 ring 满时阻塞等待，
+ * 不丢弃任何样本，处理速度只受推理速度限制。
+ */
+struct audio_source_file_t : audio_source_t {
+    /**
+     * 打开文件并解析格式。
+     *
+     * @param params 音频源参数。
+     * @return 成功返回 true，失败返回 false。
+     */
+    bool init(const audio_source_params_t &params);
+
+    bool resume() override;
+    bool pause() override;
+    bool realtime() const override { return paced; }
+    const char *name() const override { return desc; }
+
+    ~audio_source_file_t();
+
+private:
+    /**
+     * 读取线程主循环。
+     */
+    void run();
+
+    FILE *fp = nullptr;                 ///< 输入文件
+    bool is_stdin = false;              ///< 是否为标准输入
+    bool is_float = false;              ///< 样本是否为 32 位浮点
+    int channels = 1;                   ///< 声道数，多声道时混为单声道
+    int sample_rate = 16000;            ///< 文件采样率
+    bool paced = true;                  ///< 是否按实时速度输出
+    uint64_t n_bytes_left = UINT64_MAX; ///< 剩余数据字节数
+
+    uint64_t n_sent = 0;                ///< 已输出的样本数
+    std::thread worker;                 ///< 读取线程
+    std::atomic<bool> running{false};   ///< 读取线程是否运行
+    char desc[64] = "file";             ///< 音频源描述
+};
+
+/**
+ * 打开文件并解析格式。
+ *
+ * @param params 音频源参数。
+ * @return 成功返回 true，失败返回 false。
+ */
+bool audio_source_file_t::init(const audio_source_params_t &params)
+{
+    if (!ring.init(params.ring_samples)) {
+        LOG_ERR("fail to init ring, samples: %zu", params.ring_samples);
+        return false;
+    }
+
+    paced = params.paced;
+    sample_rate = params.capture_rate > 0 ? params.capture_rate : params.sample_rate;
+
+    is_stdin = params.path == "-";
+    fp = is_stdin ? stdin : fopen(params.path.c_str(), "rb");
+    if (!fp) {
+        LOG_ERR("fail to open %s", params.path.c_str());
+        return false;
+    }
+
+    const char *fmt = "s16";
+    if (params.type == AUDIO_SOURCE_WAV) {
+        wav_header_t hdr;
+        if (!wav_read_header(fp, hdr)) {
+            LOG_ERR("fail to read wav header: %s", params.path.c_str());
+            return false;
+        }
+        sample_rate = hdr.sample_rate;
+        is_float = hdr.format == WAV_FORMAT_FLOAT;
+        channels = hdr.channels;
+        n_bytes_left = hdr.data_size;
+        fmt = "wav";
+    } else {
+        is_float = params.type == AUDIO_SOURCE_F32;
+        fmt = is_float ? "f32" : "s16";
+    }
+
+    if (!init_resampler(sample_rate, params.sample_rate, file_block_frames)) {
+        return false;
+    }
+
+    snprintf(desc, sizeof(desc), "%s %s (%s)", fmt, is_stdin ? "stdin" : "file", paced ? "paced" : "unpaced");
+
+    LOG_INFO("input %s: %s, %d Hz, %d channels, %s",
+        params.path.c_str(), fmt, sample_rate, channels, is_float ? "f32" : "s16");
+
+    return true;
+}
+
+/**
+ * 开始输出音频。
+ *
+ * @return 成功返回 true，失败返回 false。
+ */
+bool audio_source_file_t::resume()
+{
+    if (running) {
+        LOG_ERR("already running!");
+        return false;
+    }
+
+    running = true;
+    worker = std::thread(&audio_source_file_t::run, this);
+
+    return true;
+}
+
+/**
+ * 暂停输出音频。
+ *
+ * @return 成功返回 true，失败返回 false。
+ */
+bool audio_source_file_t::pause()
+{
+    if (!running) {
+        LOG_ERR("already paused!");
+        return false;
+    }
+
+    running = false;
+    if (worker.joinable()) {
+        worker.join();
+    }
+
+    return true;
+}
+
+audio_source_file_t::~audio_source_file_t()
+{
+    running = false;
+    ring.close();
+    if (worker.joinable()) {
+        worker.join();
+    }
+
+    if (fp && !is_stdin) {
+        fclose(fp);
+    }
+    fp = nullptr;
+}
+
+/**
+ * 读取线程主循环。
+ */
+void audio_source_file_t::run()
+{
+    const size_t n_block      = file_block_frames;
+    const size_t sample_bytes = is_float ? sizeof(float) : sizeof(int16_t);
+    const size_t frame_bytes  = sample_bytes * channels;
+
+    std::vector<uint8_t> raw(n_block * frame_bytes);
+    std::vector<float>   mix(n_block);
+    std::vector<int16_t> pcm(n_block);
+
+    // 以已输出样本数换算时间基准，暂停后恢复时不会补发积压的音频
+    const auto t_base = std::chrono::steady_clock::now() -
+        std::chrono::microseconds(n_sent * 1000000 / sample_rate);
+
+    while (running) {
+        const size_t n_want = (size_t)std::min<uint64_t>(n_block, n_bytes_left / frame_bytes);
+        const size_t n = n_want ? fread(raw.data(), frame_bytes, n_want, fp) : 0;
+        if (n == 0) {
+            LOG_INFO("end of input after %.1f sec", (double)n_sent / sample_rate);
+            ring.close();
+            break;
+        }
+        if (n_bytes_left != UINT64_MAX) {
+            n_bytes_left -= n * frame_bytes;
+        }
+
+        if (!is_float && channels == 1) {
+            // 单声道 s16 与 ring 中的格式相同，直接拷贝
+            memcpy(pcm.data(), raw.data(), n * sizeof(int16_t));
+        } else if (!is_float) {
+            for (size_t i = 0; i < n; i++) {
+                int32_t sum = 0;
+                for (int c = 0; c < channels; c++) {
+                    int16_t v;
+                    memcpy(&v, raw.data() + i * frame_bytes + c * sample_bytes, sizeof(v));
+                    sum += v;
+                }
+                pcm[i] = (int16_t)(sum / channels);
+            }
+        } else {
+            for (size_t i = 0; i < n; i++) {
+                float sum = 0.0f;
+                for (int c = 0; c < channels; c++) {
+                    float v;
+                    memcpy(&v, raw.data() + i * frame_bytes + c * sample_bytes, sizeof(v));
+                    sum += v;
+                }
+                mix[i] = sum / channels;
+            }
+            pcm_f32_to_s16(mix.data(), pcm.data(), n);
+        }
+
+        if (paced) {
+            // 与真实设备一致：一块音频在其最后一个样本的时刻才可用
+            std::this_thread::sleep_until(t_base + std::chrono::microseconds((n_sent + n) * 1000000 / sample_rate));
+        } else {
+            const size_t n_out = resampler.active() ? resampler.max_output(n) : n;
+            while (running && !ring.is_closed() && ring.wait_space(n_out, 100) < n_out) {
+            }
+        }
+
+        if (!running || ring.is_closed()) {
+            break;
+        }
+
+        emit(pcm.data(), n);
+        n_sent += n;
+    }
+}
+
+/**
+ * 创建文件音频源（WAV、裸 s16/f32 PCM，或标准输入）。
+ *
+ * @param params 音频源参数。
+ * @return 成功返回音频源指针，失败返回 nullptr。
+ */
+audio_source_t *audio_source_file_create(const audio_source_params_t &params)
+{
+    audio_source_file_t *source = new audio_source_file_t;
+    if (!source->init(params)) {
+        delete source;
+        return nullptr;
+    }
+    return source;
+}
@@ -0,0 +1,217 @@
+#ifdef WHISPER_FUZZY_SDL2
+
+#include "audio_source.h"
+
+#include <SDL.h>
+
+#include <atomic>
+
+#include "debug.h"
+
+/**
+ * 基于 SDL 的麦克风音频源。
+ *
+ * SDL 采集回调作为唯一生产者把样本写入无锁环形缓冲区 ring，
+ * 推理线程作为唯一消费者通过 ring.wait() 阻塞等待新样本。
+ */
+struct audio_source_sdl_t : audio_source_t {
+    /**
+     * 初始化 SDL 并打开采集设备。
+     *
+     * @param params 音频源参数。
+     * @return 成功返回 true，失败返回 false。
+     */
+    bool init(const audio_source_params_t &params);
+
+    bool resume() override;
+    bool pause() override;
+    const char *name() const override { return "sdl"; }
+
+    ~audio_source_sdl_t();
+
+private:
+    /**
+     * SDL 采集回调，在 SDL 音频线程中执行。
+     *
+     * @param stream 采集到的数据。
+     * @param len 数据字节数。
+     */
+    void callback(uint8_t *stream, int len);
+
+    SDL_AudioDeviceID dev_id_in = 0;    ///< 采集设备句柄
+    std::atomic<bool> running{false};   ///< 是否正在采集
+};
+
+/**
+ * 初始化 SDL 并打开采集设备。
+ *
+ * @param params 音频源参数。
+ * @return 成功返回 true，失败返回 false。
+ */
+bool audio_source_sdl_t::init(const audio_source_params_t &params)
+{
+    if (!ring.init(params.ring_samples)) {
+        LOG_ERR("fail to init ring, samples: %zu", params.ring_samples);
+        return false;
+    }
+
+    SDL_LogSetPriority(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_INFO);
+
+    // SIGINT / SIGTERM 由 whisper_stream 的信号处理函数写入唤醒管道，SDL 不再把它们转为只能轮询的退出事件
+    SDL_SetHint(SDL_HINT_NO_SIGNAL_HANDLERS, "1");
+
+    if (SDL_Init(SDL_INIT_AUDIO) < 0) {
+        LOG_ERR("couldn't initialize SDL: %s", SDL_GetError());
+        return false;
+    }
+
+    SDL_SetHintWithPriority(SDL_HINT_AUDIO_RESAMPLING_MODE, "medium", SDL_HINT_OVERRIDE);
+
+    {
+        int n_devices = SDL_GetNumAudioDevices(SDL_TRUE);
+        LOG_INFO("found %d capture devices:", n_devices);
+        for (int i = 0; i < n_devices; i++) {
+            LOG_INFO("    - capture device #%d: '%s'", i, SDL_GetAudioDeviceName(i, SDL_TRUE));
+        }
+    }
+
+    SDL_AudioSpec capture_spec_requested;
+    SDL_AudioSpec capture_spec_obtained;
+
+    SDL_zero(capture_spec_requested);
+    SDL_zero(capture_spec_obtained);
+
+    // 默认按设备原生采样率采集，由内置重采样器转换到输出采样率；
+    // 显式指定与输出相同的采样率时沿用 SDL 自带的转换
+    const bool sdl_convert = params.capture_rate == params.sample_rate;
+    const int allowed_changes = sdl_convert ? 0 : SDL_AUDIO_ALLOW_FREQUENCY_CHANGE;
+
+    capture_spec_requested.freq     = params.capture_rate > 0 ? params.capture_rate : AUDIO_SOURCE_NATIVE_RATE;
+    capture_spec_requested.format   = AUDIO_S16SYS;
+    capture_spec_requested.channels = 1;
+    capture_spec_requested.samples  = 1024;
+    capture_spec_requested.callback = [](void *userdata, uint8_t *stream, int len) {
+        ((audio_source_sdl_t *)userdata)->callback(stream, len);
+    };
+    capture_spec_requested.userdata = this;
+
+    const int capture_id = params.capture_id;
+    if (capture_id >= 0) {
+        LOG_INFO("attempt to open capture device %d : '%s' ...", capture_id, SDL_GetAudioDeviceName(capture_id, SDL_TRUE));
+        dev_id_in = SDL_OpenAudioDevice(SDL_GetAudioDeviceName(capture_id, SDL_TRUE), SDL_TRUE, &capture_spec_requested, &capture_spec_obtained, allowed_changes);
+    } else {
+        LOG_INFO("attempt to open default capture device ...");
+        dev_id_in = SDL_OpenAudioDevice(nullptr, SDL_TRUE, &capture_spec_requested, &capture_spec_obtained, allowed_changes);
+    }
+
+    if (!dev_id_in) {
+        LOG_ERR("couldn't open an audio device for capture: %s!", SDL_GetError());
+        dev_id_in = 0;
+        return false;
+    }
+
+    LOG_INFO("obtained spec for input device (SDL Id = %d):", dev_id_in);
+    LOG_INFO("    - sample rate:       %d", capture_spec_obtained.freq);
+    LOG_INFO("    - format:            %d (required: %d)", capture_spec_obtained.format, capture_spec_requested.format);
+    LOG_INFO("    - channels:          %d (required: %d)", capture_spec_obtained.channels, capture_spec_requested.channels);
+    LOG_INFO("    - samples per frame: %d", capture_spec_obtained.samples);
+    LOG_INFO("    - ring capacity:     %zu", ring.capacity());
+    LOG_INFO("    - resampling:        %s", sdl_convert ? "sdl" : (capture_spec_obtained.freq == params.sample_rate ? "none" : "polyphase"));
+
+    if (!sdl_convert && !init_resampler(capture_spec_obtained.freq, params.sample_rate, capture_spec_obtained.samples)) {
+        SDL_CloseAudioDevice(dev_id_in);
+        dev_id_in = 0;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * 开始采集。
+ *
+ * @return 成功返回 true，失败返回 false。
+ */
+bool audio_source_sdl_t::resume()
+{
+    if (!dev_id_in) {
+        LOG_ERR("no audio device to resume!");
+        return false;
+    }
+
+    if (running) {
+        LOG_ERR("already running!");
+        return false;
+    }
+
+    SDL_PauseAudioDevice(dev_id_in, 0);
+    running = true;
+
+    return true;
+}
+
+/**
+ * 暂停采集。
+ *
+ * @return 成功返回 true，失败返回 false。
+ */
+bool audio_source_sdl_t::pause()
+{
+    if (!dev_id_in) {
+        LOG_ERR("no audio device to pause!");
+        return false;
+    }
+
+    if (!running) {
+        LOG_ERR("already paused!");
+        return false;
+    }
+
+    SDL_PauseAudioDevice(dev_id_in, 1);
+    running = false;
+
+    return true;
+}
+
+audio_source_sdl_t::~audio_source_sdl_t()
+{
+    if (dev_id_in) {
+        SDL_CloseAudioDevice(dev_id_in);
+        dev_id_in = 0;
+    }
+    ring.close();
+}
+
+/**
+ * SDL 采集回调，在 SDL 音频线程中执行。
+ *
+ * @param stream 采集到的数据。
+ * @param len 数据字节数。
+ */
+void audio_source_sdl_t::callback(uint8_t *stream, int len)
+{
+    if (!running) {
+        return;
+    }
+
+    rt_enter();
+    emit((const int16_t *)stream, len / sizeof(int16_t));
+}
+
+/**
+ * 创建 SDL 麦克风音频源。
+ *
+ * @param params 音频源参数。
+ * @return 成功返回音频源指针，失败返回 nullptr。
+ */
+audio_source_t *audio_source_sdl_create(const audio_source_params_t &params)
+{
+    audio_source_sdl_t *source = new audio_source_sdl_t;
+    if (!source->init(params)) {
+        delete source;
+        return nullptr;
+    }
+    return source;
+}
+
+#endif  // WHISPER_FUZZY_SDL2
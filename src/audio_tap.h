@@ -0,0 +1,26 @@
+#ifndef AUDIO_TAP_H_
+#define AUDIO_TAP_H_
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * 采集数据旁路接口（录音、存档等）。
+ *
+ * 音频源在生产者线程把每一块输出样本（重采样之后、写入 ring 之前）交给所有旁路，
+ * 每个样本只交付一次。push() 运行在采集线程中，实现必须不阻塞、不访问磁盘。
+ */
+struct audio_tap_t {
+    virtual ~audio_tap_t() {}
+
+    /**
+     * 接收一块样本（仅限采集线程调用），不阻塞。
+     *
+     * @param data 样本数据。
+     * @param n 样本数。
+     * @return 接收返回 true，因队列满而丢弃返回 false。
+     */
+    virtual bool push(const int16_t *data, size_t n) = 0;
+};
+
+#endif  // AUDIO_TAP_H_
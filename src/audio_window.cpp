@@ -0,0 +1,166 @@
+#include "audio_window.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "debug.h"
+
+#ifdef __linux__
+/**
+ * 使用 memfd 把同一块内存连续映射两次。
+ *
+ * @param bytes 单份映射的字节数，必须是页大小的整数倍。
+ * @return 成功返回映射起始地址，失败返回 nullptr。
+ */
+static void *audio_window_map_mirror(size_t bytes)
+{
+    int fd = memfd_create("audio_window", MFD_CLOEXEC);
+    if (fd < 0) {
+        return nullptr;
+    }
+
+    void *addr = MAP_FAILED;
+    if (ftruncate(fd, bytes) == 0) {
+        // 先占住 2 * bytes 的地址空间，再把文件固定映射到前后两半
+        addr = mmap(nullptr, 2 * bytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    }
+
+    if (addr != MAP_FAILED) {
+        char *p = (char *)addr;
+        if (mmap(p,         bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED ||
+            mmap(p + bytes, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED) {
+            munmap(addr, 2 * bytes);
+            addr = MAP_FAILED;
+        }
+    }
+
+    close(fd);
+
+    return addr == MAP_FAILED ? nullptr : addr;
+}
+#endif
+
+/**
+ * 分配窗口存储区，只需调用一次。
+ *
+ * @param capacity 最少容量（样本数），实际容量可能按页大小向上取整。
+ * @return 成功返回 true，失败返回 false。
+ */
+bool audio_window_t::init(size_t capacity)
+{
+    if (base || capacity == 0) {
+        LOG_ERR("bad init, base(%p), capacity(%zu)", base, capacity);
+        return false;
+    }
+
+#ifdef __linux__
+    const size_t page  = (size_t)sysconf(_SC_PAGESIZE);
+    const size_t bytes = (capacity * sizeof(int16_t) + page - 1) / page * page;
+
+    base = (int16_t *)audio_window_map_mirror(bytes);
+    if (base) {
+        map_bytes = bytes;
+        cap = bytes / sizeof(int16_t);
+    } else {
+        LOG_INFO("mirrored mapping unavailable, fallback to double writes");
+    }
+#endif
+
+    if (!base) {
+        base = (int16_t *)calloc(2 * capacity, sizeof(int16_t));
+        if (!base) {
+            LOG_ERR("fail to alloc window, capacity: %zu", capacity);
+            return false;
+        }
+        cap = capacity;
+    }
+
+    pos = 0;
+    len = 0;
+
+    return true;
+}
+
+/**
+ * 追加样本，超出容量时最旧的样本被覆盖。
+ *
+ * @param data 样本数据。
+ * @param n 样本数。
+ */
+void audio_window_t::push(const int16_t *data, size_t n)
+{
+    if (n > cap) {
+        data += n - cap;
+        n = cap;
+    }
+
+    // 镜像区保证从 pos 开始的 cap 个样本都是连续的
+    memcpy(base + pos, data, n * sizeof(int16_t));
+
+    if (!map_bytes) {
+        // 软件镜像：同步另一半
+        const size_t n_low = std::min(n, cap - pos);
+        memcpy(base + pos + cap, data, n_low * sizeof(int16_t));
+        memcpy(base, data + n_low, (n - n_low) * sizeof(int16_t));
+    }
+
+    pos = (pos + n) % cap;
+    len = std::min(len + n, cap);
+}
+
+/**
+ * 追加环形缓冲区视图中的样本。
+ *
+ * @param view 样本视图。
+ */
+void audio_window_t::push(const audio_ring_view_t &view)
+{
+    push(view.data[0], view.size[0]);
+    push(view.data[1], view.size[1]);
+}
+
+/**
+ * 获取最近 n 个样本的连续视图，在下一次 push() 之前有效。
+ *
+ * @param n 样本数，不能超过 size()。
+ * @return 指向最近 n 个样本中第一个样本的指针。
+ */
+const int16_t *audio_window_t::tail(size_t n) const
+{
+    n = std::min(n, len);
+    return base + (pos + cap - n);
+}
+
+/**
+ * 只保留最近 n 个样本。
+ *
+ * @param n 保留的样本数。
+ */
+void audio_window_t::keep(size_t n)
+{
+    len = std::min(len, n);
+}
+
+audio_window_t::~audio_window_t()
+{
+    if (!base) {
+        return;
+    }
+
+#ifdef __linux__
+    if (map_bytes) {
+        munmap(base, 2 * map_bytes);
+        base = nullptr;
+        return;
+    }
+#endif
+
+    free(base);
+    base = nullptr;
+}
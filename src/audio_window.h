@@ -0,0 +1,91 @@
+#ifndef AUDIO_WINDOW_H_
+#define AUDIO_WINDOW_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "audio_ring.h"
+
+/**
+ * 固定容量的环形分析窗口。
+ *
+ * 存储区是“镜像”的：第 i 个样本与第 i + capacity 个样本总是相同，
+ * 因此任意不超过容量的最近 n 个样本都能以一段连续内存的形式读出，
+ * 追加新样本时不需要搬移旧数据，也不需要在每次迭代时分配内存。
+ * 样本以 16 位整数保存，交给 whisper_full 前再一次性转换为浮点。
+ *
+ * Linux 下通过 memfd 把同一块物理内存映射两次实现镜像，写入只发生一次；
+ * 映射失败或其他平台下退化为双倍缓冲区，每个样本写两份。
+ */
+struct audio_window_t {
+    /**
+     * 分配窗口存储区，只需调用一次。
+     *
+     * @param capacity 最少容量（样本数），实际容量可能按页大小向上取整。
+     * @return 成功返回 true，失败返回 false。
+     */
+    bool init(size_t capacity);
+
+    /**
+     * 追加样本，超出容量时最旧的样本被覆盖。
+     *
+     * @param data 样本数据。
+     * @param n 样本数。
+     */
+    void push(const int16_t *data, size_t n);
+
+    /**
+     * 追加环形缓冲区视图中的样本。
+     *
+     * @param view 样本视图。
+     */
+    void push(const audio_ring_view_t &view);
+
+    /**
+     * 获取最近 n 个样本的连续视图，在下一次 push() 之前有效。
+     *
+     * @param n 样本数，不能超过 size()。
+     * @return 指向最近 n 个样本中第一个样本的指针。
+     */
+    const int16_t *tail(size_t n) const;
+
+    /**
+     * 只保留最近 n 个样本。
+     *
+     * @param n 保留的样本数。
+     */
+    void keep(size_t n);
+
+    /**
+     * 清空窗口。
+     */
+    void clear() { len = 0; }
+
+    /**
+     * 获取窗口中当前的样本数。
+     *
+     * @return 样本数。
+     */
+    size_t size() const { return len; }
+
+    /**
+     * 获取窗口容量。
+     *
+     * @return 容量（样本数）。
+     */
+    size_t capacity() const { return cap; }
+
+    audio_window_t() {}
+    audio_window_t(const audio_window_t &) = delete;
+    audio_window_t &operator=(const audio_window_t &) = delete;
+    ~audio_window_t();
+
+private:
+    int16_t *base = nullptr;    ///< 存储区起始地址，共 2 * cap 个样本
+    size_t cap = 0;             ///< 容量（样本数）
+    size_t pos = 0;             ///< 下一个样本的写入位置，范围 [0, cap)
+    size_t len = 0;             ///< 当前样本数
+    size_t map_bytes = 0;       ///< 双重映射时单份映射的字节数，0 表示软件镜像
+};
+
+#endif  // AUDIO_WINDOW_H_
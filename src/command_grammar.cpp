@@ -0,0 +1,192 @@
+#include "command_grammar.h"
+
+#include <algorithm>
+#include <cctype>
+#include <deque>
+#include <map>
+
+#include "debug.h"
+
+/**
+ * 命令文本前缀树的节点。
+ */
+struct command_grammar_node_t {
+    std::map<std::string, size_t> next;     ///< 下一个字符（一个 UTF-8 码点）到子节点下标，有序以便生成的语法稳定
+    bool terminal = false;                  ///< 是否有命令文本在此结束
+};
+
+/**
+ * 获取 UTF-8 码点的字节数。
+ *
+ * @param c 码点的首字节。
+ * @return 字节数，不是合法的首字节时返回 1，交给语法解析报错。
+ */
+static size_t command_grammar_utf8_len(unsigned char c)
+{
+    if (c < 0x80) {
+        return 1;
+    }
+    if ((c >> 5) == 0x06) {
+        return 2;
+    }
+    if ((c >> 4) == 0x0e) {
+        return 3;
+    }
+    if ((c >> 3) == 0x1e) {
+        return 4;
+    }
+    return 1;
+}
+
+/**
+ * 把一串字符写成 GBNF 字面量，转义引号、反斜杠和控制字符。
+ *
+ * @param str 字符串。
+ * @return 带引号的字面量。
+ */
+static std::string command_grammar_literal(const std::string &str)
+{
+    std::string out = "\"";
+    for (char c : str) {
+        switch (c) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n";  break;
+            case '\r': out += "\\r";  break;
+            case '\t': out += "\\t";  break;
+            default:   out += c;      break;
+        }
+    }
+    return out + "\"";
+}
+
+/**
+ * 生成一个分叉节点的规则：每个子节点一个候选，沿不分叉的路径合并字面量，
+ * 到达下一个分叉节点时引用它的规则，该节点本身也是命令结尾时引用可省略。
+ *
+ * @param nodes 前缀树。
+ * @param id 节点下标。
+ * @param first 是否为根节点，根节点的字母写成大小写字符类。
+ * @param pending 输出需要继续生成规则的节点下标。
+ * @return 规则文本，以换行结尾。
+ */
+static std::string command_grammar_rule(const std::vector<command_grammar_node_t> &nodes, size_t id, bool first,
+    std::deque<size_t> &pending)
+{
+    std::string rule = "cmd-" + std::to_string(id) + " ::=";
+    const char *sep = " ";
+
+    for (const auto &edge : nodes[id].next) {
+        std::string head;
+        std::string lit = edge.first;
+        if (first && lit.size() == 1 && std::isalpha((unsigned char)lit[0])) {
+            head = std::string("[") + (char)std::tolower((unsigned char)lit[0]) + (char)std::toupper((unsigned char)lit[0]) + "]";
+            lit.clear();
+        }
+
+        size_t n = edge.second;
+        while (!nodes[n].terminal && nodes[n].next.size() == 1) {
+            lit += nodes[n].next.begin()->first;
+            n = nodes[n].next.begin()->second;
+        }
+
+        std::string alt = head;
+        if (!lit.empty()) {
+            alt += (alt.empty() ? "" : " ") + command_grammar_literal(lit);
+        }
+        if (!nodes[n].next.empty()) {
+            alt += " cmd-" + std::to_string(n) + (nodes[n].terminal ? "?" : "");
+            pending.push_back(n);
+        }
+
+        rule += sep + alt;
+        sep = " | ";
+    }
+    return rule + "\n";
+}
+
+/**
+ * 由命令文本生成并解析语法。
+ *
+ * @param g 输出的语法，覆盖原有内容。
+ * @param texts 命令文本，即 config.json 中各项 "text" 的全部元素，忽略首尾空白，重复的只算一次。
+ * @return 成功返回 true，没有非空文本或语法解析失败返回 false。
+ */
+bool command_grammar_build(command_grammar_t &g, const std::vector<std::string> &texts)
+{
+    g = command_grammar_t();
+
+    std::vector<command_grammar_node_t> nodes(1);
+    for (const std::string &text : texts) {
+        const size_t start = text.find_first_not_of(" \t\n\r\f\v");
+        if (start == std::string::npos) {
+            continue;
+        }
+        const size_t end = text.find_last_not_of(" \t\n\r\f\v") + 1;
+
+        // 首字母不区分大小写，与 text_to_code() 的小写匹配一致
+        size_t n = 0;
+        for (size_t i = start; i < end; ) {
+            const size_t len = std::min(command_grammar_utf8_len((unsigned char)text[i]), end - i);
+            std::string ch = text.substr(i, len);
+            if (i == start && len == 1) {
+                ch[0] = (char)std::tolower((unsigned char)ch[0]);
+            }
+            i += len;
+
+            const auto it = nodes[n].next.find(ch);
+            if (it != nodes[n].next.end()) {
+                n = it->second;
+            } else {
+                nodes[n].next[ch] = nodes.size();
+                n = nodes.size();
+                nodes.emplace_back();
+            }
+        }
+        g.n_texts += !nodes[n].terminal;
+        nodes[n].terminal = true;
+    }
+
+    if (g.n_texts == 0) {
+        LOG_ERR("grammar: no command text in config");
+        return false;
+    }
+
+    // whisper 输出的文本以空格开头
+    g.gbnf = "root ::= \" \" cmd-0\n";
+    std::deque<size_t> pending(1, 0);
+    while (!pending.empty()) {
+        const size_t id = pending.front();
+        pending.pop_front();
+        g.gbnf += command_grammar_rule(nodes, id, id == 0, pending);
+    }
+    LOG_DBG("grammar:\n%s", g.gbnf.c_str());
+
+    g.parsed = grammar_parser::parse(g.gbnf.c_str());
+    const auto root = g.parsed.symbol_ids.find("root");
+    if (g.parsed.rules.empty() || root == g.parsed.symbol_ids.end()) {
+        LOG_ERR("grammar: fail to parse generated grammar");
+        return false;
+    }
+    g.rules  = g.parsed.c_rules();
+    g.i_root = root->second;
+
+    LOG_INFO("grammar: %zu commands, %zu rules, %zu bytes of GBNF", g.n_texts, g.rules.size(), g.gbnf.size());
+    return true;
+}
+
+/**
+ * 让一次推理使用该语法：不符合语法的 token 的 logit 减去 penalty。
+ *
+ * @param g 语法，推理期间必须保持有效。
+ * @param wparams 推理参数。
+ * @param penalty 语法惩罚，越大越严格地只输出命令文本。
+ */
+void command_grammar_apply(const command_grammar_t &g, whisper_full_params &wparams, float penalty)
+{
+    // whisper 在每次推理开始时把规则复制到自己的语法状态中，只读取这里的元素，所以可以去掉 const
+    wparams.grammar_rules   = const_cast<const whisper_grammar_element **>(g.rules.data());
+    wparams.n_grammar_rules = g.rules.size();
+    wparams.i_start_rule    = g.i_root;
+    wparams.grammar_penalty = penalty;
+}
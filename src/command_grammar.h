@@ -0,0 +1,46 @@
+#ifndef COMMAND_GRAMMAR_H_
+#define COMMAND_GRAMMAR_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "grammar-parser.h"
+#include "whisper.h"
+
+/**
+ * 由 config.json 的全部命令文本生成的解码语法（GBNF），用于约束 whisper 只输出这些命令。
+ *
+ * 命令文本按字符（UTF-8 码点）建成前缀树，每个分叉点一条规则，不分叉的一串字符合并成一个字面量，
+ * 所以共享前缀的命令（例如 "okay" / "okay." / "okay?"）只展开一次，解码时语法栈的数量与分叉数相当，
+ * 而不是与命令数相当。whisper 输出的文本以空格开头，首字母大小写不定，
+ * 语法以 " " 开头，首字符是字母时写成 [Oo] 这样的字符类；其余字符与配置文件中一致。
+ * 生成后只读，多个识别会话可以同时使用同一份语法。
+ */
+struct command_grammar_t {
+    std::string gbnf;                                   ///< 生成的语法文本，用于日志和调试
+    grammar_parser::parse_state parsed;                 ///< 解析后的规则
+    std::vector<const whisper_grammar_element *> rules; ///< 指向 parsed 中各规则的首元素，所以语法建好后不能复制
+    size_t i_root  = 0;                                 ///< 起始规则 root 的下标
+    size_t n_texts = 0;                                 ///< 去重后的命令文本数
+};
+
+/**
+ * 由命令文本生成并解析语法。
+ *
+ * @param g 输出的语法，覆盖原有内容。
+ * @param texts 命令文本，即 config.json 中各项 "text" 的全部元素，忽略首尾空白，重复的只算一次。
+ * @return 成功返回 true，没有非空文本或语法解析失败返回 false。
+ */
+bool command_grammar_build(command_grammar_t &g, const std::vector<std::string> &texts);
+
+/**
+ * 让一次推理使用该语法：不符合语法的 token 的 logit 减去 penalty。
+ *
+ * @param g 语法，推理期间必须保持有效。
+ * @param wparams 推理参数。
+ * @param penalty 语法惩罚，越大越严格地只输出命令文本。
+ */
+void command_grammar_apply(const command_grammar_t &g, whisper_full_params &wparams, float penalty);
+
+#endif  // COMMAND_GRAMMAR_H_
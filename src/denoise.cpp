@@ -0,0 +1,151 @@
+#include "denoise.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#define DENOISE_PSD_SMOOTH  0.7f    ///< 功率谱时间平滑中上一帧的权重
+#define DENOISE_NOISE_SMOOTH 0.9f   ///< 判为噪声的帧更新噪声估计时上一帧的权重
+#define DENOISE_SPEECH_RATIO 4.0f   ///< 平滑功率超过噪声估计的该倍数（6 dB）时视为语音，不更新噪声估计
+#define DENOISE_NOISE_RISE  1.01f   ///< 视为语音时噪声估计每帧上升的比例（约 2.7 dB/s），用于跟上变大的噪声
+
+/**
+ * 计算窗函数并分配缓冲区，清空噪声估计。
+ *
+ * @param params 降噪参数。
+ * @param max_samples 单次 process() 的最大样本数，用于预分配缓冲区。
+ * @return 成功返回 true，帧长不合法返回 false。
+ */
+bool denoiser_t::init(const denoise_params_t &params, size_t max_samples)
+{
+    if (params.n_fft < 16 || !fft.init((size_t) params.n_fft)) {
+        return false;
+    }
+
+    n_fft    = (size_t) params.n_fft;
+    hop      = n_fft / 2;
+    n_bins   = n_fft / 2 + 1;
+    max_n    = max_samples;
+    gain_min = powf(10.0f, params.floor_db / 20.0f);
+    alpha    = params.alpha;
+    noise_valid = false;
+
+    // 周期型 Hann 窗在 50% 重叠下逐点相加为 1，开平方后分析、合成各用一次
+    window.resize(n_fft);
+    for (size_t i = 0; i < n_fft; ++i) {
+        window[i] = (float) sqrt(0.5 - 0.5 * cos(2.0 * M_PI * (double) i / (double) n_fft));
+    }
+
+    // 前后各补半帧零：第 j 帧从 j * hop 开始，共 (max_samples - 1) / hop + 2 帧
+    const size_t n_pad = ((max_samples + hop - 1) / hop + 2) * hop;
+    in.assign(n_pad, 0.0f);
+    out.assign(n_pad, 0.0f);
+    frame.assign(n_fft, 0.0f);
+    re.assign(n_bins, 0.0f);
+    im.assign(n_bins, 0.0f);
+    psd.assign(n_bins, 0.0f);
+    noise.assign(n_bins, 0.0f);
+    speech.assign(n_bins, 0.0f);
+
+    st = denoise_stats_t();
+
+    return true;
+}
+
+/**
+ * 原地降噪一块样本。
+ *
+ * @param pcm 样本，范围 [-1, 1]。
+ * @param n 样本数，不超过 init() 时的 max_samples。
+ */
+void denoiser_t::process(float *pcm, size_t n)
+{
+    if (n == 0 || n > max_n) {
+        return;
+    }
+
+    const auto t0 = std::chrono::steady_clock::now();
+
+    const size_t n_frames = (n - 1) / hop + 2;
+    const size_t n_pad    = (n_frames + 1) * hop;
+
+    std::fill(in.begin(), in.begin() + n_pad, 0.0f);
+    std::fill(out.begin(), out.begin() + n_pad, 0.0f);
+    memcpy(in.data() + hop, pcm, n * sizeof(float));
+
+    for (size_t j = 0; j < n_frames; ++j) {
+        const float *x = in.data() + j * hop;
+        for (size_t i = 0; i < n_fft; ++i) {
+            frame[i] = x[i] * window[i];
+        }
+
+        fft.forward(frame.data(), re.data(), im.data());
+
+        for (size_t k = 0; k < n_bins; ++k) {
+            const float p = re[k] * re[k] + im[k] * im[k];
+
+            // 块的第一帧不与上一块的平滑值衔接，音频在块之间不连续
+            psd[k] = j == 0 ? p : DENOISE_PSD_SMOOTH * psd[k] + (1.0f - DENOISE_PSD_SMOOTH) * p;
+
+            if (!noise_valid) {
+                noise[k] = psd[k];
+            } else if (psd[k] < DENOISE_SPEECH_RATIO * noise[k]) {
+                noise[k] = DENOISE_NOISE_SMOOTH * noise[k] + (1.0f - DENOISE_NOISE_SMOOTH) * psd[k];
+            } else {
+                noise[k] *= DENOISE_NOISE_RISE;
+            }
+
+            const float lambda = std::max(noise[k], 1e-12f);
+            const float gamma  = p / lambda;
+            const float prev   = j == 0 ? 0.0f : speech[k] / lambda;
+            const float xi     = alpha * prev + (1.0f - alpha) * std::max(gamma - 1.0f, 0.0f);
+            const float gain   = std::max(xi / (1.0f + xi), gain_min);
+
+            speech[k] = gain * gain * p;
+            re[k] *= gain;
+            im[k] *= gain;
+        }
+        noise_valid = true;
+
+        fft.inverse(re.data(), im.data(), frame.data());
+
+        float *y = out.data() + j * hop;
+        for (size_t i = 0; i < n_fft; ++i) {
+            y[i] += frame[i] * window[i];
+        }
+    }
+
+    memcpy(pcm, out.data() + hop, n * sizeof(float));
+
+    const uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - t0).count();
+    st.n_blocks++;
+    st.n_frames += n_frames;
+    st.ns_total += ns;
+    st.ns_max    = std::max(st.ns_max, ns);
+}
+
+/**
+ * 获取当前噪声估计的总功率，用于日志。
+ *
+ * 帧功率按 Parseval 定理由各频点功率求和，再对窗能量和满量程正弦归一化。
+ *
+ * @return 噪声电平（dBFS），还没有估计时返回 -100。
+ */
+float denoiser_t::noise_db() const
+{
+    if (!noise_valid) {
+        return -100.0f;
+    }
+
+    double sum = 0.0;
+    for (size_t k = 0; k < n_bins; ++k) {
+        // 除直流和奈奎斯特外每个频点代表正负两个频率
+        sum += (k == 0 || k == n_bins - 1 ? 1.0 : 2.0) * noise[k];
+    }
+
+    // 平方根 Hann 窗的能量为 n_fft / 2，每个样本的均方为 sum / n_fft / (n_fft / 2)
+    const double ms = sum / (double) n_fft / (0.5 * (double) n_fft);
+    return (float) (10.0 * log10(ms + 1e-10));
+}
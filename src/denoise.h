@@ -0,0 +1,95 @@
+#ifndef DENOISE_H_
+#define DENOISE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "fft.h"
+
+/**
+ * 降噪参数。
+ */
+struct denoise_params_t {
+    int   n_fft     = 512;      ///< 帧长（样本数），2 的幂，帧移为一半；16 kHz 下为 32 ms
+    float floor_db  = -15.0f;   ///< 增益下限（dB），限制最大衰减量，越低残留噪声越少但失真越大
+    float alpha     = 0.98f;    ///< 判决引导先验信噪比估计中上一帧的权重
+};
+
+/**
+ * 降噪阶段的耗时统计。
+ */
+struct denoise_stats_t {
+    uint64_t n_blocks  = 0;     ///< 处理的块数（每次推理一块）
+    uint64_t n_frames  = 0;     ///< 处理的 FFT 帧数
+    uint64_t ns_total  = 0;     ///< 累计耗时（纳秒）
+    uint64_t ns_max    = 0;     ///< 单块最大耗时（纳秒）
+};
+
+/**
+ * 送入推理之前的频域降噪：短时傅里叶变换（平方根 Hann 窗，50% 重叠）上的维纳滤波。
+ *
+ * 每个频点的噪声功率跟踪平滑后的功率谱：低于噪声估计 6 dB 以上时视为噪声帧，按指数平滑更新；
+ * 否则视为语音，噪声估计每帧按固定比例缓慢上升，所以噪声变大后几秒内也能跟上；
+ * 噪声估计跨块保持，语音段之间的静音和 VAD 的 pre-roll 都会更新它。
+ * 增益由判决引导法估计的先验信噪比 xi 得到 G = xi / (1 + xi)，并限制在 floor_db 以上，
+ * 上一帧的增益只在块内传递，块与块之间的音频不连续。
+ *
+ * 整块原地处理，块首尾各补半帧零，输出与输入等长、时间对齐。只由一个线程调用。
+ */
+struct denoiser_t {
+    /**
+     * 计算窗函数并分配缓冲区，清空噪声估计。
+     *
+     * @param params 降噪参数。
+     * @param max_samples 单次 process() 的最大样本数，用于预分配缓冲区。
+     * @return 成功返回 true，帧长不合法返回 false。
+     */
+    bool init(const denoise_params_t &params, size_t max_samples);
+
+    /**
+     * 原地降噪一块样本。
+     *
+     * @param pcm 样本，范围 [-1, 1]。
+     * @param n 样本数，不超过 init() 时的 max_samples。
+     */
+    void process(float *pcm, size_t n);
+
+    /**
+     * 获取当前噪声估计的总功率，用于日志。
+     *
+     * @return 噪声电平（dBFS），还没有估计时返回 -100。
+     */
+    float noise_db() const;
+
+    /**
+     * 获取耗时统计。
+     *
+     * @return 统计数据。
+     */
+    const denoise_stats_t &stats() const { return st; }
+
+private:
+    size_t n_fft = 0;           ///< 帧长
+    size_t hop   = 0;           ///< 帧移
+    size_t n_bins = 0;          ///< 频点数 n_fft/2 + 1
+    size_t max_n = 0;           ///< 单块最大样本数
+    float gain_min = 0.0f;      ///< 增益下限（线性）
+    float alpha = 0.98f;        ///< 判决引导的平滑系数
+    bool noise_valid = false;   ///< 噪声估计是否已初始化
+
+    rfft_plan_t fft;            ///< 实数 FFT
+    std::vector<float> window;  ///< 平方根 Hann 窗（周期型），分析和合成共用
+    std::vector<float> in;      ///< 补零后的输入
+    std::vector<float> out;     ///< 重叠相加的输出
+    std::vector<float> frame;   ///< 一帧时域样本
+    std::vector<float> re;      ///< 频谱实部
+    std::vector<float> im;      ///< 频谱虚部
+    std::vector<float> psd;     ///< 时间上平滑的功率谱
+    std::vector<float> noise;   ///< 各频点的噪声功率估计，跨块保持
+    std::vector<float> speech;  ///< 上一帧增强后的功率，用于判决引导
+
+    denoise_stats_t st;         ///< 耗时统计
+};
+
+#endif  // DENOISE_H_
@@ -0,0 +1,63 @@
+#include "energy_gate.h"
+
+#include <algorithm>
+#include <cmath>
+
+#define ENERGY_GATE_NOISE_TC_MS 10000   ///< 噪声底上升的时间常数（毫秒），下降是立即的
+
+/**
+ * 初始化门限并清空状态。
+ *
+ * @param sample_rate 采样率。
+ * @param freq_thold 高通滤波截止频率（Hz）。
+ * @param gate_db 帧能量高出噪声底多少 dB 判为语音。
+ * @param floor_db 判决门限的下限（dBFS），低于该能量的帧一律判为静音，也是噪声底的初始值。
+ * @param ceil_db 判决门限的上限（dBFS），高于该能量的帧一律判为语音。
+ */
+void energy_gate_t::init(int sample_rate, float freq_thold, float gate_db, float floor_db, float ceil_db)
+{
+    rate  = std::max(sample_rate, 1);
+    gate  = gate_db;
+    floor = floor_db;
+    ceil  = std::max(floor_db, ceil_db);
+
+    const float rc = 1.0f / (2.0f * (float)M_PI * std::max(freq_thold, 1.0f));
+    const float dt = 1.0f / rate;
+    hpf.a  = rc / (rc + dt);
+    hpf.x1 = 0.0f;
+    hpf.y1 = 0.0f;
+
+    energy_db = -100.0f;
+    magnitude_avg = 0.0f;
+    noise_db  = floor_db;
+}
+
+/**
+ * 处理一帧样本，滤波和求和由 vad_frame() 按 CPU 选择向量实现。
+ *
+ * @param frame 帧数据。
+ * @param n 帧长度（样本数），建议 10 ~ 30 ms。
+ * @return 判为语音返回 true。
+ */
+bool energy_gate_t::process(const int16_t *frame, size_t n)
+{
+    if (n == 0) {
+        return false;
+    }
+
+    vad_frame_sums_t sums;
+    vad_frame(frame, n, hpf, sums);
+    energy_db = 10.0f * log10f(sums.sum_sq / n / (32768.0f * 32768.0f) + 1e-10f);
+    magnitude_avg = sums.sum_abs / n;
+
+    const bool speech = energy_db > threshold();
+
+    // 长时间的稳定噪声会把噪声底慢慢抬上来，不会一直被当作语音
+    if (energy_db < noise_db) {
+        noise_db = energy_db;
+    } else {
+        noise_db += (energy_db - noise_db) * std::min(1.0f, 1000.0f * n / rate / ENERGY_GATE_NOISE_TC_MS);
+    }
+
+    return speech;
+}
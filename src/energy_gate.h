@@ -0,0 +1,78 @@
+#ifndef ENERGY_GATE_H_
+#define ENERGY_GATE_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "vad_kernels.h"
+
+/**
+ * 逐帧能量门限，用于在样本流上粗略判断语音的起止位置。
+ *
+ * 每帧先经过一阶高通滤波（滤波器状态跨帧保持），计算能量（dBFS），
+ * 与跟踪的噪声底比较：噪声底遇到更安静的帧立即下降，否则按时间常数缓慢上升。
+ * 判决门限是噪声底加 gate_db，并限制在 [floor_db, ceil_db] 之内：安静的房间里不会低到
+ * 把底噪判为语音，嘈杂的房间里也不会高到漏掉正常音量的命令。能量高于门限的帧判为语音。
+ */
+struct energy_gate_t {
+    /**
+     * 初始化门限并清空状态。
+     *
+     * @param sample_rate 采样率。
+     * @param freq_thold 高通滤波截止频率（Hz）。
+     * @param gate_db 帧能量高出噪声底多少 dB 判为语音。
+     * @param floor_db 判决门限的下限（dBFS），低于该能量的帧一律判为静音，也是噪声底的初始值。
+     * @param ceil_db 判决门限的上限（dBFS），高于该能量的帧一律判为语音。
+     */
+    void init(int sample_rate, float freq_thold, float gate_db = 10.0f, float floor_db = -60.0f, float ceil_db = 0.0f);
+
+    /**
+     * 处理一帧样本，滤波和求和由 vad_frame() 按 CPU 选择向量实现。
+     *
+     * @param frame 帧数据。
+     * @param n 帧长度（样本数），建议 10 ~ 30 ms。
+     * @return 判为语音返回 true。
+     */
+    bool process(const int16_t *frame, size_t n);
+
+    /**
+     * 获取最近一帧的能量。
+     *
+     * @return 能量（dBFS）。
+     */
+    float energy() const { return energy_db; }
+
+    /**
+     * 获取最近一帧滤波后的平均幅度（绝对值的均值），与 vad_simple 使用的度量相同。
+     *
+     * @return 平均幅度（满量程为 32768）。
+     */
+    float magnitude() const { return magnitude_avg; }
+
+    /**
+     * 获取当前噪声底估计。
+     *
+     * @return 噪声底（dBFS）。
+     */
+    float noise() const { return noise_db; }
+
+    /**
+     * 获取当前的判决门限，即限制在上下限之内的噪声底加 gate_db。
+     *
+     * @return 判决门限（dBFS）。
+     */
+    float threshold() const { return std::min(ceil, std::max(floor, noise_db + gate)); }
+
+private:
+    int   rate = 16000;             ///< 采样率
+    float gate = 10.0f;             ///< 语音判决门限（高出噪声底的 dB）
+    float floor = -60.0f;           ///< 判决门限下限（dBFS）
+    float ceil = 0.0f;              ///< 判决门限上限（dBFS）
+    vad_hpf_t hpf;                  ///< 高通滤波器状态
+    float energy_db = -100.0f;      ///< 最近一帧的能量（dBFS）
+    float magnitude_avg = 0.0f;     ///< 最近一帧的平均幅度
+    float noise_db = -60.0f;        ///< 噪声底估计（dBFS）
+};
+
+#endif  // ENERGY_GATE_H_
@@ -0,0 +1,434 @@
+#include "fft.h"
+
+#include <cmath>
+#include <utility>
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define FFT_KERNELS_NEON
+#elif (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <immintrin.h>
+#define FFT_KERNELS_X86
+#endif
+
+#define FFT_VECTOR_MIN 8    ///< 半长小于该值的级用标量蝶形，避免向量实现只走尾部
+
+/**
+ * 标量参考实现。
+ *
+ * @param ar a 的实部。
+ * @param ai a 的虚部。
+ * @param br b 的实部。
+ * @param bi b 的虚部。
+ * @param wr 旋转因子实部。
+ * @param wi 旋转因子虚部。
+ * @param h 蝶形个数。
+ */
+static void fft_butterfly_scalar(float *ar, float *ai, float *br, float *bi, const float *wr, const float *wi, size_t h)
+{
+    for (size_t k = 0; k < h; ++k) {
+        const float tr = wr[k] * br[k] - wi[k] * bi[k];
+        const float ti = wr[k] * bi[k] + wi[k] * br[k];
+        br[k] = ar[k] - tr;
+        bi[k] = ai[k] - ti;
+        ar[k] += tr;
+        ai[k] += ti;
+    }
+}
+
+/**
+ * 位反转之后的前三级（半长 1、2、4），即 8 点 DFT，在局部变量中完成。
+ *
+ * @param re 8 个点的实部。
+ * @param im 8 个点的虚部。
+ */
+static inline void fft_first_stages(float *re, float *im)
+{
+    const float c = 0.70710678f;
+
+    float xr[8], xi[8];
+    for (int k = 0; k < 8; ++k) {
+        xr[k] = re[k];
+        xi[k] = im[k];
+    }
+
+    // 半长 1：旋转因子为 1
+    for (int k = 0; k < 8; k += 2) {
+        const float tr = xr[k + 1], ti = xi[k + 1];
+        xr[k + 1] = xr[k] - tr;
+        xi[k + 1] = xi[k] - ti;
+        xr[k] += tr;
+        xi[k] += ti;
+    }
+
+    // 半长 2：旋转因子为 1 和 -i
+    for (int k = 0; k < 8; k += 4) {
+        float tr = xr[k + 2], ti = xi[k + 2];
+        xr[k + 2] = xr[k] - tr;
+        xi[k + 2] = xi[k] - ti;
+        xr[k] += tr;
+        xi[k] += ti;
+
+        tr =  xi[k + 3];
+        ti = -xr[k + 3];
+        xr[k + 3] = xr[k + 1] - tr;
+        xi[k + 3] = xi[k + 1] - ti;
+        xr[k + 1] += tr;
+        xi[k + 1] += ti;
+    }
+
+    // 半长 4：旋转因子为 1、(1 - i)/sqrt(2)、-i、-(1 + i)/sqrt(2)
+    const float tr[4] = { xr[4], c * (xr[5] + xi[5]),  xi[6], c * (xi[7] - xr[7]) };
+    const float ti[4] = { xi[4], c * (xi[5] - xr[5]), -xr[6], -c * (xr[7] + xi[7]) };
+    for (int k = 0; k < 4; ++k) {
+        re[k + 4] = xr[k] - tr[k];
+        im[k + 4] = xi[k] - ti[k];
+        re[k]     = xr[k] + tr[k];
+        im[k]     = xi[k] + ti[k];
+    }
+}
+
+#if defined(FFT_KERNELS_NEON)
+/**
+ * NEON 实现，每次 4 个蝶形。
+ *
+ * @param ar a 的实部。
+ * @param ai a 的虚部。
+ * @param br b 的实部。
+ * @param bi b 的虚部。
+ * @param wr 旋转因子实部。
+ * @param wi 旋转因子虚部。
+ * @param h 蝶形个数。
+ */
+static void fft_butterfly_neon(float *ar, float *ai, float *br, float *bi, const float *wr, const float *wi, size_t h)
+{
+    size_t k = 0;
+    for (; k + 4 <= h; k += 4) {
+        const float32x4_t vwr = vld1q_f32(wr + k);
+        const float32x4_t vwi = vld1q_f32(wi + k);
+        const float32x4_t vbr = vld1q_f32(br + k);
+        const float32x4_t vbi = vld1q_f32(bi + k);
+        const float32x4_t var = vld1q_f32(ar + k);
+        const float32x4_t vai = vld1q_f32(ai + k);
+
+        const float32x4_t tr = vmlsq_f32(vmulq_f32(vwr, vbr), vwi, vbi);
+        const float32x4_t ti = vmlaq_f32(vmulq_f32(vwr, vbi), vwi, vbr);
+
+        vst1q_f32(br + k, vsubq_f32(var, tr));
+        vst1q_f32(bi + k, vsubq_f32(vai, ti));
+        vst1q_f32(ar + k, vaddq_f32(var, tr));
+        vst1q_f32(ai + k, vaddq_f32(vai, ti));
+    }
+
+    fft_butterfly_scalar(ar + k, ai + k, br + k, bi + k, wr + k, wi + k, h - k);
+}
+#endif
+
+#if defined(FFT_KERNELS_X86)
+/**
+ * SSE4.1 实现，每次 4 个蝶形。
+ *
+ * @param ar a 的实部。
+ * @param ai a 的虚部。
+ * @param br b 的实部。
+ * @param bi b 的虚部。
+ * @param wr 旋转因子实部。
+ * @param wi 旋转因子虚部。
+ * @param h 蝶形个数。
+ */
+__attribute__((target("sse4.1")))
+static void fft_butterfly_sse4(float *ar, float *ai, float *br, float *bi, const float *wr, const float *wi, size_t h)
+{
+    size_t k = 0;
+    for (; k + 4 <= h; k += 4) {
+        const __m128 vwr = _mm_loadu_ps(wr + k);
+        const __m128 vwi = _mm_loadu_ps(wi + k);
+        const __m128 vbr = _mm_loadu_ps(br + k);
+        const __m128 vbi = _mm_loadu_ps(bi + k);
+        const __m128 var = _mm_loadu_ps(ar + k);
+        const __m128 vai = _mm_loadu_ps(ai + k);
+
+        const __m128 tr = _mm_sub_ps(_mm_mul_ps(vwr, vbr), _mm_mul_ps(vwi, vbi));
+        const __m128 ti = _mm_add_ps(_mm_mul_ps(vwr, vbi), _mm_mul_ps(vwi, vbr));
+
+        _mm_storeu_ps(br + k, _mm_sub_ps(var, tr));
+        _mm_storeu_ps(bi + k, _mm_sub_ps(vai, ti));
+        _mm_storeu_ps(ar + k, _mm_add_ps(var, tr));
+        _mm_storeu_ps(ai + k, _mm_add_ps(vai, ti));
+    }
+
+    fft_butterfly_scalar(ar + k, ai + k, br + k, bi + k, wr + k, wi + k, h - k);
+}
+
+/**
+ * AVX2 实现，每次 8 个蝶形。
+ *
+ * @param ar a 的实部。
+ * @param ai a 的虚部。
+ * @param br b 的实部。
+ * @param bi b 的虚部。
+ * @param wr 旋转因子实部。
+ * @param wi 旋转因子虚部。
+ * @param h 蝶形个数。
+ */
+__attribute__((target("avx2")))
+static void fft_butterfly_avx2(float *ar, float *ai, float *br, float *bi, const float *wr, const float *wi, size_t h)
+{
+    size_t k = 0;
+    for (; k + 8 <= h; k += 8) {
+        const __m256 vwr = _mm256_loadu_ps(wr + k);
+        const __m256 vwi = _mm256_loadu_ps(wi + k);
+        const __m256 vbr = _mm256_loadu_ps(br + k);
+        const __m256 vbi = _mm256_loadu_ps(bi + k);
+        const __m256 var = _mm256_loadu_ps(ar + k);
+        const __m256 vai = _mm256_loadu_ps(ai + k);
+
+        const __m256 tr = _mm256_sub_ps(_mm256_mul_ps(vwr, vbr), _mm256_mul_ps(vwi, vbi));
+        const __m256 ti = _mm256_add_ps(_mm256_mul_ps(vwr, vbi), _mm256_mul_ps(vwi, vbr));
+
+        _mm256_storeu_ps(br + k, _mm256_sub_ps(var, tr));
+        _mm256_storeu_ps(bi + k, _mm256_sub_ps(vai, ti));
+        _mm256_storeu_ps(ar + k, _mm256_add_ps(var, tr));
+        _mm256_storeu_ps(ai + k, _mm256_add_ps(vai, ti));
+    }
+
+    fft_butterfly_scalar(ar + k, ai + k, br + k, bi + k, wr + k, wi + k, h - k);
+}
+#endif
+
+/**
+ * 获取当前 CPU 上可用的全部蝶形实现，第一个总是标量参考实现。用于基准测试和一致性校验。
+ *
+ * @return 可用实现列表。
+ */
+std::vector<fft_kernel_t> fft_kernels_available()
+{
+    std::vector<fft_kernel_t> list;
+    list.push_back({ "scalar", fft_butterfly_scalar });
+
+#if defined(FFT_KERNELS_NEON)
+    list.push_back({ "neon", fft_butterfly_neon });
+#elif defined(FFT_KERNELS_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.1")) {
+        list.push_back({ "sse4", fft_butterfly_sse4 });
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        list.push_back({ "avx2", fft_butterfly_avx2 });
+    }
+#endif
+
+    return list;
+}
+
+/**
+ * 选择当前 CPU 上最快的实现，即可用列表中的最后一个。
+ *
+ * @return 选中的实现。
+ */
+static const fft_kernel_t &fft_kernels_best()
+{
+    static const fft_kernel_t best = fft_kernels_available().back();
+    return best;
+}
+
+/**
+ * 获取 fft_plan_t 默认选中的蝶形实现名称，用于日志。
+ *
+ * @return 实现名称：neon、avx2、sse4 或 scalar。
+ */
+const char *fft_kernels_impl()
+{
+    return fft_kernels_best().name;
+}
+
+/**
+ * 初始化。
+ *
+ * @param n 变换长度，2 的幂且不小于 2。
+ * @param kernel 蝶形实现，nullptr 表示当前 CPU 上最快的实现。
+ * @return 成功返回 true，长度不合法返回 false。
+ */
+bool fft_plan_t::init(size_t n, const fft_kernel_t *kernel)
+{
+    if (n < 2 || (n & (n - 1)) != 0) {
+        return false;
+    }
+
+    this->n = n;
+    fn = (kernel ? *kernel : fft_kernels_best()).fn;
+
+    rev.clear();
+    for (size_t i = 0, j = 0; i < n; ++i) {
+        if (i < j) {
+            rev.push_back(i);
+            rev.push_back(j);
+        }
+        size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j |= bit;
+    }
+
+    wr.assign(n - 1, 0.0f);
+    wi.assign(n - 1, 0.0f);
+    for (size_t h = 1; h < n; h <<= 1) {
+        for (size_t k = 0; k < h; ++k) {
+            const double a = -M_PI * (double) k / (double) h;
+            wr[h - 1 + k] = (float) cos(a);
+            wi[h - 1 + k] = (float) sin(a);
+        }
+    }
+
+    return true;
+}
+
+/**
+ * 原地正变换 X[k] = sum(x[j] * exp(-2 pi i j k / n))。
+ *
+ * @param re 实部，n 个。
+ * @param im 虚部，n 个。
+ */
+void fft_plan_t::forward(float *re, float *im) const
+{
+    for (size_t i = 0; i < rev.size(); i += 2) {
+        std::swap(re[rev[i]], re[rev[i + 1]]);
+        std::swap(im[rev[i]], im[rev[i + 1]]);
+    }
+
+    // 前三级块很短，每 8 个点在寄存器中一次做完，旋转因子都是常数
+    size_t h = 1;
+    if (n >= FFT_VECTOR_MIN) {
+        for (size_t j = 0; j < n; j += 8) {
+            fft_first_stages(re + j, im + j);
+        }
+        h = FFT_VECTOR_MIN;
+    }
+    for (; h < n && h < FFT_VECTOR_MIN; h <<= 1) {
+        const float *twr = wr.data() + h - 1;
+        const float *twi = wi.data() + h - 1;
+        for (size_t j = 0; j < n; j += 2 * h) {
+            fft_butterfly_scalar(re + j, im + j, re + j + h, im + j + h, twr, twi, h);
+        }
+    }
+    for (; h < n; h <<= 1) {
+        const float *twr = wr.data() + h - 1;
+        const float *twi = wi.data() + h - 1;
+        for (size_t j = 0; j < n; j += 2 * h) {
+            fn(re + j, im + j, re + j + h, im + j + h, twr, twi, h);
+        }
+    }
+}
+
+/**
+ * 原地逆变换，含 1/n 缩放。
+ *
+ * 交换实部虚部后做正变换再交换回来即得到共轭方向的变换，所以直接把 im、re 对调传给正变换。
+ *
+ * @param re 实部，n 个。
+ * @param im 虚部，n 个。
+ */
+void fft_plan_t::inverse(float *re, float *im) const
+{
+    forward(im, re);
+
+    const float scale = 1.0f / (float) n;
+    for (size_t i = 0; i < n; ++i) {
+        re[i] *= scale;
+        im[i] *= scale;
+    }
+}
+
+/**
+ * 初始化。
+ *
+ * @param n 变换长度，2 的幂且不小于 4。
+ * @param kernel 蝶形实现，nullptr 表示当前 CPU 上最快的实现。
+ * @return 成功返回 true，长度不合法返回 false。
+ */
+bool rfft_plan_t::init(size_t n, const fft_kernel_t *kernel)
+{
+    if (n < 4 || !half.init(n / 2, kernel)) {
+        return false;
+    }
+
+    this->n = n;
+    zr.assign(n / 2, 0.0f);
+    zi.assign(n / 2, 0.0f);
+    tr.assign(n / 2 + 1, 0.0f);
+    ti.assign(n / 2 + 1, 0.0f);
+    for (size_t k = 0; k <= n / 2; ++k) {
+        const double a = -2.0 * M_PI * (double) k / (double) n;
+        tr[k] = (float) cos(a);
+        ti[k] = (float) sin(a);
+    }
+
+    return true;
+}
+
+/**
+ * 正变换。
+ *
+ * 偶数样本作实部、奇数样本作虚部做 n/2 点复数 FFT 得到 Z，
+ * 则 E[k] = (Z[k] + conj(Z[m-k])) / 2、O[k] = (Z[k] - conj(Z[m-k])) / 2i 分别是偶、奇样本的频谱，
+ * X[k] = E[k] + exp(-2 pi i k / n) * O[k]，其中 m = n/2。
+ *
+ * @param x 输入样本，n 个。
+ * @param re 输出频谱实部，n/2 + 1 个。
+ * @param im 输出频谱虚部，n/2 + 1 个。
+ */
+void rfft_plan_t::forward(const float *x, float *re, float *im)
+{
+    const size_t m = n / 2;
+    for (size_t i = 0; i < m; ++i) {
+        zr[i] = x[2 * i];
+        zi[i] = x[2 * i + 1];
+    }
+
+    half.forward(zr.data(), zi.data());
+
+    for (size_t k = 0; k <= m; ++k) {
+        const size_t k1 = k == m ? 0 : k;
+        const size_t k2 = k == 0 ? 0 : m - k;
+        const float er = 0.5f * (zr[k1] + zr[k2]);
+        const float ei = 0.5f * (zi[k1] - zi[k2]);
+        const float dr = 0.5f * (zr[k1] - zr[k2]);
+        const float di = 0.5f * (zi[k1] + zi[k2]);
+        // O = -i * D
+        re[k] = er + tr[k] * di + ti[k] * dr;
+        im[k] = ei - tr[k] * dr + ti[k] * di;
+    }
+}
+
+/**
+ * 逆变换，含 1/n 缩放。
+ *
+ * 先由 X 还原 E、O，再组合成 Z[k] = E[k] + i * O[k] 做 n/2 点逆变换，实部虚部交错即为输出。
+ *
+ * @param re 频谱实部，n/2 + 1 个。
+ * @param im 频谱虚部，n/2 + 1 个。
+ * @param x 输出样本，n 个。
+ */
+void rfft_plan_t::inverse(const float *re, const float *im, float *x)
+{
+    const size_t m = n / 2;
+    for (size_t k = 0; k < m; ++k) {
+        const float er = 0.5f * (re[k] + re[m - k]);
+        const float ei = 0.5f * (im[k] - im[m - k]);
+        const float dr = 0.5f * (re[k] - re[m - k]);
+        const float di = 0.5f * (im[k] + im[m - k]);
+        // O = D * conj(W^k)
+        const float or_ = dr * tr[k] + di * ti[k];
+        const float oi  = di * tr[k] - dr * ti[k];
+        zr[k] = er - oi;
+        zi[k] = ei + or_;
+    }
+
+    half.inverse(zr.data(), zi.data());
+
+    for (size_t i = 0; i < m; ++i) {
+        x[2 * i]     = zr[i];
+        x[2 * i + 1] = zi[i];
+    }
+}
@@ -0,0 +1,135 @@
+#ifndef FFT_H_
+#define FFT_H_
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * 蝶形函数：对 k = 0 .. h-1，t = w[k] * b[k]，b[k] = a[k] - t，a[k] = a[k] + t，实部虚部分开存放。
+ *
+ * @param ar a 的实部。
+ * @param ai a 的虚部。
+ * @param br b 的实部。
+ * @param bi b 的虚部。
+ * @param wr 旋转因子实部。
+ * @param wi 旋转因子虚部。
+ * @param h 蝶形个数。
+ */
+typedef void (*fft_butterfly_fn_t)(float *ar, float *ai, float *br, float *bi, const float *wr, const float *wi, size_t h);
+
+/**
+ * 一个蝶形实现。
+ */
+struct fft_kernel_t {
+    const char *name;           ///< 实现名称
+    fft_butterfly_fn_t fn;      ///< 蝶形函数
+};
+
+/**
+ * 复数 FFT，基 2 按时间抽取，长度为 2 的幂，实部虚部分开存放（便于向量化）。
+ *
+ * 每一级的旋转因子连续存放，蝶形函数按块调用；块长小于一个向量的前几级总是用标量实现。
+ */
+struct fft_plan_t {
+    /**
+     * 初始化。
+     *
+     * @param n 变换长度，2 的幂且不小于 2。
+     * @param kernel 蝶形实现，nullptr 表示当前 CPU 上最快的实现。
+     * @return 成功返回 true，长度不合法返回 false。
+     */
+    bool init(size_t n, const fft_kernel_t *kernel = nullptr);
+
+    /**
+     * 原地正变换 X[k] = sum(x[j] * exp(-2 pi i j k / n))。
+     *
+     * @param re 实部，n 个。
+     * @param im 虚部，n 个。
+     */
+    void forward(float *re, float *im) const;
+
+    /**
+     * 原地逆变换，含 1/n 缩放。
+     *
+     * @param re 实部，n 个。
+     * @param im 虚部，n 个。
+     */
+    void inverse(float *re, float *im) const;
+
+    /**
+     * 获取变换长度。
+     *
+     * @return 长度。
+     */
+    size_t size() const { return n; }
+
+private:
+    size_t n = 0;                       ///< 变换长度
+    fft_butterfly_fn_t fn = nullptr;    ///< 蝶形函数
+    std::vector<size_t> rev;            ///< 位反转置换中需要交换的下标对，两两一组
+    std::vector<float> wr;              ///< 各级旋转因子实部，半长为 h 的一级从下标 h - 1 开始
+    std::vector<float> wi;              ///< 各级旋转因子虚部
+};
+
+/**
+ * 实数 FFT：把 n 个实数样本打包成 n/2 点复数 FFT，再拆分出 n/2 + 1 个频点。
+ */
+struct rfft_plan_t {
+    /**
+     * 初始化。
+     *
+     * @param n 变换长度，2 的幂且不小于 4。
+     * @param kernel 蝶形实现，nullptr 表示当前 CPU 上最快的实现。
+     * @return 成功返回 true，长度不合法返回 false。
+     */
+    bool init(size_t n, const fft_kernel_t *kernel = nullptr);
+
+    /**
+     * 正变换。
+     *
+     * @param x 输入样本，n 个。
+     * @param re 输出频谱实部，n/2 + 1 个。
+     * @param im 输出频谱虚部，n/2 + 1 个。
+     */
+    void forward(const float *x, float *re, float *im);
+
+    /**
+     * 逆变换，含 1/n 缩放。
+     *
+     * @param re 频谱实部，n/2 + 1 个。
+     * @param im 频谱虚部，n/2 + 1 个。
+     * @param x 输出样本，n 个。
+     */
+    void inverse(const float *re, const float *im, float *x);
+
+    /**
+     * 获取变换长度。
+     *
+     * @return 长度。
+     */
+    size_t size() const { return n; }
+
+private:
+    size_t n = 0;               ///< 实数变换长度
+    fft_plan_t half;            ///< n/2 点复数 FFT
+    std::vector<float> zr;      ///< 打包后的复数序列实部
+    std::vector<float> zi;      ///< 打包后的复数序列虚部
+    std::vector<float> tr;      ///< 拆分用的旋转因子 exp(-2 pi i k / n) 实部，k = 0 .. n/2
+    std::vector<float> ti;      ///< 拆分用的旋转因子虚部
+};
+
+/**
+ * 获取 fft_plan_t 默认选中的蝶形实现名称，用于日志。
+ *
+ * @return 实现名称：neon、avx2、sse4 或 scalar。
+ */
+const char *fft_kernels_impl();
+
+/**
+ * 获取当前 CPU 上可用的全部蝶形实现，第一个总是标量参考实现。用于基准测试和一致性校验。
+ *
+ * @return 可用实现列表。
+ */
+std::vector<fft_kernel_t> fft_kernels_available();
+
+#endif  // FFT_H_
@@ -0,0 +1,187 @@
+#include "frame_vad.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "debug.h"
+
+/**
+ * 初始化检测器，创建判决模型并分配帧缓冲，只需调用一次。
+ *
+ * @param params 检测参数。
+ * @return 成功返回 true，参数无效或模型创建失败返回 false。
+ */
+bool frame_vad_t::init(const frame_vad_params_t &params)
+{
+    if (params.sample_rate <= 0 || params.frame_ms <= 0 || params.end_ms < params.frame_ms) {
+        LOG_ERR("bad vad params: rate %d, frame %d ms, end %d ms", params.sample_rate, params.frame_ms, params.end_ms);
+        return false;
+    }
+
+    vad_model_params_t mparams;
+    mparams.type        = params.model;
+    mparams.sample_rate = params.sample_rate;
+    mparams.frame_ms    = params.frame_ms;
+    mparams.freq_thold  = params.freq_thold;
+    mparams.gate_db     = params.gate_db;
+    mparams.floor_db    = params.floor_db;
+    mparams.ceil_db     = params.ceil_db;
+    mparams.mode        = params.mode;
+    frame_model.reset(vad_model_create(mparams));
+    if (!frame_model) {
+        return false;
+    }
+
+    this->params = params;
+
+    n_frame = (size_t) params.sample_rate * params.frame_ms / 1000;
+    n_start = std::max(1, params.start_ms / params.frame_ms);
+    n_end   = params.end_ms / params.frame_ms;
+    n_hang  = params.hangover_ms > 0 ? std::max(1, params.hangover_ms / params.frame_ms) : 0;
+
+    partial.assign(n_frame, 0);
+    history.assign(2 * n_end, 0.0f);
+    history_pos = 0;
+    history_len = 0;
+    sum_all  = 0.0;
+    sum_last = 0.0;
+
+    reset();
+    return true;
+}
+
+/**
+ * 回到静音状态并丢弃未满一帧的样本，保留噪声底和滤波器状态。用于丢弃积压之后。
+ */
+void frame_vad_t::reset()
+{
+    n_partial  = 0;
+    speech     = false;
+    n_run      = 0;
+    run_at     = 0;
+    speech_end = 0;
+}
+
+/**
+ * 处理一块新样本，长度任意，不足一帧的尾部留到下一次。
+ *
+ * @param data 样本数据。
+ * @param n 样本数。
+ * @param at 第一个样本的采样时钟，与上一块不连续时（丢样）按新位置继续。
+ * @param events 输出本块中检测到的事件，调用前会被清空。
+ */
+void frame_vad_t::process(const int16_t *data, size_t n, uint64_t at, std::vector<frame_vad_event_t> &events)
+{
+    events.clear();
+
+    // 与上一块之间有缺口时，残留的半帧已不连续，直接丢弃
+    if (n_partial > 0 && partial_at + n_partial != at) {
+        n_partial = 0;
+    }
+
+    if (n_partial > 0) {
+        const size_t k = std::min(n, n_frame - n_partial);
+        memcpy(partial.data() + n_partial, data, k * sizeof(int16_t));
+        n_partial += k;
+        data += k;
+        n    -= k;
+        at   += k;
+
+        if (n_partial < n_frame) {
+            return;
+        }
+        process_frame(partial.data(), partial_at, events);
+        n_partial = 0;
+    }
+
+    while (n >= n_frame) {
+        process_frame(data, at, events);
+        data += n_frame;
+        n    -= n_frame;
+        at   += n_frame;
+    }
+
+    if (n > 0) {
+        memcpy(partial.data(), data, n * sizeof(int16_t));
+        n_partial  = n;
+        partial_at = at;
+    }
+}
+
+/**
+ * 处理一个完整帧。
+ *
+ * @param frame 帧数据。
+ * @param at 帧起点的采样时钟。
+ * @param events 输出的事件。
+ */
+void frame_vad_t::process_frame(const int16_t *frame, uint64_t at, std::vector<frame_vad_event_t> &events)
+{
+    const bool is_speech = frame_model->process(frame, n_frame);
+
+    // 滑动和：先减去离开窗口的帧，再加上新帧
+    const size_t n_hist = history.size();
+    const float mag = frame_model->magnitude();
+    if (history_len == n_hist) {
+        sum_all -= history[history_pos];
+    }
+    if (history_len >= (size_t) n_end) {
+        sum_last -= history[(history_pos + n_end) % n_hist];
+    }
+    history[history_pos] = mag;
+    sum_all  += mag;
+    sum_last += mag;
+    history_pos = (history_pos + 1) % n_hist;
+    history_len = std::min(history_len + 1, n_hist);
+
+    // 每绕一圈重新求和一次，消除浮点累计误差
+    if (history_pos == 0 && history_len == n_hist) {
+        sum_all  = 0.0;
+        sum_last = 0.0;
+        for (size_t i = 0; i < n_hist; i++) {
+            sum_all += history[i];
+            if (i >= n_hist - n_end) {
+                sum_last += history[i];
+            }
+        }
+    }
+
+    if (!speech) {
+        if (!is_speech) {
+            n_run = 0;
+            return;
+        }
+        if (n_run == 0) {
+            run_at = at;
+        }
+        speech_end = at + n_frame;
+        if (++n_run >= n_start) {
+            speech = true;
+            n_run  = 0;
+            events.push_back({FRAME_VAD_START, run_at});
+        }
+        return;
+    }
+
+    if (is_speech) {
+        n_run = 0;
+        speech_end = at + n_frame;
+        return;
+    }
+    n_run++;
+
+    bool end = false;
+    if (n_hang > 0) {
+        end = n_run >= n_hang;
+    } else {
+        // 与 vad_simple 相同：最近 end_ms 的平均幅度不超过整个窗口平均幅度的 end_thold 倍
+        const bool quiet = history_len == n_hist && 2.0 * sum_last <= params.end_thold * sum_all;
+        end = quiet || n_run >= 2 * n_end;
+    }
+    if (end) {
+        speech = false;
+        n_run  = 0;
+        events.push_back({FRAME_VAD_END, speech_end});
+    }
+}
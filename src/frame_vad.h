@@ -0,0 +1,135 @@
+#ifndef FRAME_VAD_H_
+#define FRAME_VAD_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "vad_model.h"
+
+/**
+ * 流式语音检测参数。
+ */
+struct frame_vad_params_t {
+    int   sample_rate = 16000;      ///< 采样率
+    int   frame_ms    = 20;         ///< 判决帧长（毫秒），10 ~ 30
+    float freq_thold  = 100.0f;     ///< 高通滤波截止频率（Hz）
+    float gate_db     = 10.0f;      ///< 判决门限高出噪声底的 dB 数
+    float floor_db    = -60.0f;     ///< 判决门限下限：低于该能量（dBFS）的帧一律判为静音帧
+    float ceil_db     = -30.0f;     ///< 判决门限上限：噪声底再高，门限也不超过该能量（dBFS）
+    int   start_ms    = 60;         ///< 连续语音帧达到该时长才报告语音开始
+    int   end_ms      = 1000;       ///< 语音结束判决窗口：最近 end_ms 与最近 2 * end_ms 的平均幅度之比
+    float end_thold   = 0.6f;       ///< 平均幅度之比不超过该值时报告语音结束（即 vad_simple 的 vad_thold）
+    int   hangover_ms = 0;          ///< 语音后连续静音达到该时长即报告结束，0 表示使用平均幅度之比判决
+    vad_model_type_t model = VAD_MODEL_ENERGY; ///< 逐帧语音判决模型
+    int   mode        = 1;          ///< gmm 模型的激进程度 0 ~ 3
+};
+
+/**
+ * 语音事件类型。
+ */
+typedef enum {
+    FRAME_VAD_START = 0,    ///< 语音开始，位置是第一个语音帧的起点
+    FRAME_VAD_END,          ///< 语音结束，位置是最后一个语音帧的终点
+} frame_vad_event_type_t;
+
+/**
+ * 语音事件。
+ */
+struct frame_vad_event_t {
+    frame_vad_event_type_t type;    ///< 事件类型
+    uint64_t at;                    ///< 事件位置（采样时钟）
+};
+
+/**
+ * 流式逐帧语音检测。
+ *
+ * 每个新样本只处理一次：按帧交给 vad_model_t 判决（能量门限或子带高斯混合模型，状态跨帧保持），
+ * 每帧的平均幅度存入最近 2 * end_ms 的环形缓冲并维护滑动和，开销只与新样本数成正比。
+ *
+ * 判决带滞回：静音状态下连续 start_ms 的语音帧才报告开始。
+ * 语音状态下，设置了 hangover_ms 时连续 hangover_ms 的静音帧即报告结束；
+ * 否则当前帧为静音且最近 end_ms 的平均幅度不超过最近 2 * end_ms 的 end_thold 倍
+ * （与 vad_simple 相同的判据，但逐帧增量计算），或连续 2 * end_ms 都是静音帧时报告结束。
+ * 结束事件的位置总是最后一个语音帧的终点，不含拖尾的静音。
+ */
+struct frame_vad_t {
+    /**
+     * 初始化检测器，创建判决模型并分配帧缓冲，只需调用一次。
+     *
+     * @param params 检测参数。
+     * @return 成功返回 true，参数无效或模型创建失败返回 false。
+     */
+    bool init(const frame_vad_params_t &params);
+
+    /**
+     * 处理一块新样本，长度任意，不足一帧的尾部留到下一次。
+     *
+     * @param data 样本数据。
+     * @param n 样本数。
+     * @param at 第一个样本的采样时钟，与上一块不连续时（丢样）按新位置继续。
+     * @param events 输出本块中检测到的事件，调用前会被清空。
+     */
+    void process(const int16_t *data, size_t n, uint64_t at, std::vector<frame_vad_event_t> &events);
+
+    /**
+     * 回到静音状态并丢弃未满一帧的样本，保留噪声底和滤波器状态。用于丢弃积压之后。
+     */
+    void reset();
+
+    /**
+     * 是否处于语音状态。
+     *
+     * @return 语音状态返回 true。
+     */
+    bool in_speech() const { return speech; }
+
+    /**
+     * 获取内部的逐帧判决模型，用于读取能量和模型名称。init() 成功后才可调用。
+     *
+     * @return 判决模型。
+     */
+    const vad_model_t &model() const { return *frame_model; }
+
+    /**
+     * 获取帧长。
+     *
+     * @return 帧长（样本数）。
+     */
+    size_t frame_samples() const { return n_frame; }
+
+private:
+    /**
+     * 处理一个完整帧。
+     *
+     * @param frame 帧数据。
+     * @param at 帧起点的采样时钟。
+     * @param events 输出的事件。
+     */
+    void process_frame(const int16_t *frame, uint64_t at, std::vector<frame_vad_event_t> &events);
+
+    frame_vad_params_t params;              ///< 检测参数
+    std::unique_ptr<vad_model_t> frame_model; ///< 逐帧判决模型
+    size_t n_frame = 0;                     ///< 帧长（样本数）
+    int n_start = 0;                        ///< 报告开始所需的连续语音帧数
+    int n_end = 0;                          ///< 结束判决窗口的帧数
+    int n_hang = 0;                         ///< 报告结束所需的连续静音帧数，0 表示按平均幅度之比判决
+
+    std::vector<int16_t> partial;           ///< 未满一帧的样本
+    size_t n_partial = 0;                   ///< partial 中的样本数
+    uint64_t partial_at = 0;                ///< partial 第一个样本的采样时钟
+
+    std::vector<float> history;             ///< 最近 2 * n_end 帧的平均幅度
+    size_t history_pos = 0;                 ///< history 写入位置
+    size_t history_len = 0;                 ///< history 有效帧数
+    double sum_all = 0.0;                   ///< 最近 2 * n_end 帧的平均幅度之和
+    double sum_last = 0.0;                  ///< 最近 n_end 帧的平均幅度之和
+
+    bool speech = false;                    ///< 是否处于语音状态
+    int n_run = 0;                          ///< 静音状态下连续语音帧数 / 语音状态下连续静音帧数
+    uint64_t run_at = 0;                    ///< 连续语音帧中第一帧的起点
+    uint64_t speech_end = 0;                ///< 最近一个语音帧的终点
+};
+
+#endif  // FRAME_VAD_H_
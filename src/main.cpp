@@ -1,3 +1,4 @@
+#include <atomic>
 #include <iostream>
 #include <thread>
 #include <vector>
@@ -6,14 +7,15 @@
 #include "debug.h"
 
 /**
- * Whisper 回调函数类型定义。
+ * Whisper 回调函数类型定义，多个识别会话可能同时调用。
  *
+ * @param stream 识别会话序号，对应第几个采集设备
  * @param leat_count 识别到的文本剩余数量
  * @param text 识别到的文本代码。
  * @param code 处理后的文本代码。
  * @param userdata 用户自定义数据指针。
  */
-static int whisper_user_callback(size_t leat_count, const char* text, const char* code, void* userdata)
+static int whisper_user_callback(int stream, size_t leat_count, const char* text, const char* code, void* userdata)
 {
     // skip.
     if (leat_count) {
@@ -23,10 +25,10 @@ static int whisper_user_callback(size_t leat_count, const char* text, const char
         LOG_ERR("args fail! text(%p), code(%p), userdata(%p)", text, code, userdata);
         return -1;
     }
-    size_t &count = *(size_t *)userdata;
-    ++count;
+    std::atomic<size_t> &count = *(std::atomic<size_t> *)userdata;
+    const size_t n = ++count;
 
-    LOG_INFO("[%zu] get text: %s, code: %s", count, text, code);
+    LOG_INFO("[%zu] stream %d get text: %s, code: %s", n, stream, text, code);
 
     return 0;
 }
@@ -36,9 +38,9 @@ void whisper_fuzzy_task(void* userdata)
 {
     whisper_fuzzy_t* w = (whisper_fuzzy_t*)userdata;
     std::cout << "Task whisper is running on thread " << std::this_thread::get_id() << std::endl;
-    size_t count = 0;
+    std::atomic<size_t> count(0);
 
-    int ret = whisper_fuzzy(w, whisper_user_callback, &count);
+    int ret = whisper_fuzzy_streams(w, whisper_user_callback, &count);
     LOG_INFO("whisper ret: %d", ret);
 
     std::cout << "Task whisper completed" << std::endl;
@@ -55,7 +57,8 @@ int main(int argc, char const* argv[])
         return -1;
     }
 
-    // 启动多个线程，每个线程运行 task 函数
+    // 启动多个线程，每个线程运行 task 函数：每次 whisper_fuzzy_streams() 调用是独立的任务，
+    // 有自己的回调、计数器和推理状态，共享同一份模型
     for (int i = 0; i < numThreads; ++i) {
         threads.push_back(std::thread(whisper_fuzzy_task, w)); // 启动线程并传递参数
     }
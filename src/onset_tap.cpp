@@ -0,0 +1,76 @@
+#include "onset_tap.h"
+
+#include <algorithm>
+
+#include "debug.h"
+
+/**
+ * 初始化检测器。
+ *
+ * @param ring 检测到起点时唤醒的环形缓冲区，生命周期必须长于本对象的使用。
+ * @param sample_rate 采样率。
+ * @param frame_ms 帧长（毫秒）。
+ * @param freq_thold 高通滤波截止频率（Hz）。
+ * @param gate_db 判决门限高出噪声底的 dB 数。
+ * @param floor_db 判决门限下限（dBFS）。
+ * @param ceil_db 判决门限上限（dBFS）。
+ * @return 成功返回 true，失败返回 false。
+ */
+bool onset_tap_t::init(audio_ring_t *ring, int sample_rate, int frame_ms, float freq_thold,
+    float gate_db, float floor_db, float ceil_db)
+{
+    const size_t n_frame = (size_t) sample_rate * frame_ms / 1000;
+    if (!ring || n_frame == 0) {
+        LOG_ERR("bad onset detector params, sample rate %d, frame %d ms", sample_rate, frame_ms);
+        return false;
+    }
+
+    this->ring = ring;
+    gate.init(sample_rate, freq_thold, gate_db, floor_db, ceil_db);
+    frame.assign(n_frame, 0);
+    n_fill = 0;
+    pos = 0;
+    speech_end.store(0);
+    armed.store(false);
+    fired.store(false);
+
+    return true;
+}
+
+/**
+ * 接收一块样本（仅限采集线程调用），不阻塞。
+ *
+ * @param data 样本数据。
+ * @param n 样本数。
+ * @return 总是返回 true。
+ */
+bool onset_tap_t::push(const int16_t *data, size_t n)
+{
+    while (n > 0) {
+        const size_t k = std::min(n, frame.size() - n_fill);
+        std::copy(data, data + k, frame.begin() + n_fill);
+        n_fill += k;
+        data   += k;
+        n      -= k;
+
+        if (n_fill < frame.size()) {
+            break;
+        }
+        n_fill = 0;
+        pos += frame.size();
+
+        if (!gate.process(frame.data(), frame.size())) {
+            continue;
+        }
+        speech_end.store(pos);
+
+        if (armed.exchange(false)) {
+            at.store(pos - frame.size());
+            fired.store(true);
+            n_onsets.fetch_add(1, std::memory_order_relaxed);
+            ring->kick();
+        }
+    }
+
+    return true;
+}
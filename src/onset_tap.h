@@ -0,0 +1,98 @@
+#ifndef ONSET_TAP_H_
+#define ONSET_TAP_H_
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "audio_ring.h"
+#include "audio_tap.h"
+#include "energy_gate.h"
+
+/**
+ * 采集线程中的语音起点检测，用于省电模式。
+ *
+ * 每块样本按固定帧长交给 energy_gate_t，噪声底一直跟踪。会话进入省电状态时 arm()，
+ * 之后第一个语音帧就记下位置并 kick() 唤醒阻塞在 ring 上的会话线程，不必等到攒够一批样本。
+ * push() 只做滤波和求和，不加锁、不分配内存。
+ */
+struct onset_tap_t : audio_tap_t {
+    /**
+     * 初始化检测器。
+     *
+     * @param ring 检测到起点时唤醒的环形缓冲区，生命周期必须长于本对象的使用。
+     * @param sample_rate 采样率。
+     * @param frame_ms 帧长（毫秒）。
+     * @param freq_thold 高通滤波截止频率（Hz）。
+     * @param gate_db 判决门限高出噪声底的 dB 数。
+     * @param floor_db 判决门限下限（dBFS）。
+     * @param ceil_db 判决门限上限（dBFS）。
+     * @return 成功返回 true，失败返回 false。
+     */
+    bool init(audio_ring_t *ring, int sample_rate, int frame_ms, float freq_thold,
+        float gate_db, float floor_db, float ceil_db);
+
+    /**
+     * 接收一块样本（仅限采集线程调用），不阻塞。
+     *
+     * @param data 样本数据。
+     * @param n 样本数。
+     * @return 总是返回 true。
+     */
+    bool push(const int16_t *data, size_t n) override;
+
+    /**
+     * 开始等待语音起点（仅限会话线程调用）。
+     */
+    void arm() { fired.store(false); armed.store(true); }
+
+    /**
+     * 停止等待语音起点（仅限会话线程调用）。
+     *
+     * @return arm() 之后检测到过语音起点返回 true。
+     */
+    bool disarm() { armed.store(false); return fired.exchange(false); }
+
+    /**
+     * 获取 arm() 之后是否检测到过语音起点，不改变状态。
+     *
+     * @return 检测到过返回 true。
+     */
+    bool triggered() const { return fired.load(); }
+
+    /**
+     * 获取最近一次检测到的语音起点，即语音帧的第一个样本的位置，与 ring 的采样时钟一致。
+     *
+     * @return 起点位置（样本）。
+     */
+    uint64_t onset_at() const { return at.load(); }
+
+    /**
+     * 获取最近一个语音帧的终点，不论是否 arm()，与 ring 的采样时钟一致。
+     * 采集端领先于会话线程时（例如不限速读取文件），会话线程据此判断还没读到的样本里有没有语音。
+     *
+     * @return 终点位置（样本），还没有语音帧时为 0。
+     */
+    uint64_t last_speech() const { return speech_end.load(); }
+
+    /**
+     * 获取累计唤醒次数。
+     *
+     * @return 唤醒次数。
+     */
+    uint64_t onsets() const { return n_onsets.load(std::memory_order_relaxed); }
+
+private:
+    audio_ring_t *ring = nullptr;           ///< 唤醒的环形缓冲区
+    energy_gate_t gate;                     ///< 逐帧能量门限（仅采集线程）
+    std::vector<int16_t> frame;             ///< 不足一帧的样本（仅采集线程）
+    size_t n_fill = 0;                      ///< frame 中已有的样本数
+    uint64_t pos = 0;                       ///< 已检测的完整帧的样本总数（仅采集线程）
+    std::atomic<uint64_t> at{0};            ///< 最近一次语音起点的位置
+    std::atomic<uint64_t> speech_end{0};    ///< 最近一个语音帧的终点
+    std::atomic<bool> armed{false};         ///< 是否在等待语音起点
+    std::atomic<bool> fired{false};         ///< arm() 之后是否检测到过语音起点
+    std::atomic<uint64_t> n_onsets{0};      ///< 累计唤醒次数
+};
+
+#endif  // ONSET_TAP_H_
@@ -0,0 +1,41 @@
+#include "overload.h"
+
+/**
+ * 解析过载策略名称。
+ *
+ * @param name 策略名称：drop、skip、shrink 或 vad。
+ * @param policy 输出的策略。
+ * @return 成功返回 true，未知名称返回 false。
+ */
+bool overload_policy_parse(const std::string &name, overload_policy_t &policy)
+{
+    if (name == "drop") {
+        policy = OVERLOAD_DROP;
+    } else if (name == "skip") {
+        policy = OVERLOAD_SKIP;
+    } else if (name == "shrink") {
+        policy = OVERLOAD_SHRINK;
+    } else if (name == "vad") {
+        policy = OVERLOAD_VAD;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * 获取过载策略名称，用于日志。
+ *
+ * @param policy 策略。
+ * @return 策略名称。
+ */
+const char *overload_policy_name(overload_policy_t policy)
+{
+    switch (policy) {
+        case OVERLOAD_DROP:   return "drop";
+        case OVERLOAD_SKIP:   return "skip";
+        case OVERLOAD_SHRINK: return "shrink";
+        case OVERLOAD_VAD:    return "vad";
+    }
+    return "unknown";
+}
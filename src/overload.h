@@ -0,0 +1,61 @@
+#ifndef OVERLOAD_H_
+#define OVERLOAD_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * 推理跟不上采集（积压超过阈值）时的处理策略。
+ */
+typedef enum {
+    OVERLOAD_DROP = 0,  ///< 丢弃积压中最旧的音频，只处理最新的音频
+    OVERLOAD_SKIP,      ///< 积压音频照常进入分析窗口，但跳过中间窗口的推理，只推理最新窗口
+    OVERLOAD_SHRINK,    ///< 每次推理把送入的音频长度减半以缩短推理耗时，追上后逐步恢复
+    OVERLOAD_VAD,       ///< step 模式过载期间只在新音频中检测到语音时才推理
+} overload_policy_t;
+
+/**
+ * 过载统计，只由识别会话线程更新。
+ */
+struct overload_stats_t {
+    uint64_t n_events   = 0;    ///< 进入过载状态的次数
+    uint64_t n_dropped  = 0;    ///< 按策略丢弃的样本数
+    uint64_t n_skipped  = 0;    ///< 跳过推理的窗口数
+    uint64_t n_polls    = 0;    ///< 记录队列深度的次数
+    uint64_t depth_sum  = 0;    ///< 队列深度累加（样本数）
+    size_t   depth_max  = 0;    ///< 最大队列深度（样本数）
+
+    /**
+     * 记录一次等待新样本后的队列深度。
+     *
+     * @param n 环形缓冲区中待处理的样本数。
+     */
+    void depth(size_t n)
+    {
+        n_polls++;
+        depth_sum += n;
+        if (n > depth_max) {
+            depth_max = n;
+        }
+    }
+};
+
+/**
+ * 解析过载策略名称。
+ *
+ * @param name 策略名称：drop、skip、shrink 或 vad。
+ * @param policy 输出的策略。
+ * @return 成功返回 true，未知名称返回 false。
+ */
+bool overload_policy_parse(const std::string &name, overload_policy_t &policy);
+
+/**
+ * 获取过载策略名称，用于日志。
+ *
+ * @param policy 策略。
+ * @return 策略名称。
+ */
+const char *overload_policy_name(overload_policy_t policy);
+
+#endif  // OVERLOAD_H_
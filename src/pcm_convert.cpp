@@ -0,0 +1,144 @@
+#include "pcm_convert.h"
+
+#include <cmath>
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define PCM_CONVERT_NEON
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define PCM_CONVERT_AVX2
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define PCM_CONVERT_SSE2
+#endif
+
+/**
+ * 单个浮点样本转换为 16 位整数，四舍五入并饱和。
+ *
+ * @param v 浮点样本。
+ * @return 16 位整数样本。
+ */
+static inline int16_t pcm_f32_to_s16_one(float v)
+{
+    v = v < -1.0f ? -1.0f : (v > 1.0f ? 1.0f : v);
+    long s = lrintf(v * 32768.0f);
+    return (int16_t)(s > 32767 ? 32767 : s);
+}
+
+/**
+ * 16 位整数样本转换为浮点样本，范围 [-1, 1)。
+ * 根据编译目标使用 NEON、AVX2 或 SSE2 实现，其余平台使用标量实现。
+ *
+ * @param src 输入样本。
+ * @param dst 输出样本，不能与 src 重叠。
+ * @param n 样本数。
+ */
+void pcm_s16_to_f32(const int16_t *src, float *dst, size_t n)
+{
+    const float scale = 1.0f / 32768.0f;
+    size_t i = 0;
+
+#if defined(PCM_CONVERT_NEON)
+    const float32x4_t vscale = vdupq_n_f32(scale);
+    for (; i + 8 <= n; i += 8) {
+        const int16x8_t x = vld1q_s16(src + i);
+        vst1q_f32(dst + i,     vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(x))),  vscale));
+        vst1q_f32(dst + i + 4, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(x))), vscale));
+    }
+#elif defined(PCM_CONVERT_AVX2)
+    const __m256 vscale = _mm256_set1_ps(scale);
+    for (; i + 16 <= n; i += 16) {
+        const __m256i x0 = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(src + i)));
+        const __m256i x1 = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(src + i + 8)));
+        _mm256_storeu_ps(dst + i,     _mm256_mul_ps(_mm256_cvtepi32_ps(x0), vscale));
+        _mm256_storeu_ps(dst + i + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(x1), vscale));
+    }
+#elif defined(PCM_CONVERT_SSE2)
+    const __m128 vscale = _mm_set1_ps(scale);
+    for (; i + 8 <= n; i += 8) {
+        const __m128i x = _mm_loadu_si128((const __m128i *)(src + i));
+        // 与自身交错后算术右移 16 位即为符号扩展
+        const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+        const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+        _mm_storeu_ps(dst + i,     _mm_mul_ps(_mm_cvtepi32_ps(lo), vscale));
+        _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), vscale));
+    }
+#endif
+
+    for (; i < n; i++) {
+        dst[i] = src[i] * scale;
+    }
+}
+
+/**
+ * 浮点样本转换为 16 位整数样本，四舍五入并饱和到 [-32768, 32767]。
+ * 根据编译目标使用 NEON、AVX2 或 SSE2 实现，其余平台使用标量实现。
+ *
+ * @param src 输入样本。
+ * @param dst 输出样本，不能与 src 重叠。
+ * @param n 样本数。
+ */
+void pcm_f32_to_s16(const float *src, int16_t *dst, size_t n)
+{
+    size_t i = 0;
+
+#if defined(PCM_CONVERT_NEON)
+    const float32x4_t vmin   = vdupq_n_f32(-1.0f);
+    const float32x4_t vmax   = vdupq_n_f32( 1.0f);
+    const float32x4_t vscale = vdupq_n_f32(32768.0f);
+    for (; i + 8 <= n; i += 8) {
+        const float32x4_t a = vminq_f32(vmaxq_f32(vld1q_f32(src + i),     vmin), vmax);
+        const float32x4_t b = vminq_f32(vmaxq_f32(vld1q_f32(src + i + 4), vmin), vmax);
+        const int32x4_t ia = vcvtnq_s32_f32(vmulq_f32(a, vscale));
+        const int32x4_t ib = vcvtnq_s32_f32(vmulq_f32(b, vscale));
+        vst1q_s16(dst + i, vcombine_s16(vqmovn_s32(ia), vqmovn_s32(ib)));
+    }
+#elif defined(PCM_CONVERT_AVX2)
+    const __m256 vmin   = _mm256_set1_ps(-1.0f);
+    const __m256 vmax   = _mm256_set1_ps( 1.0f);
+    const __m256 vscale = _mm256_set1_ps(32768.0f);
+    for (; i + 16 <= n; i += 16) {
+        const __m256 a = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(src + i),     vmin), vmax);
+        const __m256 b = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(src + i + 8), vmin), vmax);
+        const __m256i ia = _mm256_cvtps_epi32(_mm256_mul_ps(a, vscale));
+        const __m256i ib = _mm256_cvtps_epi32(_mm256_mul_ps(b, vscale));
+        // packs 按 128 位通道交错，需要重新排列 64 位块恢复顺序
+        const __m256i s = _mm256_permute4x64_epi64(_mm256_packs_epi32(ia, ib), 0xD8);
+        _mm256_storeu_si256((__m256i *)(dst + i), s);
+    }
+#elif defined(PCM_CONVERT_SSE2)
+    const __m128 vmin   = _mm_set1_ps(-1.0f);
+    const __m128 vmax   = _mm_set1_ps( 1.0f);
+    const __m128 vscale = _mm_set1_ps(32768.0f);
+    for (; i + 8 <= n; i += 8) {
+        const __m128 a = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i),     vmin), vmax);
+        const __m128 b = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i + 4), vmin), vmax);
+        const __m128i ia = _mm_cvtps_epi32(_mm_mul_ps(a, vscale));
+        const __m128i ib = _mm_cvtps_epi32(_mm_mul_ps(b, vscale));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_packs_epi32(ia, ib));
+    }
+#endif
+
+    for (; i < n; i++) {
+        dst[i] = pcm_f32_to_s16_one(src[i]);
+    }
+}
+
+/**
+ * 获取当前编译使用的转换实现名称，用于日志。
+ *
+ * @return 实现名称：neon、avx2、sse2 或 scalar。
+ */
+const char *pcm_convert_impl()
+{
+#if defined(PCM_CONVERT_NEON)
+    return "neon";
+#elif defined(PCM_CONVERT_AVX2)
+    return "avx2";
+#elif defined(PCM_CONVERT_SSE2)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,34 @@
+#ifndef PCM_CONVERT_H_
+#define PCM_CONVERT_H_
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * 16 位整数样本转换为浮点样本，范围 [-1, 1)。
+ * 根据编译目标使用 NEON、AVX2 或 SSE2 实现，其余平台使用标量实现。
+ *
+ * @param src 输入样本。
+ * @param dst 输出样本，不能与 src 重叠。
+ * @param n 样本数。
+ */
+void pcm_s16_to_f32(const int16_t *src, float *dst, size_t n);
+
+/**
+ * 浮点样本转换为 16 位整数样本，四舍五入并饱和到 [-32768, 32767]。
+ * 根据编译目标使用 NEON、AVX2 或 SSE2 实现，其余平台使用标量实现。
+ *
+ * @param src 输入样本。
+ * @param dst 输出样本，不能与 src 重叠。
+ * @param n 样本数。
+ */
+void pcm_f32_to_s16(const float *src, int16_t *dst, size_t n);
+
+/**
+ * 获取当前编译使用的转换实现名称，用于日志。
+ *
+ * @return 实现名称：neon、avx2、sse2 或 scalar。
+ */
+const char *pcm_convert_impl();
+
+#endif  // PCM_CONVERT_H_
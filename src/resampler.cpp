@@ -0,0 +1,282 @@
+#include "resampler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#include "pcm_convert.h"
+#include "debug.h"
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define RESAMPLER_NEON
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define RESAMPLER_AVX2
+#elif defined(__SSE2__)
+#include <xmmintrin.h>
+#define RESAMPLER_SSE
+#endif
+
+/**
+ * 求最大公约数。
+ *
+ * @param a 整数 a。
+ * @param b 整数 b。
+ * @return 最大公约数。
+ */
+static int resampler_gcd(int a, int b)
+{
+    while (b) {
+        const int t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+/**
+ * 第一类零阶修正贝塞尔函数 I0，用于 Kaiser 窗。
+ *
+ * @param x 自变量。
+ * @return I0(x)。
+ */
+static double resampler_bessel_i0(double x)
+{
+    double sum  = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 64; k++) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum  += term;
+        if (term < sum * 1e-12) {
+            break;
+        }
+    }
+    return sum;
+}
+
+/**
+ * 计算两个浮点数组的点积，n 必须是 8 的倍数。
+ *
+ * @param a 数组 a。
+ * @param b 数组 b。
+ * @param n 元素个数。
+ * @return 点积。
+ */
+static inline float resampler_dot(const float *a, const float *b, int n)
+{
+#if defined(RESAMPLER_NEON)
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    for (int i = 0; i < n; i += 8) {
+        acc0 = vfmaq_f32(acc0, vld1q_f32(a + i),     vld1q_f32(b + i));
+        acc1 = vfmaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+    }
+    return vaddvq_f32(vaddq_f32(acc0, acc1));
+#elif defined(RESAMPLER_AVX2)
+    __m256 acc = _mm256_setzero_ps();
+    for (int i = 0; i < n; i += 8) {
+        acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+    }
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+    return _mm_cvtss_f32(s);
+#elif defined(RESAMPLER_SSE)
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    for (int i = 0; i < n; i += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i),     _mm_loadu_ps(b + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    __m128 s = _mm_add_ps(acc0, acc1);
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+    return _mm_cvtss_f32(s);
+#else
+    float sum = 0.0f;
+    for (int i = 0; i < n; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+#endif
+}
+
+/**
+ * 设计滤波器并分配缓冲区。
+ *
+ * @param rate_in 输入采样率。
+ * @param rate_out 输出采样率。
+ * @param max_block 单次 process() 的最大输入样本数，用于预分配缓冲区。
+ * @param taps 每个相位的抽头数，向上取整为 8 的倍数。
+ * @return 成功返回 true，失败返回 false。
+ */
+bool resampler_t::init(int rate_in, int rate_out, size_t max_block, int taps)
+{
+    if (rate_in <= 0 || rate_out <= 0 || max_block == 0 || taps <= 0) {
+        LOG_ERR("bad resampler args: %d -> %d, block %zu, taps %d", rate_in, rate_out, max_block, taps);
+        return false;
+    }
+
+    const int g = resampler_gcd(rate_in, rate_out);
+    this->rate_in  = rate_in;
+    this->rate_out = rate_out;
+    up   = rate_out / g;
+    down = rate_in  / g;
+
+    if (!active()) {
+        return true;
+    }
+
+    n_taps = (taps + 7) / 8 * 8;
+
+    // 原型滤波器工作在 L 倍上采样率下，截止频率取输入、输出中较低奈奎斯特频率的 90%
+    const int    n_proto = up * n_taps;
+    const double fc      = 0.5 * 0.9 / std::max(up, down);
+    const double beta    = 8.0;     // 阻带衰减约 80 dB
+    const double center  = 0.5 * (n_proto - 1);
+    const double i0_beta = resampler_bessel_i0(beta);
+
+    std::vector<double> proto(n_proto);
+    for (int k = 0; k < n_proto; k++) {
+        const double x = k - center;
+        const double r = x / (0.5 * n_proto);
+        const double w = resampler_bessel_i0(beta * sqrt(std::max(0.0, 1.0 - r * r))) / i0_beta;
+        const double s = x == 0.0 ? 1.0 : sin(2.0 * M_PI * fc * x) / (2.0 * M_PI * fc * x);
+        proto[k] = 2.0 * fc * s * w;
+    }
+
+    // 拆成 up 组，第 ph 组第 j 个系数乘以 x[idx - j]，倒序存放以便与输入做正序点积；
+    // 每组单独归一化，保证各相位的直流增益都是 1
+    coefs.assign((size_t)up * n_taps, 0.0f);
+    for (int ph = 0; ph < up; ph++) {
+        double sum = 0.0;
+        for (int j = 0; j < n_taps; j++) {
+            sum += proto[ph + j * up];
+        }
+        for (int j = 0; j < n_taps; j++) {
+            coefs[(size_t)ph * n_taps + (n_taps - 1 - j)] = (float)(proto[ph + j * up] / sum);
+        }
+    }
+
+    hist.assign(n_taps - 1 + max_block, 0.0f);
+    tmp.assign(max_output(max_block), 0.0f);
+
+    reset();
+
+    LOG_INFO("resampler %d -> %d Hz: L/M = %d/%d, %d taps per phase, %s",
+        rate_in, rate_out, up, down, n_taps, impl());
+
+    return true;
+}
+
+/**
+ * 重采样一块样本。
+ *
+ * @param in 输入样本。
+ * @param n 输入样本数。
+ * @param out 输出缓冲区，至少能容纳 max_output(n) 个样本。
+ * @return 输出样本数。
+ */
+size_t resampler_t::process(const int16_t *in, size_t n, int16_t *out)
+{
+    if (!active()) {
+        memcpy(out, in, n * sizeof(int16_t));
+        return n;
+    }
+
+    const auto t0 = std::chrono::steady_clock::now();
+
+    const size_t base      = n_taps - 1;
+    const size_t max_block = hist.size() - base;
+    const size_t n_total   = n;
+    size_t n_produced = 0;
+
+    while (n > 0) {
+        const size_t k = std::min(n, max_block);
+        pcm_s16_to_f32(in, hist.data() + base, k);
+
+        const size_t len = base + k;
+        size_t o = 0;
+        while (next < len) {
+            tmp[o++] = resampler_dot(coefs.data() + (size_t)phase * n_taps, hist.data() + next - base, n_taps);
+            phase += down;
+            next  += phase / up;
+            phase %= up;
+        }
+
+        pcm_f32_to_s16(tmp.data(), out + n_produced, o);
+        n_produced += o;
+
+        // 保留最后 n_taps - 1 个输入作为下一块的历史
+        memmove(hist.data(), hist.data() + k, base * sizeof(float));
+        next -= k;
+        in   += k;
+        n    -= k;
+    }
+
+    const uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - t0).count();
+
+    n_blocks.fetch_add(1, std::memory_order_relaxed);
+    n_in.fetch_add(n_total, std::memory_order_relaxed);
+    n_out.fetch_add(n_produced, std::memory_order_relaxed);
+    ns_total.fetch_add(ns, std::memory_order_relaxed);
+    if (ns > ns_max.load(std::memory_order_relaxed)) {
+        ns_max.store(ns, std::memory_order_relaxed);
+    }
+
+    return n_produced;
+}
+
+/**
+ * 清空滤波器历史和统计。
+ */
+void resampler_t::reset()
+{
+    std::fill(hist.begin(), hist.end(), 0.0f);
+    phase = 0;
+    next  = n_taps > 0 ? n_taps - 1 : 0;
+
+    n_blocks = 0;
+    n_in     = 0;
+    n_out    = 0;
+    ns_total = 0;
+    ns_max   = 0;
+}
+
+/**
+ * 获取耗时统计快照。
+ *
+ * @return 统计数据。
+ */
+resampler_stats_t resampler_t::stats() const
+{
+    resampler_stats_t s;
+    s.n_blocks = n_blocks.load(std::memory_order_relaxed);
+    s.n_in     = n_in.load(std::memory_order_relaxed);
+    s.n_out    = n_out.load(std::memory_order_relaxed);
+    s.ns_total = ns_total.load(std::memory_order_relaxed);
+    s.ns_max   = ns_max.load(std::memory_order_relaxed);
+    return s;
+}
+
+/**
+ * 获取当前编译使用的点积实现名称，用于日志。
+ *
+ * @return 实现名称：neon、avx2、sse 或 scalar。
+ */
+const char *resampler_t::impl()
+{
+#if defined(RESAMPLER_NEON)
+    return "neon";
+#elif defined(RESAMPLER_AVX2)
+    return "avx2";
+#elif defined(RESAMPLER_SSE)
+    return "sse";
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,107 @@
+#ifndef RESAMPLER_H_
+#define RESAMPLER_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * 重采样阶段的耗时统计。
+ */
+struct resampler_stats_t {
+    uint64_t n_blocks  = 0;     ///< 处理的块数
+    uint64_t n_in      = 0;     ///< 输入样本数
+    uint64_t n_out     = 0;     ///< 输出样本数
+    uint64_t ns_total  = 0;     ///< 累计耗时（纳秒）
+    uint64_t ns_max    = 0;     ///< 单块最大耗时（纳秒）
+};
+
+/**
+ * 流式多相 FIR 重采样器，用于把设备原生采样率（44.1/48 kHz 等）转换为 16 kHz。
+ *
+ * 采样率比化简为 L/M 后，原型低通滤波器（Kaiser 窗 sinc）按相位拆成 L 组，
+ * 每个输出样本只计算一组系数与最近 taps 个输入样本的点积，
+ * 点积根据编译目标使用 NEON、AVX2 或 SSE 实现。
+ *
+ * 块与块之间保留滤波器历史，任意切分输入得到的输出完全相同。
+ * process() 只由一个线程调用；stats() 可以在其他线程读取。
+ */
+struct resampler_t {
+    /**
+     * 设计滤波器并分配缓冲区。
+     *
+     * @param rate_in 输入采样率。
+     * @param rate_out 输出采样率。
+     * @param max_block 单次 process() 的最大输入样本数，用于预分配缓冲区。
+     * @param taps 每个相位的抽头数，向上取整为 8 的倍数。
+     * @return 成功返回 true，失败返回 false。
+     */
+    bool init(int rate_in, int rate_out, size_t max_block, int taps = 64);
+
+    /**
+     * 重采样一块样本。
+     *
+     * @param in 输入样本。
+     * @param n 输入样本数。
+     * @param out 输出缓冲区，至少能容纳 max_output(n) 个样本。
+     * @return 输出样本数。
+     */
+    size_t process(const int16_t *in, size_t n, int16_t *out);
+
+    /**
+     * 获取 n 个输入样本最多产生的输出样本数。
+     *
+     * @param n 输入样本数。
+     * @return 最大输出样本数。
+     */
+    size_t max_output(size_t n) const { return (n * up + down - 1) / down + 1; }
+
+    /**
+     * 清空滤波器历史和统计。
+     */
+    void reset();
+
+    /**
+     * 是否需要重采样（输入输出采样率不同）。
+     *
+     * @return 需要重采样返回 true。
+     */
+    bool active() const { return up != down; }
+
+    /**
+     * 获取耗时统计快照。
+     *
+     * @return 统计数据。
+     */
+    resampler_stats_t stats() const;
+
+    /**
+     * 获取当前编译使用的点积实现名称，用于日志。
+     *
+     * @return 实现名称：neon、avx2、sse 或 scalar。
+     */
+    static const char *impl();
+
+    int rate_in  = 0;   ///< 输入采样率
+    int rate_out = 0;   ///< 输出采样率
+
+private:
+    int up    = 1;              ///< 上采样因子 L
+    int down  = 1;              ///< 下采样因子 M
+    int n_taps = 0;             ///< 每个相位的抽头数
+    int phase = 0;              ///< 下一个输出样本的相位，范围 [0, up)
+    size_t next = 0;            ///< 下一个输出样本对应的最新输入样本在 hist 中的位置
+
+    std::vector<float> coefs;   ///< up 组系数，每组 n_taps 个，按时间正序排列
+    std::vector<float> hist;    ///< 输入历史（n_taps - 1 个）加上当前块
+    std::vector<float> tmp;     ///< 浮点输出缓冲
+
+    std::atomic<uint64_t> n_blocks{0};  ///< 处理的块数
+    std::atomic<uint64_t> n_in{0};      ///< 输入样本数
+    std::atomic<uint64_t> n_out{0};     ///< 输出样本数
+    std::atomic<uint64_t> ns_total{0};  ///< 累计耗时（纳秒）
+    std::atomic<uint64_t> ns_max{0};    ///< 单块最大耗时（纳秒）
+};
+
+#endif  // RESAMPLER_H_
@@ -0,0 +1,204 @@
+#include "rt_sched.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#endif
+
+#include "debug.h"
+
+/**
+ * 把调用线程切换到 SCHED_FIFO 实时调度，并输出实际得到的调度状态。
+ * 需要 CAP_SYS_NICE 或足够的 RLIMIT_RTPRIO，失败时线程保持原来的调度策略。
+ *
+ * @param priority 实时优先级（1 ~ 99）。
+ * @param who 线程名称，用于日志。
+ * @return 成功返回 true，失败返回 false。
+ */
+bool rt_sched_fifo(int priority, const char *who)
+{
+#ifdef __linux__
+    const int prio_min = sched_get_priority_min(SCHED_FIFO);
+    const int prio_max = sched_get_priority_max(SCHED_FIFO);
+
+    struct sched_param sp;
+    memset(&sp, 0, sizeof(sp));
+    sp.sched_priority = priority < prio_min ? prio_min : (priority > prio_max ? prio_max : priority);
+
+    const int err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &sp);
+    if (err != 0) {
+        LOG_ERR("%s: fail to set SCHED_FIFO priority %d: %s%s", who, sp.sched_priority, strerror(err),
+            err == EPERM ? " (needs CAP_SYS_NICE or an rtprio limit)" : "");
+    }
+    rt_sched_log(who);
+    return err == 0;
+#else
+    LOG_ERR("%s: real-time scheduling is only supported on Linux", who);
+    return false;
+#endif
+}
+
+/**
+ * 把调用线程绑定到指定的 CPU 集合，之后由它创建的线程（例如 ggml 的推理线程）继承该绑定。
+ *
+ * @param cpus CPU 编号列表。
+ * @param who 线程名称，用于日志。
+ * @return 成功返回 true，失败返回 false。
+ */
+bool rt_sched_pin(const std::vector<int> &cpus, const char *who)
+{
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        if (cpu < 0 || cpu >= CPU_SETSIZE) {
+            LOG_ERR("%s: bad cpu %d", who, cpu);
+            return false;
+        }
+        CPU_SET(cpu, &set);
+    }
+
+    const int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (err != 0) {
+        LOG_ERR("%s: fail to set cpu affinity: %s", who, strerror(err));
+    }
+    rt_sched_log(who);
+    return err == 0;
+#else
+    LOG_ERR("%s: cpu pinning is only supported on Linux", who);
+    return false;
+#endif
+}
+
+/**
+ * 锁定进程当前已映射的全部内存（模型权重、音频缓冲区等），推理时不会因缺页而停顿。
+ * 只锁定调用时已存在的映射，不影响之后的内存分配。
+ *
+ * @return 成功返回 true，失败返回 false（通常是 RLIMIT_MEMLOCK 不足）。
+ */
+bool rt_sched_lock_memory()
+{
+#ifdef __linux__
+    // 不使用 MCL_FUTURE：超出 RLIMIT_MEMLOCK 时之后的分配会直接失败
+    if (mlockall(MCL_CURRENT) != 0) {
+        const int err = errno;
+        struct rlimit rl;
+        if (getrlimit(RLIMIT_MEMLOCK, &rl) == 0 && rl.rlim_cur != RLIM_INFINITY) {
+            LOG_ERR("fail to lock memory: %s (RLIMIT_MEMLOCK = %llu KB)", strerror(err), (unsigned long long)(rl.rlim_cur / 1024));
+        } else {
+            LOG_ERR("fail to lock memory: %s", strerror(err));
+        }
+        return false;
+    }
+
+    // 从 /proc 读出实际锁定的大小，便于在生产环境中确认
+    FILE *fp = fopen("/proc/self/status", "r");
+    if (fp) {
+        char line[256];
+        while (fgets(line, sizeof(line), fp)) {
+            if (strncmp(line, "VmLck:", 6) == 0) {
+                LOG_INFO("memory locked: %.1f MB", strtoull(line + 6, nullptr, 10) / 1024.0);
+                break;
+            }
+        }
+        fclose(fp);
+    }
+    return true;
+#else
+    LOG_ERR("memory locking is only supported on Linux");
+    return false;
+#endif
+}
+
+/**
+ * 输出调用线程实际的调度策略、优先级和 CPU 绑定。
+ *
+ * @param who 线程名称，用于日志。
+ */
+void rt_sched_log(const char *who)
+{
+#ifdef __linux__
+    int policy = 0;
+    struct sched_param sp;
+    memset(&sp, 0, sizeof(sp));
+    if (pthread_getschedparam(pthread_self(), &policy, &sp) != 0) {
+        return;
+    }
+
+    const char *policy_name =
+        policy == SCHED_FIFO  ? "SCHED_FIFO"  :
+        policy == SCHED_RR    ? "SCHED_RR"    :
+        policy == SCHED_OTHER ? "SCHED_OTHER" : "other";
+
+    // CPU 列表按区间压缩输出，例如 "0-3"
+    std::string cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (pthread_getaffinity_np(pthread_self(), sizeof(set), &set) == 0) {
+        for (int i = 0; i < CPU_SETSIZE; i++) {
+            if (!CPU_ISSET(i, &set)) {
+                continue;
+            }
+            int j = i;
+            while (j + 1 < CPU_SETSIZE && CPU_ISSET(j + 1, &set)) {
+                j++;
+            }
+            char buf[32];
+            snprintf(buf, sizeof(buf), i == j ? "%s%d" : "%s%d-%d", cpus.empty() ? "" : ",", i, j);
+            cpus += buf;
+            i = j;
+        }
+    }
+
+    LOG_INFO("%s thread: %s priority %d, cpus %s", who, policy_name, sp.sched_priority, cpus.c_str());
+#else
+    (void)who;
+#endif
+}
+
+/**
+ * 解析 CPU 列表，例如 "2,3" 或 "0-1,4"。
+ *
+ * @param str CPU 列表字符串。
+ * @param cpus 输出的 CPU 编号。
+ * @return 成功返回 true，格式错误返回 false。
+ */
+bool rt_sched_parse_cpus(const std::string &str, std::vector<int> &cpus)
+{
+    cpus.clear();
+
+    const char *p = str.c_str();
+    while (*p) {
+        char *end = nullptr;
+        const long first = strtol(p, &end, 10);
+        if (end == p || first < 0) {
+            return false;
+        }
+        long last = first;
+        p = end;
+        if (*p == '-') {
+            last = strtol(p + 1, &end, 10);
+            if (end == p + 1 || last < first) {
+                return false;
+            }
+            p = end;
+        }
+        for (long i = first; i <= last; i++) {
+            cpus.push_back((int)i);
+        }
+        if (*p == ',') {
+            p++;
+        } else if (*p) {
+            return false;
+        }
+    }
+
+    return !cpus.empty();
+}
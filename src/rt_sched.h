@@ -0,0 +1,50 @@
+#ifndef RT_SCHED_H_
+#define RT_SCHED_H_
+
+#include <string>
+#include <vector>
+
+/**
+ * 把调用线程切换到 SCHED_FIFO 实时调度，并输出实际得到的调度状态。
+ * 需要 CAP_SYS_NICE 或足够的 RLIMIT_RTPRIO，失败时线程保持原来的调度策略。
+ *
+ * @param priority 实时优先级（1 ~ 99）。
+ * @param who 线程名称，用于日志。
+ * @return 成功返回 true，失败返回 false。
+ */
+bool rt_sched_fifo(int priority, const char *who);
+
+/**
+ * 把调用线程绑定到指定的 CPU 集合，之后由它创建的线程（例如 ggml 的推理线程）继承该绑定。
+ *
+ * @param cpus CPU 编号列表。
+ * @param who 线程名称，用于日志。
+ * @return 成功返回 true，失败返回 false。
+ */
+bool rt_sched_pin(const std::vector<int> &cpus, const char *who);
+
+/**
+ * 锁定进程当前已映射的全部内存（模型权重、音频缓冲区等），推理时不会因缺页而停顿。
+ * 只锁定调用时已存在的映射，不影响之后的内存分配。
+ *
+ * @return 成功返回 true，失败返回 false（通常是 RLIMIT_MEMLOCK 不足）。
+ */
+bool rt_sched_lock_memory();
+
+/**
+ * 输出调用线程实际的调度策略、优先级和 CPU 绑定。
+ *
+ * @param who 线程名称，用于日志。
+ */
+void rt_sched_log(const char *who);
+
+/**
+ * 解析 CPU 列表，例如 "2,3" 或 "0-1,4"。
+ *
+ * @param str CPU 列表字符串。
+ * @param cpus 输出的 CPU 编号。
+ * @return 成功返回 true，格式错误返回 false。
+ */
+bool rt_sched_parse_cpus(const std::string &str, std::vector<int> &cpus);
+
+#endif  // RT_SCHED_H_
@@ -0,0 +1,92 @@
+#ifndef STAGE_QUEUE_H_
+#define STAGE_QUEUE_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+/**
+ * 流水线两级之间的有界阻塞队列，容量固定，入队出队不分配内存。
+ *
+ * 队列满时 push() 阻塞，让上游跟着下游的节奏走；队列空时 pop() 阻塞。
+ * close() 之后 push() 立即失败，pop() 取完剩余元素后失败，下游据此排空退出。
+ * 元素一般是预先分配的缓冲区指针，用一对队列（空闲 / 待处理）在两级之间循环复用。
+ */
+template <typename T>
+struct stage_queue_t {
+    /**
+     * 分配队列空间并清空。
+     *
+     * @param capacity 容量，至少为 1。
+     */
+    void init(size_t capacity)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        slots.assign(capacity > 0 ? capacity : 1, T());
+        head   = 0;
+        count  = 0;
+        closed = false;
+    }
+
+    /**
+     * 入队，队列满时阻塞到有空位。
+     *
+     * @param item 元素。
+     * @return 成功返回 true，队列已关闭返回 false。
+     */
+    bool push(const T &item)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv_push.wait(lock, [this]() { return closed || count < slots.size(); });
+        if (closed) {
+            return false;
+        }
+        slots[(head + count) % slots.size()] = item;
+        count++;
+        cv_pop.notify_one();
+        return true;
+    }
+
+    /**
+     * 出队，队列空时阻塞到有元素。
+     *
+     * @param item 取出的元素。
+     * @return 成功返回 true，队列已关闭且为空返回 false。
+     */
+    bool pop(T &item)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv_pop.wait(lock, [this]() { return closed || count > 0; });
+        if (count == 0) {
+            return false;
+        }
+        item = slots[head];
+        head = (head + 1) % slots.size();
+        count--;
+        cv_push.notify_one();
+        return true;
+    }
+
+    /**
+     * 关闭队列并唤醒两端所有等待的线程。
+     */
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        cv_push.notify_all();
+        cv_pop.notify_all();
+    }
+
+private:
+    std::mutex mutex;                   ///< 保护以下成员
+    std::condition_variable cv_push;    ///< 有空位或已关闭
+    std::condition_variable cv_pop;     ///< 有元素或已关闭
+    std::vector<T> slots;               ///< 环形存放的元素
+    size_t head   = 0;                  ///< 队首下标
+    size_t count  = 0;                  ///< 元素个数
+    bool   closed = false;              ///< 是否已关闭
+};
+
+#endif  // STAGE_QUEUE_H_
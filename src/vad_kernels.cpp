@@ -0,0 +1,290 @@
+#include "vad_kernels.h"
+
+#include <cmath>
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define VAD_KERNELS_NEON
+#elif (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <immintrin.h>
+#define VAD_KERNELS_X86
+#endif
+
+/**
+ * 标量参考实现，用于校验向量实现。
+ *
+ * @param frame 帧数据。
+ * @param n 样本数。
+ * @param hpf 滤波器状态。
+ * @param sums 输出的统计量。
+ */
+void vad_frame_scalar(const int16_t *frame, size_t n, vad_hpf_t &hpf, vad_frame_sums_t &sums)
+{
+    const float a = hpf.a;
+    float x1 = hpf.x1;
+    float y1 = hpf.y1;
+    float sum_sq  = 0.0f;
+    float sum_abs = 0.0f;
+
+    for (size_t i = 0; i < n; ++i) {
+        const float x = frame[i];
+        y1 = a * (y1 + x - x1);
+        x1 = x;
+        sum_sq  += y1 * y1;
+        sum_abs += fabsf(y1);
+    }
+
+    hpf.x1 = x1;
+    hpf.y1 = y1;
+    sums.sum_sq  = sum_sq;
+    sums.sum_abs = sum_abs;
+}
+
+/**
+ * 处理向量实现剩下的不足一个向量的尾部样本，结果累加到 sums。
+ *
+ * @param frame 尾部样本。
+ * @param n 样本数。
+ * @param hpf 滤波器状态。
+ * @param sums 累加的统计量。
+ */
+static inline void vad_frame_tail(const int16_t *frame, size_t n, vad_hpf_t &hpf, vad_frame_sums_t &sums)
+{
+    vad_frame_sums_t tail;
+    vad_frame_scalar(frame, n, hpf, tail);
+    sums.sum_sq  += tail.sum_sq;
+    sums.sum_abs += tail.sum_abs;
+}
+
+#if defined(VAD_KERNELS_NEON)
+/**
+ * NEON 实现，每次 4 个样本。
+ *
+ * @param frame 帧数据。
+ * @param n 样本数。
+ * @param hpf 滤波器状态。
+ * @param sums 输出的统计量。
+ */
+static void vad_frame_neon(const int16_t *frame, size_t n, vad_hpf_t &hpf, vad_frame_sums_t &sums)
+{
+    const float a  = hpf.a;
+    const float a2 = a * a;
+    const float pw[4] = { a, a2, a2 * a, a2 * a2 };
+
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const float32x4_t vp   = vld1q_f32(pw);
+
+    float32x4_t xlast = vdupq_n_f32(hpf.x1);
+    float32x4_t vy1   = vdupq_n_f32(hpf.y1);
+    float32x4_t vsq   = zero;
+    float32x4_t vabs  = zero;
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const float32x4_t x  = vcvtq_f32_s32(vmovl_s16(vld1_s16(frame + i)));
+        const float32x4_t xp = vextq_f32(xlast, x, 3);
+
+        // 块内前缀扫描：t[k] = sum(a^j * b[k-j])
+        float32x4_t t = vmulq_n_f32(vsubq_f32(x, xp), a);
+        t = vmlaq_n_f32(t, vextq_f32(zero, t, 3), a);
+        t = vmlaq_n_f32(t, vextq_f32(zero, t, 2), a2);
+
+        const float32x4_t y = vmlaq_f32(t, vp, vy1);
+        vy1   = vdupq_laneq_f32(y, 3);
+        xlast = x;
+
+        vsq  = vmlaq_f32(vsq, y, y);
+        vabs = vaddq_f32(vabs, vabsq_f32(y));
+    }
+
+    if (i > 0) {
+        hpf.x1 = vgetq_lane_f32(xlast, 3);
+        hpf.y1 = vgetq_lane_f32(vy1, 3);
+    }
+    sums.sum_sq  = vaddvq_f32(vsq);
+    sums.sum_abs = vaddvq_f32(vabs);
+
+    vad_frame_tail(frame + i, n - i, hpf, sums);
+}
+#endif
+
+#if defined(VAD_KERNELS_X86)
+/**
+ * SSE4.1 实现，每次 4 个样本。
+ *
+ * @param frame 帧数据。
+ * @param n 样本数。
+ * @param hpf 滤波器状态。
+ * @param sums 输出的统计量。
+ */
+__attribute__((target("sse4.1")))
+static void vad_frame_sse4(const int16_t *frame, size_t n, vad_hpf_t &hpf, vad_frame_sums_t &sums)
+{
+    const float a  = hpf.a;
+    const float a2 = a * a;
+
+    const __m128 va   = _mm_set1_ps(a);
+    const __m128 va2  = _mm_set1_ps(a2);
+    const __m128 vp   = _mm_setr_ps(a, a2, a2 * a, a2 * a2);
+    const __m128 sign = _mm_set1_ps(-0.0f);
+
+    __m128 xlast = _mm_set1_ps(hpf.x1);
+    __m128 vy1   = _mm_set1_ps(hpf.y1);
+    __m128 vsq   = _mm_setzero_ps();
+    __m128 vabs  = _mm_setzero_ps();
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m128 x = _mm_cvtepi32_ps(_mm_cvtepi16_epi32(_mm_loadl_epi64((const __m128i *)(frame + i))));
+        // [xlast3, x0, x1, x2]
+        const __m128 xp = _mm_castsi128_ps(_mm_alignr_epi8(_mm_castps_si128(x), _mm_castps_si128(xlast), 12));
+
+        __m128 t = _mm_mul_ps(va, _mm_sub_ps(x, xp));
+        t = _mm_add_ps(t, _mm_mul_ps(va,  _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(t), 4))));
+        t = _mm_add_ps(t, _mm_mul_ps(va2, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(t), 8))));
+
+        const __m128 y = _mm_add_ps(t, _mm_mul_ps(vp, vy1));
+        vy1   = _mm_shuffle_ps(y, y, 0xFF);
+        xlast = x;
+
+        vsq  = _mm_add_ps(vsq, _mm_mul_ps(y, y));
+        vabs = _mm_add_ps(vabs, _mm_andnot_ps(sign, y));
+    }
+
+    if (i > 0) {
+        hpf.x1 = _mm_cvtss_f32(_mm_shuffle_ps(xlast, xlast, 0xFF));
+        hpf.y1 = _mm_cvtss_f32(vy1);
+    }
+
+    __m128 s = _mm_hadd_ps(vsq, vabs);
+    s = _mm_hadd_ps(s, s);
+    sums.sum_sq  = _mm_cvtss_f32(s);
+    sums.sum_abs = _mm_cvtss_f32(_mm_shuffle_ps(s, s, 0x55));
+
+    vad_frame_tail(frame + i, n - i, hpf, sums);
+}
+
+/**
+ * AVX2 实现，每次 8 个样本。
+ *
+ * @param frame 帧数据。
+ * @param n 样本数。
+ * @param hpf 滤波器状态。
+ * @param sums 输出的统计量。
+ */
+__attribute__((target("avx2")))
+static void vad_frame_avx2(const int16_t *frame, size_t n, vad_hpf_t &hpf, vad_frame_sums_t &sums)
+{
+    const float a  = hpf.a;
+    const float a2 = a * a;
+    const float a4 = a2 * a2;
+
+    const __m256 va   = _mm256_set1_ps(a);
+    const __m256 va2  = _mm256_set1_ps(a2);
+    const __m256 va4  = _mm256_set1_ps(a4);
+    const __m256 vp   = _mm256_setr_ps(a, a2, a2 * a, a4, a4 * a, a4 * a2, a4 * a2 * a, a4 * a4);
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    const __m256 zero = _mm256_setzero_ps();
+
+    // 跨 128 位通道的整体移位用 permutevar 加 blend 实现，低位补 0
+    const __m256i shift1 = _mm256_setr_epi32(0, 0, 1, 2, 3, 4, 5, 6);
+    const __m256i shift2 = _mm256_setr_epi32(0, 0, 0, 1, 2, 3, 4, 5);
+    const __m256i shift4 = _mm256_setr_epi32(0, 0, 0, 0, 0, 1, 2, 3);
+    const __m256i last   = _mm256_set1_epi32(7);
+
+    __m256 xlast = _mm256_set1_ps(hpf.x1);
+    __m256 vy1   = _mm256_set1_ps(hpf.y1);
+    __m256 vsq   = zero;
+    __m256 vabs  = zero;
+
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256 x  = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(frame + i))));
+        const __m256 xp = _mm256_blend_ps(_mm256_permutevar8x32_ps(x, shift1), xlast, 0x01);
+
+        __m256 t = _mm256_mul_ps(va, _mm256_sub_ps(x, xp));
+        t = _mm256_add_ps(t, _mm256_mul_ps(va,  _mm256_blend_ps(_mm256_permutevar8x32_ps(t, shift1), zero, 0x01)));
+        t = _mm256_add_ps(t, _mm256_mul_ps(va2, _mm256_blend_ps(_mm256_permutevar8x32_ps(t, shift2), zero, 0x03)));
+        t = _mm256_add_ps(t, _mm256_mul_ps(va4, _mm256_blend_ps(_mm256_permutevar8x32_ps(t, shift4), zero, 0x0F)));
+
+        const __m256 y = _mm256_add_ps(t, _mm256_mul_ps(vp, vy1));
+        vy1   = _mm256_permutevar8x32_ps(y, last);
+        xlast = _mm256_permutevar8x32_ps(x, last);
+
+        vsq  = _mm256_add_ps(vsq, _mm256_mul_ps(y, y));
+        vabs = _mm256_add_ps(vabs, _mm256_andnot_ps(sign, y));
+    }
+
+    if (i > 0) {
+        hpf.x1 = _mm256_cvtss_f32(xlast);
+        hpf.y1 = _mm256_cvtss_f32(vy1);
+    }
+
+    __m128 s = _mm_hadd_ps(_mm_add_ps(_mm256_castps256_ps128(vsq),  _mm256_extractf128_ps(vsq, 1)),
+                           _mm_add_ps(_mm256_castps256_ps128(vabs), _mm256_extractf128_ps(vabs, 1)));
+    s = _mm_hadd_ps(s, s);
+    sums.sum_sq  = _mm_cvtss_f32(s);
+    sums.sum_abs = _mm_cvtss_f32(_mm_shuffle_ps(s, s, 0x55));
+
+    vad_frame_tail(frame + i, n - i, hpf, sums);
+}
+#endif
+
+/**
+ * 获取当前 CPU 上可用的全部实现，第一个总是标量参考实现。用于基准测试和一致性校验。
+ *
+ * @return 可用实现列表。
+ */
+std::vector<vad_kernel_t> vad_kernels_available()
+{
+    std::vector<vad_kernel_t> list;
+    list.push_back({ "scalar", vad_frame_scalar });
+
+#if defined(VAD_KERNELS_NEON)
+    list.push_back({ "neon", vad_frame_neon });
+#elif defined(VAD_KERNELS_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.1")) {
+        list.push_back({ "sse4", vad_frame_sse4 });
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        list.push_back({ "avx2", vad_frame_avx2 });
+    }
+#endif
+
+    return list;
+}
+
+/**
+ * 选择当前 CPU 上最快的实现，即可用列表中的最后一个。
+ *
+ * @return 选中的实现。
+ */
+static const vad_kernel_t &vad_kernels_best()
+{
+    static const vad_kernel_t best = vad_kernels_available().back();
+    return best;
+}
+
+/**
+ * 用当前 CPU 上最快的实现处理一帧，第一次调用时选择实现。
+ *
+ * @param frame 帧数据。
+ * @param n 样本数。
+ * @param hpf 滤波器状态。
+ * @param sums 输出的统计量。
+ */
+void vad_frame(const int16_t *frame, size_t n, vad_hpf_t &hpf, vad_frame_sums_t &sums)
+{
+    vad_kernels_best().fn(frame, n, hpf, sums);
+}
+
+/**
+ * 获取 vad_frame() 选中的实现名称，用于日志。
+ *
+ * @return 实现名称：neon、avx2、sse4 或 scalar。
+ */
+const char *vad_kernels_impl()
+{
+    return vad_kernels_best().name;
+}
@@ -0,0 +1,81 @@
+#ifndef VAD_KERNELS_H_
+#define VAD_KERNELS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * 一阶高通滤波器 y[n] = a * (y[n-1] + x[n] - x[n-1]) 的状态，跨帧保持。
+ */
+struct vad_hpf_t {
+    float a  = 0.0f;        ///< 滤波系数 rc / (rc + dt)
+    float x1 = 0.0f;        ///< 上一个输入
+    float y1 = 0.0f;        ///< 上一个输出
+};
+
+/**
+ * 一帧滤波后样本的统计量。
+ */
+struct vad_frame_sums_t {
+    float sum_sq  = 0.0f;   ///< 平方和
+    float sum_abs = 0.0f;   ///< 绝对值和
+};
+
+/**
+ * 帧处理函数：高通滤波一帧 16 位样本并累计平方和与绝对值和，更新滤波器状态。
+ *
+ * @param frame 帧数据。
+ * @param n 样本数。
+ * @param hpf 滤波器状态。
+ * @param sums 输出的统计量。
+ */
+typedef void (*vad_frame_fn_t)(const int16_t *frame, size_t n, vad_hpf_t &hpf, vad_frame_sums_t &sums);
+
+/**
+ * 一个帧处理实现。
+ */
+struct vad_kernel_t {
+    const char *name;       ///< 实现名称
+    vad_frame_fn_t fn;      ///< 帧处理函数
+};
+
+/**
+ * 用当前 CPU 上最快的实现处理一帧，第一次调用时选择实现。
+ *
+ * 递推滤波在向量实现中按块做前缀扫描：块内先算 a * (x[n] - x[n-1])，
+ * 再用 log2(宽度) 次移位累加求出块内各位置对上一个输出的响应，
+ * 与标量实现只在浮点舍入上有差别。
+ *
+ * @param frame 帧数据。
+ * @param n 样本数。
+ * @param hpf 滤波器状态。
+ * @param sums 输出的统计量。
+ */
+void vad_frame(const int16_t *frame, size_t n, vad_hpf_t &hpf, vad_frame_sums_t &sums);
+
+/**
+ * 标量参考实现，用于校验向量实现。
+ *
+ * @param frame 帧数据。
+ * @param n 样本数。
+ * @param hpf 滤波器状态。
+ * @param sums 输出的统计量。
+ */
+void vad_frame_scalar(const int16_t *frame, size_t n, vad_hpf_t &hpf, vad_frame_sums_t &sums);
+
+/**
+ * 获取 vad_frame() 选中的实现名称，用于日志。
+ *
+ * @return 实现名称：neon、avx2、sse4 或 scalar。
+ */
+const char *vad_kernels_impl();
+
+/**
+ * 获取当前 CPU 上可用的全部实现，第一个总是标量参考实现。用于基准测试和一致性校验。
+ *
+ * @return 可用实现列表。
+ */
+std::vector<vad_kernel_t> vad_kernels_available();
+
+#endif  // VAD_KERNELS_H_
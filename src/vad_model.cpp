@@ -0,0 +1,84 @@
+#include "vad_model.h"
+
+#include <cstdio>
+
+#include "debug.h"
+#include "energy_gate.h"
+
+/**
+ * 能量判决模型，即原来 frame_vad_t 内置的 energy_gate_t。
+ */
+struct vad_model_energy_t : vad_model_t {
+    energy_gate_t gate;     ///< 逐帧能量门限
+
+    bool process(const int16_t *frame, size_t n) override { return gate.process(frame, n); }
+    float energy() const override { return gate.energy(); }
+    float magnitude() const override { return gate.magnitude(); }
+    float noise() const override { return gate.noise(); }
+    float threshold() const override { return gate.threshold(); }
+    const char *name() const override { return "energy"; }
+};
+
+/**
+ * 根据参数创建判决模型。
+ *
+ * @param params 模型参数。
+ * @return 成功返回模型指针（由调用者 delete），失败返回 nullptr。
+ */
+vad_model_t *vad_model_create(const vad_model_params_t &params)
+{
+    vad_model_t *model = nullptr;
+
+    switch (params.type) {
+        case VAD_MODEL_ENERGY: {
+            vad_model_energy_t *energy = new vad_model_energy_t;
+            energy->gate.init(params.sample_rate, params.freq_thold, params.gate_db, params.floor_db, params.ceil_db);
+            model = energy;
+            break;
+        }
+        case VAD_MODEL_GMM:
+            model = vad_model_gmm_create(params);
+            break;
+    }
+
+    if (!model) {
+        LOG_ERR("fail to create vad model, type: %d", params.type);
+        return nullptr;
+    }
+
+    return model;
+}
+
+/**
+ * 解析判决模型名称。
+ *
+ * @param name 模型名称：energy 或 gmm。
+ * @param type 输出的模型类型。
+ * @return 成功返回 true，未知名称返回 false。
+ */
+bool vad_model_parse(const std::string &name, vad_model_type_t &type)
+{
+    if (name == "energy") {
+        type = VAD_MODEL_ENERGY;
+    } else if (name == "gmm") {
+        type = VAD_MODEL_GMM;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * 获取判决模型名称，用于日志。
+ *
+ * @param type 模型类型。
+ * @return 模型名称。
+ */
+const char *vad_model_name(vad_model_type_t type)
+{
+    switch (type) {
+        case VAD_MODEL_ENERGY: return "energy";
+        case VAD_MODEL_GMM:    return "gmm";
+    }
+    return "unknown";
+}
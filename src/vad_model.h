@@ -0,0 +1,117 @@
+#ifndef VAD_MODEL_H_
+#define VAD_MODEL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * 逐帧语音判决模型类型。
+ */
+typedef enum {
+    VAD_MODEL_ENERGY = 0,   ///< 高通滤波后的帧能量与跟踪的噪声底比较
+    VAD_MODEL_GMM,          ///< 子带对数能量特征上的语音/噪声高斯混合模型
+} vad_model_type_t;
+
+/**
+ * 判决模型创建参数。
+ */
+struct vad_model_params_t {
+    vad_model_type_t type = VAD_MODEL_ENERGY;   ///< 模型类型
+    int   sample_rate = 16000;                  ///< 采样率
+    int   frame_ms    = 20;                     ///< 帧长（毫秒），gmm：帧长的样本数必须是 32（8 kHz 为 16）的倍数
+    float freq_thold  = 100.0f;                 ///< 电平测量的高通滤波截止频率（Hz）
+    float gate_db     = 10.0f;                  ///< 能量门限高出噪声底的 dB 数
+    float floor_db    = -60.0f;                 ///< 能量门限下限（dBFS），低于该能量的帧一律判为静音
+    float ceil_db     = 0.0f;                   ///< 能量门限上限（dBFS），energy：高于该能量的帧一律判为语音
+    int   mode        = 1;                      ///< gmm：激进程度 0 ~ 3，越大越不容易判为语音
+};
+
+/**
+ * 逐帧语音判决接口，由 frame_vad_t 调用，帧长固定。
+ *
+ * 除了判决结果，每个模型还要给出高通滤波后的帧电平，frame_vad_t 用它做基于幅度比的结束判决。
+ */
+struct vad_model_t {
+    virtual ~vad_model_t() {}
+
+    /**
+     * 处理一帧样本。
+     *
+     * @param frame 帧数据。
+     * @param n 帧长度（样本数）。
+     * @return 判为语音返回 true。
+     */
+    virtual bool process(const int16_t *frame, size_t n) = 0;
+
+    /**
+     * 获取最近一帧的能量。
+     *
+     * @return 能量（dBFS）。
+     */
+    virtual float energy() const = 0;
+
+    /**
+     * 获取最近一帧高通滤波后的平均幅度。
+     *
+     * @return 平均幅度（满量程为 32768）。
+     */
+    virtual float magnitude() const = 0;
+
+    /**
+     * 获取跟踪的噪声底。
+     *
+     * @return 噪声底（dBFS）。
+     */
+    virtual float noise() const = 0;
+
+    /**
+     * 获取当前的能量判决门限：噪声底加上设定的余量，限制在设定的上下限之内。
+     * 能量低于门限的帧一定判为静音；energy 模型高于门限即判为语音，gmm 模型还要看子带似然比。
+     *
+     * @return 判决门限（dBFS）。
+     */
+    virtual float threshold() const = 0;
+
+    /**
+     * 获取模型名称，用于日志。
+     *
+     * @return 名称。
+     */
+    virtual const char *name() const = 0;
+};
+
+/**
+ * 根据参数创建判决模型。
+ *
+ * @param params 模型参数。
+ * @return 成功返回模型指针（由调用者 delete），失败返回 nullptr。
+ */
+vad_model_t *vad_model_create(const vad_model_params_t &params);
+
+/**
+ * 创建子带高斯混合模型。
+ *
+ * @param params 模型参数。
+ * @return 成功返回模型指针，采样率或帧长不支持时返回 nullptr。
+ */
+vad_model_t *vad_model_gmm_create(const vad_model_params_t &params);
+
+/**
+ * 解析判决模型名称。
+ *
+ * @param name 模型名称：energy 或 gmm。
+ * @param type 输出的模型类型。
+ * @return 成功返回 true，未知名称返回 false。
+ */
+bool vad_model_parse(const std::string &name, vad_model_type_t &type);
+
+/**
+ * 获取判决模型名称，用于日志。
+ *
+ * @param type 模型类型。
+ * @return 模型名称。
+ */
+const char *vad_model_name(vad_model_type_t type);
+
+#endif  // VAD_MODEL_H_
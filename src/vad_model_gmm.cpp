@@ -0,0 +1,495 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "debug.h"
+#include "vad_kernels.h"
+#include "vad_model.h"
+
+#define VAD_GMM_BANDS       6       ///< 子带数：80~250、250~500、500~1k、1k~2k、2k~3k、3k~4k Hz
+#define VAD_GMM_TRACKED     (VAD_GMM_BANDS + 1) ///< 跟踪最小值的量：各子带能量和整帧能量
+#define VAD_GMM_MIXTURES    2       ///< 每个子带每个模型的高斯分量数
+#define VAD_GMM_COEF_UP     5571    ///< 半带分解上支路（偶数样本）全通系数，Q15
+#define VAD_GMM_COEF_LO     20972   ///< 半带分解下支路（奇数样本，延迟一个样本）全通系数，Q15
+#define VAD_GMM_WARMUP      10      ///< 开头按噪声处理并快速学习的帧数
+#define VAD_GMM_MIN_SEP     8.0f    ///< 语音模型均值至少高出噪声模型均值的 dB 数
+#define VAD_GMM_MIN_MS      2000    ///< 子带最小能量的跟踪窗口（毫秒），长于一次冲击声，短于一段稳定噪声
+#define VAD_GMM_LAG_MIN     10      ///< 浊音检测的最小基音周期（4 kHz 下的样本数，400 Hz）
+#define VAD_GMM_LAG_MAX     57      ///< 浊音检测的最大基音周期（70 Hz）
+
+/**
+ * 子带权重，与 WebRTC VAD 一样高频子带权重大，用于全局判决。
+ */
+static const float k_band_weight[VAD_GMM_BANDS] = { 6.0f, 8.0f, 10.0f, 12.0f, 14.0f, 16.0f };
+
+/**
+ * 各激进程度下的判决门限（自然对数似然比）：单个子带超过 local，或加权平均超过 global 判为语音。
+ */
+static const float k_local_thold[4]  = { 3.0f, 4.0f, 5.0f, 6.0f };
+static const float k_global_thold[4] = { 1.0f, 1.5f, 2.0f, 2.5f };
+
+/**
+ * 各激进程度下的浊音门限（归一化自相关峰值）：0 表示不检查。
+ * 关门声、键盘声这类冲击没有基音，高激进程度下只有带基音的帧才能判为语音。
+ */
+static const float k_voicing_thold[4] = { 0.0f, 0.0f, 0.4f, 0.5f };
+
+/**
+ * 一级半带分解（多相全通 QMF）的状态。
+ */
+struct vad_gmm_split_t {
+    int32_t up  = 0;    ///< 上支路全通滤波器状态
+    int32_t lo  = 0;    ///< 下支路全通滤波器状态
+    int32_t odd = 0;    ///< 上一块的最后一个奇数样本，下支路的延迟
+};
+
+/**
+ * 一个子带上的高斯混合模型，均值和标准差单位为 dB，分量权重固定。
+ */
+struct vad_gmm_mixture_t {
+    float mean[VAD_GMM_MIXTURES];   ///< 均值
+    float std[VAD_GMM_MIXTURES];    ///< 标准差
+};
+
+/**
+ * 一阶全通滤波 (c + z^-1) / (1 + c z^-1) 的一个样本，定点 Q15 系数。
+ *
+ * @param x 输入。
+ * @param c 系数（Q15）。
+ * @param s 滤波器状态。
+ * @return 输出。
+ */
+static inline int32_t vad_gmm_allpass(int32_t x, int32_t c, int32_t &s)
+{
+    const int32_t y = (int32_t) (((int64_t) c * x) >> 15) + s;
+    s = x - (int32_t) (((int64_t) c * y) >> 15);
+    return y;
+}
+
+/**
+ * 把一段信号分解为低半带和高半带，各自 2 倍抽取。高半带在抽取后频谱是翻转的。
+ *
+ * @param in 输入，长度 n（偶数）。
+ * @param n 输入样本数。
+ * @param st 分解状态，跨帧保持。
+ * @param lp 输出的低半带，长度 n / 2。
+ * @param hp 输出的高半带，长度 n / 2。
+ */
+static void vad_gmm_split(const int32_t *in, size_t n, vad_gmm_split_t &st, int32_t *lp, int32_t *hp)
+{
+    for (size_t i = 0; i < n / 2; i++) {
+        const int32_t yu = vad_gmm_allpass(in[2*i], VAD_GMM_COEF_UP, st.up);
+        const int32_t yl = vad_gmm_allpass(st.odd,  VAD_GMM_COEF_LO, st.lo);
+        st.odd = in[2*i + 1];
+        lp[i] = (yu + yl) >> 1;
+        hp[i] = (yu - yl) >> 1;
+    }
+}
+
+/**
+ * 计算一段定点信号的平均功率。
+ *
+ * @param x 信号。
+ * @param n 样本数。
+ * @return 能量（dBFS）。
+ */
+static float vad_gmm_band_db(const int32_t *x, size_t n)
+{
+    int64_t sum = 0;
+    for (size_t i = 0; i < n; i++) {
+        sum += (int64_t) x[i] * x[i];
+    }
+    return 10.0f * log10f((float) sum / n / (32768.0f * 32768.0f) + 1e-10f);
+}
+
+/**
+ * 高斯混合的对数似然，并输出各分量的后验概率。
+ *
+ * @param m 混合模型。
+ * @param x 特征（dB）。
+ * @param resp 输出的各分量后验概率。
+ * @return 对数似然。
+ */
+static float vad_gmm_log_likelihood(const vad_gmm_mixture_t &m, float x, float resp[VAD_GMM_MIXTURES])
+{
+    float lp[VAD_GMM_MIXTURES];
+    float lmax = -1e30f;
+    for (int j = 0; j < VAD_GMM_MIXTURES; j++) {
+        const float d = (x - m.mean[j]) / m.std[j];
+        lp[j] = -0.5f * d * d - logf(m.std[j]) - logf((float) VAD_GMM_MIXTURES);
+        lmax = std::max(lmax, lp[j]);
+    }
+
+    float sum = 0.0f;
+    for (int j = 0; j < VAD_GMM_MIXTURES; j++) {
+        resp[j] = expf(lp[j] - lmax);
+        sum += resp[j];
+    }
+    for (int j = 0; j < VAD_GMM_MIXTURES; j++) {
+        resp[j] /= sum;
+    }
+    return lmax + logf(sum);
+}
+
+/**
+ * 按后验概率把混合模型向一个观测移动。
+ *
+ * @param m 混合模型。
+ * @param x 特征（dB）。
+ * @param resp 各分量的后验概率。
+ * @param rate 更新速率。
+ * @param std_min 标准差下限。
+ * @param std_max 标准差上限。
+ */
+static void vad_gmm_adapt(vad_gmm_mixture_t &m, float x, const float resp[VAD_GMM_MIXTURES], float rate,
+    float std_min, float std_max)
+{
+    for (int j = 0; j < VAD_GMM_MIXTURES; j++) {
+        const float k = rate * resp[j];
+        const float d = x - m.mean[j];
+        m.mean[j] += k * d;
+        const float var = m.std[j] * m.std[j] + k * (d * d - m.std[j] * m.std[j]);
+        m.std[j] = std::min(std_max, std::max(std_min, sqrtf(std::max(var, 0.0f))));
+    }
+}
+
+/**
+ * WebRTC 风格的子带高斯混合语音判决。
+ *
+ * 每帧用定点多相全通 QMF 逐级半带分解出 6 个子带（0~250 Hz 再经 80 Hz 高通），
+ * 以各子带对数能量为特征，分别在噪声模型和语音模型（各两个高斯分量）下求似然比，
+ * 单个子带似然比足够高或加权平均足够高即判为语音。
+ * 判为噪声的帧更新噪声模型，判为语音的帧更新语音模型；噪声模型还受最近 2 秒子带最小能量的约束，
+ * 风扇、空调这类稳定噪声即使一开始被误判，两三秒后也会被学进噪声模型。
+ * 整帧能量还必须高于噪声底（最近 2 秒的最小帧能量）加 gate_db，门限限制在 [floor_db, ceil_db] 之内。
+ * 激进程度 2、3 另外要求 0~2 kHz 子带有 70~400 Hz 的基音，关门声、键盘声不会触发。
+ */
+struct vad_model_gmm_t : vad_model_t {
+    int rate = 16000;                               ///< 采样率，8000 或 16000
+    int mode = 1;                                   ///< 激进程度
+    float gate = 10.0f;                             ///< 能量门限高出噪声底的 dB 数
+    float floor = -60.0f;                           ///< 能量门限下限（dBFS）
+    float ceil = 0.0f;                              ///< 能量门限上限（dBFS）
+    int32_t hpf_a = 0;                              ///< 最低子带 80 Hz 高通系数（Q15）
+    int32_t hpf_x = 0;                              ///< 最低子带高通上一个输入
+    int32_t hpf_y = 0;                              ///< 最低子带高通上一个输出
+    vad_gmm_split_t split[6];                       ///< 各级半带分解状态
+    vad_gmm_mixture_t noise_model[VAD_GMM_BANDS];   ///< 噪声模型
+    vad_gmm_mixture_t speech_model[VAD_GMM_BANDS];  ///< 语音模型
+    float band_min[VAD_GMM_TRACKED];                ///< 最近 VAD_GMM_MIN_MS 的子带和整帧最小能量（dB），最后一个即噪声底
+    std::vector<float> min_hist;                    ///< 最近 VAD_GMM_MIN_MS 每帧的子带和整帧能量，环形缓冲
+    size_t min_pos = 0;                             ///< min_hist 写入位置（帧）
+    float weight[VAD_GMM_BANDS];                    ///< 归一化的子带权重
+    uint64_t n_frames = 0;                          ///< 已处理帧数
+    std::vector<int32_t> work;                      ///< 分解用的工作缓冲
+    std::vector<float> pitch;                       ///< 0~2 kHz 子带差分后的信号，前 VAD_GMM_LAG_MAX 个是上一帧的尾部
+    int32_t pitch_x1 = 0;                           ///< 差分的上一个输入
+    float voicing_max = 0.0f;                       ///< 最近一帧的归一化自相关峰值
+
+    vad_hpf_t level_hpf;                            ///< 电平测量的高通滤波器
+    float energy_db = -100.0f;                      ///< 最近一帧的能量（dBFS）
+    float magnitude_avg = 0.0f;                     ///< 最近一帧的平均幅度
+
+    bool init(const vad_model_params_t &params);
+    bool process(const int16_t *frame, size_t n) override;
+    float energy() const override { return energy_db; }
+    float magnitude() const override { return magnitude_avg; }
+    float noise() const override { return band_min[VAD_GMM_BANDS]; }
+    float threshold() const override { return std::min(ceil, std::max(floor, noise() + gate)); }
+    const char *name() const override { return "gmm"; }
+
+private:
+    /**
+     * 计算一帧的 6 个子带特征。
+     *
+     * @param frame 帧数据。
+     * @param n 帧长度。
+     * @param feature 输出的子带能量（dBFS）。
+     */
+    void features(const int16_t *frame, size_t n, float feature[VAD_GMM_BANDS]);
+
+    /**
+     * 在 0~2 kHz 子带（4 kHz 采样）上求 70~400 Hz 基音范围内的归一化自相关峰值。
+     * 先做一阶差分，低频隆隆声（风扇）不会表现为高相关。
+     *
+     * @param x 0~2 kHz 子带。
+     * @param n 样本数。
+     * @return 自相关峰值，0 ~ 1。
+     */
+    float voicing(const int32_t *x, size_t n);
+};
+
+/**
+ * 初始化模型参数和状态。
+ *
+ * @param params 模型参数。
+ * @return 成功返回 true，采样率或帧长不支持时返回 false。
+ */
+bool vad_model_gmm_t::init(const vad_model_params_t &params)
+{
+    if (params.sample_rate != 16000 && params.sample_rate != 8000) {
+        LOG_ERR("gmm vad supports 8000 or 16000 Hz, got %d", params.sample_rate);
+        return false;
+    }
+
+    // 子带分解逐级减半抽取，帧长不对齐时 process() 无法处理，在这里报错而不是每帧都判为静音
+    const int n_align = params.sample_rate == 16000 ? 32 : 16;
+    const int n_frame = params.sample_rate * params.frame_ms / 1000;
+    if (params.frame_ms <= 0 || params.sample_rate * params.frame_ms % 1000 != 0 || n_frame % n_align != 0) {
+        LOG_ERR("gmm vad needs a frame of a multiple of %d samples at %d Hz, got %d ms",
+            n_align, params.sample_rate, params.frame_ms);
+        return false;
+    }
+
+    rate  = params.sample_rate;
+    mode  = std::min(3, std::max(0, params.mode));
+    gate  = params.gate_db;
+    floor = params.floor_db;
+    ceil  = std::max(params.floor_db, params.ceil_db);
+
+    // 最低子带的采样率是输入的 1/32（8 kHz 输入为 1/16）
+    const float fs_low = 250.0f * 2.0f;
+    const float rc = 1.0f / (2.0f * (float) M_PI * 80.0f);
+    hpf_a = (int32_t) lrintf(32768.0f * rc / (rc + 1.0f / fs_low));
+
+    const float rc_level = 1.0f / (2.0f * (float) M_PI * std::max(params.freq_thold, 1.0f));
+    level_hpf.a = rc_level / (rc_level + 1.0f / rate);
+
+    float weight_sum = 0.0f;
+    for (int k = 0; k < VAD_GMM_BANDS; k++) {
+        weight_sum += k_band_weight[k];
+    }
+    for (int k = 0; k < VAD_GMM_BANDS; k++) {
+        weight[k] = k_band_weight[k] / weight_sum;
+        noise_model[k]  = {{ -75.0f, -65.0f }, { 6.0f, 6.0f }};
+        speech_model[k] = {{ -50.0f, -35.0f }, { 10.0f, 10.0f }};
+    }
+    std::fill(band_min, band_min + VAD_GMM_TRACKED, floor);
+
+    return true;
+}
+
+/**
+ * 计算一帧的 6 个子带特征。
+ *
+ * @param frame 帧数据。
+ * @param n 帧长度。
+ * @param feature 输出的子带能量（dBFS）。
+ */
+void vad_model_gmm_t::features(const int16_t *frame, size_t n, float feature[VAD_GMM_BANDS])
+{
+    work.resize(3 * n);
+    int32_t *in = work.data();
+    int32_t *lp = in + n;
+    int32_t *hp = lp + n;
+
+    for (size_t i = 0; i < n; i++) {
+        in[i] = frame[i];
+    }
+
+    // 16 kHz 先抽取到 8 kHz，只保留 0~4 kHz
+    if (rate == 16000) {
+        vad_gmm_split(in, n, split[5], lp, hp);
+        n /= 2;
+        std::copy(lp, lp + n, in);
+    }
+
+    // 0~4k -> 0~2k | 2~4k
+    vad_gmm_split(in, n, split[0], lp, hp);
+    n /= 2;
+    std::copy(lp, lp + n, in);
+
+    // 2~4k -> 3~4k | 2~3k（高半带频谱翻转）
+    {
+        int32_t *hl = hp + n;
+        int32_t *hh = hl + n / 2;
+        vad_gmm_split(hp, n, split[1], hl, hh);
+        feature[5] = vad_gmm_band_db(hl, n / 2);
+        feature[4] = vad_gmm_band_db(hh, n / 2);
+    }
+
+    if (k_voicing_thold[mode] > 0.0f) {
+        voicing_max = voicing(in, n);
+    }
+
+    // 0~2k -> 0~1k | 1~2k
+    vad_gmm_split(in, n, split[2], lp, hp);
+    n /= 2;
+    feature[3] = vad_gmm_band_db(hp, n);
+    std::copy(lp, lp + n, in);
+
+    // 0~1k -> 0~500 | 500~1k
+    vad_gmm_split(in, n, split[3], lp, hp);
+    n /= 2;
+    feature[2] = vad_gmm_band_db(hp, n);
+    std::copy(lp, lp + n, in);
+
+    // 0~500 -> 0~250 | 250~500
+    vad_gmm_split(in, n, split[4], lp, hp);
+    n /= 2;
+    feature[1] = vad_gmm_band_db(hp, n);
+
+    // 0~250 经 80 Hz 高通，去掉工频和风扇的低频隆隆声
+    for (size_t i = 0; i < n; i++) {
+        const int32_t x = lp[i];
+        hpf_y = (int32_t) (((int64_t) hpf_a * (hpf_y + x - hpf_x)) >> 15);
+        hpf_x = x;
+        lp[i] = hpf_y;
+    }
+    feature[0] = vad_gmm_band_db(lp, n);
+}
+
+/**
+ * 在 0~2 kHz 子带（4 kHz 采样）上求 70~400 Hz 基音范围内的归一化自相关峰值。
+ * 先做一阶差分，低频隆隆声（风扇）不会表现为高相关。
+ *
+ * @param x 0~2 kHz 子带。
+ * @param n 样本数。
+ * @return 自相关峰值，0 ~ 1。
+ */
+float vad_model_gmm_t::voicing(const int32_t *x, size_t n)
+{
+    const size_t n_hist = VAD_GMM_LAG_MAX;
+    if (pitch.size() != n_hist + n) {
+        pitch.assign(n_hist + n, 0.0f);
+    }
+
+    float *cur = pitch.data() + n_hist;
+    for (size_t i = 0; i < n; i++) {
+        cur[i] = (float) (x[i] - pitch_x1);
+        pitch_x1 = x[i];
+    }
+
+    float e0 = 0.0f;
+    for (size_t i = 0; i < n; i++) {
+        e0 += cur[i] * cur[i];
+    }
+
+    float best = 0.0f;
+    if (e0 > 0.0f) {
+        for (int lag = VAD_GMM_LAG_MIN; lag <= VAD_GMM_LAG_MAX; lag++) {
+            float xy = 0.0f;
+            float yy = 0.0f;
+            for (size_t i = 0; i < n; i++) {
+                xy += cur[i] * cur[(ptrdiff_t) i - lag];
+                yy += cur[(ptrdiff_t) i - lag] * cur[(ptrdiff_t) i - lag];
+            }
+            if (xy > 0.0f && yy > 0.0f) {
+                best = std::max(best, xy / sqrtf(e0 * yy));
+            }
+        }
+    }
+
+    // 留下本帧尾部作为下一帧的历史
+    std::copy(pitch.end() - n_hist, pitch.end(), pitch.begin());
+    return best;
+}
+
+/**
+ * 处理一帧样本。
+ *
+ * @param frame 帧数据。
+ * @param n 帧长度（样本数），16 kHz 时必须是 32 的倍数，8 kHz 时是 16 的倍数。
+ * @return 判为语音返回 true。
+ */
+bool vad_model_gmm_t::process(const int16_t *frame, size_t n)
+{
+    const size_t n_align = rate == 16000 ? 32 : 16;
+    if (n == 0 || n % n_align != 0) {
+        return false;
+    }
+
+    vad_frame_sums_t sums;
+    vad_frame(frame, n, level_hpf, sums);
+    energy_db = 10.0f * log10f(sums.sum_sq / n / (32768.0f * 32768.0f) + 1e-10f);
+    magnitude_avg = sums.sum_abs / n;
+
+    float feature[VAD_GMM_BANDS];
+    features(frame, n, feature);
+
+    const bool warmup = n_frames++ < VAD_GMM_WARMUP;
+
+    // 各子带和整帧能量的滑动窗口最小值，窗口帧数由第一帧的帧长决定
+    float tracked[VAD_GMM_TRACKED];
+    std::copy(feature, feature + VAD_GMM_BANDS, tracked);
+    tracked[VAD_GMM_BANDS] = energy_db;
+
+    if (min_hist.empty()) {
+        const size_t n_min = std::max<size_t>(1, (size_t) VAD_GMM_MIN_MS * rate / 1000 / n);
+        min_hist.resize(n_min * VAD_GMM_TRACKED);
+        for (size_t i = 0; i < n_min; i++) {
+            std::copy(tracked, tracked + VAD_GMM_TRACKED, min_hist.begin() + i * VAD_GMM_TRACKED);
+        }
+    }
+    std::copy(tracked, tracked + VAD_GMM_TRACKED, min_hist.begin() + min_pos * VAD_GMM_TRACKED);
+    min_pos = (min_pos + 1) % (min_hist.size() / VAD_GMM_TRACKED);
+    std::copy(tracked, tracked + VAD_GMM_TRACKED, band_min);
+    for (size_t i = 0; i < min_hist.size(); i += VAD_GMM_TRACKED) {
+        for (int k = 0; k < VAD_GMM_TRACKED; k++) {
+            band_min[k] = std::min(band_min[k], min_hist[i + k]);
+        }
+    }
+
+    float llr[VAD_GMM_BANDS];
+    float resp_n[VAD_GMM_BANDS][VAD_GMM_MIXTURES];
+    float resp_s[VAD_GMM_BANDS][VAD_GMM_MIXTURES];
+    float llr_sum = 0.0f;
+    bool local = false;
+    for (int k = 0; k < VAD_GMM_BANDS; k++) {
+        llr[k] = vad_gmm_log_likelihood(speech_model[k], feature[k], resp_s[k]) -
+                 vad_gmm_log_likelihood(noise_model[k],  feature[k], resp_n[k]);
+        llr_sum += weight[k] * llr[k];
+        local |= llr[k] > k_local_thold[mode];
+    }
+
+    const bool speech_frame = !warmup && energy_db > threshold() && (local || llr_sum > k_global_thold[mode]) &&
+                              voicing_max >= k_voicing_thold[mode];
+
+    // 开头几帧当作噪声快速学习，之后噪声帧和语音帧各自缓慢更新
+    for (int k = 0; k < VAD_GMM_BANDS; k++) {
+        if (speech_frame) {
+            vad_gmm_adapt(speech_model[k], feature[k], resp_s[k], 0.01f, 4.0f, 20.0f);
+        } else {
+            vad_gmm_adapt(noise_model[k], feature[k], resp_n[k], warmup ? 0.1f : 0.02f, 2.0f, 12.0f);
+        }
+
+        // 噪声模型的每个分量都不高于最近 VAD_GMM_MIN_MS 的最小能量几 dB：偶发的响声不会在
+        // 噪声模型里留下一个分量；判为语音的帧里噪声模型也向最小值靠拢，
+        // 稳定噪声即使被误判为语音，最小值升上来之后也会很快学进噪声模型
+        for (int j = 0; j < VAD_GMM_MIXTURES; j++) {
+            const float cap = band_min[k] + 3.0f + 6.0f * j;
+            if (noise_model[k].mean[j] > cap) {
+                noise_model[k].mean[j] = cap;
+            } else if (speech_frame) {
+                noise_model[k].mean[j] += 0.02f * (cap - noise_model[k].mean[j]);
+            }
+        }
+
+        // 语音模型始终比噪声模型高出一定距离，两个模型不会重合
+        const float speech_mean = 0.5f * (speech_model[k].mean[0] + speech_model[k].mean[1]);
+        const float sep = speech_mean - (0.5f * (noise_model[k].mean[0] + noise_model[k].mean[1]) + VAD_GMM_MIN_SEP);
+        if (sep < 0.0f) {
+            speech_model[k].mean[0] -= sep;
+            speech_model[k].mean[1] -= sep;
+        }
+    }
+
+    return speech_frame;
+}
+
+/**
+ * 创建子带高斯混合模型。
+ *
+ * @param params 模型参数。
+ * @return 成功返回模型指针，采样率或帧长不支持时返回 nullptr。
+ */
+vad_model_t *vad_model_gmm_create(const vad_model_params_t &params)
+{
+    vad_model_gmm_t *model = new vad_model_gmm_t;
+    if (!model->init(params)) {
+        delete model;
+        return nullptr;
+    }
+    return model;
+}
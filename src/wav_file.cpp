@@ -0,0 +1,271 @@
+#include "wav_file.h"
+
+#include <cstring>
+
+#include "debug.h"
+
+/**
+ * 以小端序读取无符号整数。
+ *
+ * @param fp 已打开的文件。
+ * @param bytes 字节数，最多 4。
+ * @param value 输出的数值。
+ * @return 成功返回 true，读到文件结尾返回 false。
+ */
+static bool wav_read_le(FILE *fp, int bytes, uint32_t &value)
+{
+    uint8_t buf[4] = { 0 };
+    if (fread(buf, 1, bytes, fp) != (size_t)bytes) {
+        return false;
+    }
+
+    value = 0;
+    for (int i = bytes - 1; i >= 0; --i) {
+        value = (value << 8) | buf[i];
+    }
+    return true;
+}
+
+/**
+ * 跳过指定字节数，使用顺序读取以兼容管道。
+ *
+ * @param fp 已打开的文件。
+ * @param bytes 需要跳过的字节数。
+ * @return 成功返回 true，读到文件结尾返回 false。
+ */
+static bool wav_skip(FILE *fp, uint64_t bytes)
+{
+    char buf[256];
+    while (bytes > 0) {
+        size_t n = bytes < sizeof(buf) ? (size_t)bytes : sizeof(buf);
+        if (fread(buf, 1, n, fp) != n) {
+            return false;
+        }
+        bytes -= n;
+    }
+    return true;
+}
+
+/**
+ * 读取并解析 WAV 文件头，成功后文件位置停在 data 块数据起始处。
+ * 只顺序读取，不依赖 seek，因此也可用于标准输入。
+ *
+ * @param fp 已打开的文件。
+ * @param hdr 输出的文件头信息。
+ * @return 成功返回 true，格式错误或不支持返回 false。
+ */
+bool wav_read_header(FILE *fp, wav_header_t &hdr)
+{
+    char id[4];
+    uint32_t size = 0;
+
+    if (fread(id, 1, 4, fp) != 4 || memcmp(id, "RIFF", 4) != 0 ||
+        !wav_read_le(fp, 4, size) ||
+        fread(id, 1, 4, fp) != 4 || memcmp(id, "WAVE", 4) != 0) {
+        LOG_ERR("not a RIFF/WAVE file");
+        return false;
+    }
+
+    bool has_fmt = false;
+    while (true) {
+        if (fread(id, 1, 4, fp) != 4 || !wav_read_le(fp, 4, size)) {
+            LOG_ERR("data chunk not found");
+            return false;
+        }
+
+        if (memcmp(id, "fmt ", 4) == 0) {
+            uint32_t format, channels, sample_rate, byte_rate, block_align, bits;
+            if (size < 16 ||
+                !wav_read_le(fp, 2, format) || !wav_read_le(fp, 2, channels) ||
+                !wav_read_le(fp, 4, sample_rate) || !wav_read_le(fp, 4, byte_rate) ||
+                !wav_read_le(fp, 2, block_align) || !wav_read_le(fp, 2, bits)) {
+                LOG_ERR("bad fmt chunk");
+                return false;
+            }
+
+            uint32_t n_left = size - 16;
+            // WAVE_FORMAT_EXTENSIBLE: 实际格式在子格式 GUID 的前两个字节
+            if (format == 0xFFFE && n_left >= 10) {
+                uint32_t cb_size, valid_bits, channel_mask, sub_format;
+                if (!wav_read_le(fp, 2, cb_size) || !wav_read_le(fp, 2, valid_bits) ||
+                    !wav_read_le(fp, 4, channel_mask) || !wav_read_le(fp, 2, sub_format)) {
+                    LOG_ERR("bad extensible fmt chunk");
+                    return false;
+                }
+                format = sub_format;
+                n_left -= 10;
+            }
+
+            if (!wav_skip(fp, n_left + (size & 1))) {
+                return false;
+            }
+
+            hdr.format          = format;
+            hdr.channels        = channels;
+            hdr.sample_rate     = sample_rate;
+            hdr.bits_per_sample = bits;
+            has_fmt = true;
+        } else if (memcmp(id, "data", 4) == 0) {
+            if (!has_fmt) {
+                LOG_ERR("data chunk before fmt chunk");
+                return false;
+            }
+            // 流式写入的 WAV 常把 data 大小写成 0 或 0xFFFFFFFF，此时读到文件结尾为止
+            hdr.data_size = (size == 0 || size == 0xFFFFFFFF) ? UINT64_MAX : size;
+            break;
+        } else {
+            if (!wav_skip(fp, (uint64_t)size + (size & 1))) {
+                LOG_ERR("truncated chunk");
+                return false;
+            }
+        }
+    }
+
+    const bool supported =
+        (hdr.format == WAV_FORMAT_PCM   && hdr.bits_per_sample == 16) ||
+        (hdr.format == WAV_FORMAT_FLOAT && hdr.bits_per_sample == 32);
+    if (!supported || hdr.channels <= 0) {
+        LOG_ERR("unsupported wav format: format = %d, bits = %d, channels = %d",
+            hdr.format, hdr.bits_per_sample, hdr.channels);
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * 以小端序写入无符号整数。
+ *
+ * @param buf 输出缓冲区。
+ * @param bytes 字节数，最多 4。
+ * @param value 写入的数值。
+ * @return 写入之后的位置。
+ */
+static uint8_t *wav_put_le(uint8_t *buf, int bytes, uint32_t value)
+{
+    for (int i = 0; i < bytes; ++i) {
+        buf[i] = (uint8_t)(value >> (8 * i));
+    }
+    return buf + bytes;
+}
+
+/**
+ * 生成 44 字节的 16 位 PCM WAV 文件头。
+ *
+ * @param out 输出缓冲区，至少 WAV_HEADER_SIZE 字节。
+ * @param sample_rate 采样率。
+ * @param channels 声道数。
+ * @param data_bytes 数据字节数。
+ */
+void wav_make_header(uint8_t *out, int sample_rate, int channels, uint32_t data_bytes)
+{
+    const int bits = 16;
+    uint8_t *p = out;
+    memcpy(p, "RIFF", 4);     p += 4;
+    p = wav_put_le(p, 4, 36 + data_bytes);
+    memcpy(p, "WAVEfmt ", 8); p += 8;
+    p = wav_put_le(p, 4, 16);
+    p = wav_put_le(p, 2, WAV_FORMAT_PCM);
+    p = wav_put_le(p, 2, channels);
+    p = wav_put_le(p, 4, sample_rate);
+    p = wav_put_le(p, 4, sample_rate * channels * bits / 8);
+    p = wav_put_le(p, 2, channels * bits / 8);
+    p = wav_put_le(p, 2, bits);
+    memcpy(p, "data", 4);     p += 4;
+    wav_put_le(p, 4, data_bytes);
+}
+
+/**
+ * 写入 44 字节的 PCM WAV 文件头。
+ *
+ * @param fp 已打开的文件。
+ * @param sample_rate 采样率。
+ * @param channels 声道数。
+ * @param data_bytes 数据字节数。
+ * @return 成功返回 true。
+ */
+static bool wav_write_header(FILE *fp, int sample_rate, int channels, uint32_t data_bytes)
+{
+    uint8_t hdr[WAV_HEADER_SIZE];
+    wav_make_header(hdr, sample_rate, channels, data_bytes);
+    return fwrite(hdr, 1, sizeof(hdr), fp) == sizeof(hdr);
+}
+
+/**
+ * 创建文件并写入文件头。
+ *
+ * @param path 文件路径。
+ * @param sample_rate 采样率。
+ * @param channels 声道数。
+ * @return 成功返回 true，失败返回 false。
+ */
+bool wav_writer_t::open(const std::string &path, int sample_rate, int channels)
+{
+    close();
+
+    fp = fopen(path.c_str(), "wb");
+    if (!fp) {
+        LOG_ERR("fail to create %s", path.c_str());
+        return false;
+    }
+
+    // 长度先写 0，异常退出时读取端按“读到文件结尾”处理
+    if (!wav_write_header(fp, sample_rate, channels, 0)) {
+        LOG_ERR("fail to write wav header: %s", path.c_str());
+        fclose(fp);
+        fp = nullptr;
+        return false;
+    }
+
+    data_bytes = 0;
+    rate = sample_rate;
+    n_channels = channels;
+
+    return true;
+}
+
+/**
+ * 追加样本。
+ *
+ * @param data 样本数据。
+ * @param n 样本数。
+ * @return 成功返回 true，失败返回 false。
+ */
+bool wav_writer_t::write(const int16_t *data, size_t n)
+{
+    if (!fp) {
+        return false;
+    }
+    if (n == 0) {
+        return true;
+    }
+
+    // WAV 是小端格式，与目标平台（x86/ARM）的内存布局一致，可以整块写入
+    if (fwrite(data, sizeof(int16_t), n, fp) != n) {
+        LOG_ERR("fail to write wav data");
+        return false;
+    }
+    data_bytes += n * sizeof(int16_t);
+
+    return true;
+}
+
+/**
+ * 回填文件头并关闭文件。
+ *
+ * @return 成功返回 true，失败返回 false。
+ */
+bool wav_writer_t::close()
+{
+    if (!fp) {
+        return true;
+    }
+
+    const uint32_t n_bytes = data_bytes > 0xFFFFFFFF - 36 ? 0 : (uint32_t)data_bytes;
+
+    bool ok = fseek(fp, 0, SEEK_SET) == 0 && wav_write_header(fp, rate, n_channels, n_bytes);
+    ok = fclose(fp) == 0 && ok;
+    fp = nullptr;
+
+    return ok;
+}
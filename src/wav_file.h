@@ -0,0 +1,96 @@
+#ifndef WAV_FILE_H_
+#define WAV_FILE_H_
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+/**
+ * WAV 采样格式。
+ */
+typedef enum {
+    WAV_FORMAT_PCM   = 1,   ///< 整数 PCM
+    WAV_FORMAT_FLOAT = 3,   ///< IEEE 浮点
+} wav_format_t;
+
+/**
+ * WAV 文件头中与解码相关的信息。
+ */
+struct wav_header_t {
+    int format          = 0;    ///< 采样格式，见 wav_format_t
+    int channels        = 0;    ///< 声道数
+    int sample_rate     = 0;    ///< 采样率
+    int bits_per_sample = 0;    ///< 每个样本的位数
+    uint64_t data_size  = 0;    ///< data 块字节数
+};
+
+/**
+ * 读取并解析 WAV 文件头，成功后文件位置停在 data 块数据起始处。
+ * 只顺序读取，不依赖 seek，因此也可用于标准输入。
+ *
+ * @param fp 已打开的文件。
+ * @param hdr 输出的文件头信息。
+ * @return 成功返回 true，格式错误或不支持返回 false。
+ */
+bool wav_read_header(FILE *fp, wav_header_t &hdr);
+
+#define WAV_HEADER_SIZE 44  ///< wav_make_header() 生成的文件头字节数
+
+/**
+ * 生成 44 字节的 16 位 PCM WAV 文件头，供不经过 FILE 的写入路径使用。
+ *
+ * @param out 输出缓冲区，至少 WAV_HEADER_SIZE 字节。
+ * @param sample_rate 采样率。
+ * @param channels 声道数。
+ * @param data_bytes 数据字节数。
+ */
+void wav_make_header(uint8_t *out, int sample_rate, int channels, uint32_t data_bytes);
+
+/**
+ * 16 位 PCM WAV 文件写入器。
+ * 直接写入 16 位整数样本，不做任何格式转换；关闭时回填文件头中的长度。
+ */
+struct wav_writer_t {
+    /**
+     * 创建文件并写入文件头。
+     *
+     * @param path 文件路径。
+     * @param sample_rate 采样率。
+     * @param channels 声道数。
+     * @return 成功返回 true，失败返回 false。
+     */
+    bool open(const std::string &path, int sample_rate, int channels);
+
+    /**
+     * 追加样本。
+     *
+     * @param data 样本数据。
+     * @param n 样本数。
+     * @return 成功返回 true，失败返回 false。
+     */
+    bool write(const int16_t *data, size_t n);
+
+    /**
+     * 回填文件头并关闭文件。
+     *
+     * @return 成功返回 true，失败返回 false。
+     */
+    bool close();
+
+    /**
+     * 判断文件是否已打开。
+     *
+     * @return 已打开返回 true。
+     */
+    bool is_open() const { return fp != nullptr; }
+
+    ~wav_writer_t() { close(); }
+
+private:
+    FILE *fp = nullptr;         ///< 输出文件
+    uint64_t data_bytes = 0;    ///< 已写入的数据字节数
+    int rate = 0;               ///< 采样率
+    int n_channels = 0;         ///< 声道数
+};
+
+#endif  // WAV_FILE_H_
@@ -0,0 +1,102 @@
+#include "wav_recorder.h"
+
+#include <algorithm>
+
+#include "debug.h"
+
+/**
+ * 创建文件并启动写盘线程。
+ *
+ * @param path 文件路径。
+ * @param sample_rate 采样率。
+ * @param queue_samples 队列容量（样本数），决定能容忍的磁盘停顿时长。
+ * @return 成功返回 true，失败返回 false。
+ */
+bool wav_recorder_t::open(const std::string &path, int sample_rate, size_t queue_samples)
+{
+    close();
+
+    if (!queue.init(queue_samples)) {
+        LOG_ERR("fail to init recorder queue, samples: %zu", queue_samples);
+        return false;
+    }
+
+    if (!writer.open(path, sample_rate, 1)) {
+        return false;
+    }
+
+    // 每次写盘约 0.5 秒音频，队列较小时不超过一半容量
+    n_batch = std::max<size_t>(1, std::min<size_t>(sample_rate / 2, queue.capacity() / 2));
+    n_dropped_blocks = 0;
+    n_written = 0;
+
+    worker = std::thread(&wav_recorder_t::run, this);
+
+    LOG_INFO("recording to %s, queue %zu samples (%.1f sec)",
+        path.c_str(), queue.capacity(), (double)queue.capacity() / sample_rate);
+
+    return true;
+}
+
+/**
+ * 放入一块样本（仅限采集线程调用），不阻塞。
+ *
+ * @param data 样本数据。
+ * @param n 样本数。
+ * @return 放入队列返回 true，队列已满而丢弃返回 false。
+ */
+bool wav_recorder_t::push(const int16_t *data, size_t n)
+{
+    if (queue.space() < n) {
+        n_dropped_blocks.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    queue.write(data, n);
+    return true;
+}
+
+/**
+ * 写完队列中剩余的样本，停止写盘线程并关闭文件。
+ * 调用前采集线程必须已停止调用 push()。
+ */
+void wav_recorder_t::close()
+{
+    if (!worker.joinable()) {
+        return;
+    }
+
+    queue.close();
+    worker.join();
+
+    if (!writer.close()) {
+        LOG_ERR("fail to finalize recording");
+    }
+}
+
+/**
+ * 写盘线程主循环。
+ */
+void wav_recorder_t::run()
+{
+    while (true) {
+        // 攒够一批再写，关闭后把剩余样本全部写完
+        const size_t n_avail = queue.wait(n_batch, 1000);
+        if (n_avail < n_batch && !queue.is_closed()) {
+            continue;
+        }
+        if (n_avail == 0) {
+            break;
+        }
+
+        const audio_ring_view_t view = queue.peek(n_avail);
+        if (!writer.write(view.data[0], view.size[0]) ||
+            !writer.write(view.data[1], view.size[1])) {
+            // 写盘失败时继续消费队列，采集线程不受影响
+            LOG_ERR("fail to write %zu samples to recording", view.total());
+        } else {
+            n_written.fetch_add(view.total(), std::memory_order_relaxed);
+        }
+        queue.consume(view.total());
+    }
+}
@@ -0,0 +1,84 @@
+#ifndef WAV_RECORDER_H_
+#define WAV_RECORDER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+#include "audio_ring.h"
+#include "audio_tap.h"
+#include "wav_file.h"
+
+/**
+ * 异步 WAV 录音器。
+ *
+ * 采集线程通过 push() 把刚采集的块放入有界队列（SPSC 环形缓冲区），从不阻塞、不访问磁盘；
+ * 独立的写盘线程攒够一批样本后整块写入文件。
+ * 磁盘跟不上导致队列放不下时整块丢弃并计数，不会写入半个块。
+ */
+struct wav_recorder_t : audio_tap_t {
+    /**
+     * 创建文件并启动写盘线程。
+     *
+     * @param path 文件路径。
+     * @param sample_rate 采样率。
+     * @param queue_samples 队列容量（样本数），决定能容忍的磁盘停顿时长。
+     * @return 成功返回 true，失败返回 false。
+     */
+    bool open(const std::string &path, int sample_rate, size_t queue_samples);
+
+    /**
+     * 放入一块样本（仅限采集线程调用），不阻塞。
+     *
+     * @param data 样本数据。
+     * @param n 样本数。
+     * @return 放入队列返回 true，队列已满而丢弃返回 false。
+     */
+    bool push(const int16_t *data, size_t n) override;
+
+    /**
+     * 写完队列中剩余的样本，停止写盘线程并关闭文件。
+     * 调用前采集线程必须已停止调用 push()。
+     */
+    void close();
+
+    /**
+     * 判断是否正在录音。
+     *
+     * @return 正在录音返回 true。
+     */
+    bool is_open() const { return worker.joinable(); }
+
+    /**
+     * 获取因队列满而丢弃的块数。
+     *
+     * @return 丢弃的块数。
+     */
+    uint64_t dropped_blocks() const { return n_dropped_blocks.load(std::memory_order_relaxed); }
+
+    /**
+     * 获取已写入文件的样本数。
+     *
+     * @return 样本数。
+     */
+    uint64_t written() const { return n_written.load(std::memory_order_relaxed); }
+
+    ~wav_recorder_t() { close(); }
+
+private:
+    /**
+     * 写盘线程主循环。
+     */
+    void run();
+
+    wav_writer_t writer;                        ///< WAV 文件
+    audio_ring_t queue;                         ///< 采集线程到写盘线程的有界队列
+    size_t n_batch = 0;                         ///< 每次写盘的目标样本数
+    std::thread worker;                         ///< 写盘线程
+
+    std::atomic<uint64_t> n_dropped_blocks{0};  ///< 丢弃的块数
+    std::atomic<uint64_t> n_written{0};         ///< 已写入的样本数
+};
+
+#endif  // WAV_RECORDER_H_
@@ -0,0 +1,1440 @@
+#include "whisper_bench.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifdef WHISPER_FUZZY_SDL2
+#include <SDL.h>
+#endif
+
+#include "audio_source.h"
+#include "command_grammar.h"
+#include "denoise.h"
+#include "fft.h"
+#include "frame_vad.h"
+#include "pcm_convert.h"
+#include "resampler.h"
+#include "vad_kernels.h"
+#include "wav_file.h"
+#include "whisper.h"
+#include "whisper_engine.h"
+#include "debug.h"
+
+#define BENCH_OUTPUT_RATE 16000     ///< 基准测试的输出采样率，与 whisper 一致
+
+/**
+ * 基准测试输入音频。
+ */
+struct bench_audio_t {
+    std::vector<int16_t> pcm;   ///< 单声道样本
+    int sample_rate = 0;        ///< 采样率
+    bool synthetic  = false;    ///< 是否为合成的测试信号
+};
+
+/**
+ * 单个处理阶段的计时结果。
+ */
+struct bench_timing_t {
+    uint64_t n_blocks = 0;      ///< 处理的块数
+    uint64_t ns_total = 0;      ///< 累计耗时（纳秒）
+    uint64_t ns_max   = 0;      ///< 单块最大耗时（纳秒）
+};
+
+/**
+ * 读取 -i 指定的音频文件，未指定时合成测试信号：
+ * 1 kHz 正弦加上一个高于 8 kHz 的正弦，后者用于衡量重采样的混叠抑制。
+ *
+ * @param params 命令行参数。
+ * @param audio 输出的音频。
+ * @return 成功返回 true，失败返回 false。
+ */
+static bool bench_load_audio(const whisper_params_t &params, bench_audio_t &audio)
+{
+    if (params.input.empty()) {
+        audio.sample_rate = params.audio_rate > 0 ? params.audio_rate : AUDIO_SOURCE_NATIVE_RATE;
+        audio.synthetic   = true;
+        audio.pcm.resize((size_t)audio.sample_rate * 10);
+
+        const double f_alias = 12000.0;
+        const bool has_alias = f_alias < 0.5 * audio.sample_rate;
+        for (size_t i = 0; i < audio.pcm.size(); i++) {
+            const double t = (double)i / audio.sample_rate;
+            double v = 0.4 * sin(2.0 * M_PI * 1000.0 * t);
+            if (has_alias) {
+                v += 0.4 * sin(2.0 * M_PI * f_alias * t);
+            }
+            audio.pcm[i] = (int16_t)lrint(v * 32767.0);
+        }
+        return true;
+    }
+
+    FILE *fp = params.input == "-" ? stdin : fopen(params.input.c_str(), "rb");
+    if (!fp) {
+        LOG_ERR("fail to open %s", params.input.c_str());
+        return false;
+    }
+
+    bool is_float = params.input_format == "f32";
+    int channels  = 1;
+    audio.sample_rate = params.audio_rate > 0 ? params.audio_rate : BENCH_OUTPUT_RATE;
+
+    if (params.input_format == "wav") {
+        wav_header_t hdr;
+        if (!wav_read_header(fp, hdr)) {
+            if (fp != stdin) {
+                fclose(fp);
+            }
+            return false;
+        }
+        is_float = hdr.format == WAV_FORMAT_FLOAT;
+        channels = hdr.channels;
+        audio.sample_rate = hdr.sample_rate;
+    }
+
+    const size_t sample_bytes = is_float ? sizeof(float) : sizeof(int16_t);
+    std::vector<uint8_t> frame(sample_bytes * channels);
+    std::vector<float> mix;
+
+    while (fread(frame.data(), frame.size(), 1, fp) == 1) {
+        float sum = 0.0f;
+        for (int c = 0; c < channels; c++) {
+            if (is_float) {
+                float v;
+                memcpy(&v, frame.data() + c * sample_bytes, sizeof(v));
+                sum += v;
+            } else {
+                int16_t v;
+                memcpy(&v, frame.data() + c * sample_bytes, sizeof(v));
+                sum += v / 32768.0f;
+            }
+        }
+        mix.push_back(sum / channels);
+    }
+
+    if (fp != stdin) {
+        fclose(fp);
+    }
+
+    audio.pcm.resize(mix.size());
+    pcm_f32_to_s16(mix.data(), audio.pcm.data(), mix.size());
+
+    return !audio.pcm.empty();
+}
+
+/**
+ * 用 Goertzel 算法测量信号在某个频率上的幅度。
+ *
+ * @param pcm 样本。
+ * @param n 样本数。
+ * @param freq 频率（Hz）。
+ * @param sample_rate 采样率。
+ * @return 幅度（与样本同量纲）。
+ */
+static double bench_tone_level(const int16_t *pcm, size_t n, double freq, int sample_rate)
+{
+    const double coef = 2.0 * cos(2.0 * M_PI * freq / sample_rate);
+    double s1 = 0.0;
+    double s2 = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        const double s0 = pcm[i] + coef * s1 - s2;
+        s2 = s1;
+        s1 = s0;
+    }
+    const double power = s1 * s1 + s2 * s2 - coef * s1 * s2;
+    return n ? 2.0 * sqrt(std::max(0.0, power)) / n : 0.0;
+}
+
+/**
+ * 打印一个重采样实现的结果。
+ *
+ * @param name 实现名称。
+ * @param t 计时结果。
+ * @param audio 输入音频。
+ * @param n_rounds 输入重复的轮数。
+ * @param out 第一轮的输出。
+ */
+static void bench_resample_report(const char *name, const bench_timing_t &t, const bench_audio_t &audio,
+    int n_rounds, const std::vector<int16_t> &out)
+{
+    const double sec = (double)audio.pcm.size() * n_rounds / audio.sample_rate;
+
+    char alias[32] = "-";
+    if (audio.synthetic && 12000.0 < 0.5 * audio.sample_rate && out.size() > BENCH_OUTPUT_RATE) {
+        // 跳过开头的滤波器建立过程，12 kHz 在 16 kHz 输出中混叠到 4 kHz
+        const int16_t *p = out.data() + BENCH_OUTPUT_RATE / 10;
+        const size_t   n = out.size() - BENCH_OUTPUT_RATE / 10;
+        const double level_ref   = bench_tone_level(p, n, 1000.0, BENCH_OUTPUT_RATE);
+        const double level_alias = bench_tone_level(p, n, 4000.0, BENCH_OUTPUT_RATE);
+        snprintf(alias, sizeof(alias), "%.1f dB", 20.0 * log10(level_ref / std::max(level_alias, 1e-3)));
+    }
+
+    printf("  %-10s %8llu %12.2f %10.2f %12.0f %12s\n", name,
+        (unsigned long long)t.n_blocks,
+        t.n_blocks ? t.ns_total / 1e3 / t.n_blocks : 0.0,
+        t.ns_max / 1e3,
+        t.ns_total ? sec * 1e9 / t.ns_total : 0.0,
+        alias);
+}
+
+/**
+ * 重采样基准测试：以 10 ms 为一块，比较内置多相重采样器与 SDL 音频流转换的单块耗时。
+ *
+ * @param params 命令行参数，-i 指定输入文件，-ar 指定合成信号的采样率。
+ * @return 成功返回 0，失败返回 -1。
+ */
+static int bench_resample(const whisper_params_t &params, const whisper_engine_task_t &)
+{
+    bench_audio_t audio;
+    if (!bench_load_audio(params, audio)) {
+        LOG_ERR("fail to load bench input");
+        return -1;
+    }
+
+    const size_t n_block  = std::max(1, audio.sample_rate / 100);
+    const int    n_rounds = 20;
+
+    printf("resample: %d -> %d Hz, %s, %.1f sec x %d rounds, %zu samples per block\n",
+        audio.sample_rate, BENCH_OUTPUT_RATE, audio.synthetic ? "1 kHz + 12 kHz tones" : params.input.c_str(),
+        (double)audio.pcm.size() / audio.sample_rate, n_rounds, n_block);
+    printf("  %-10s %8s %12s %10s %12s %12s\n", "stage", "blocks", "avg us/blk", "max us", "x realtime", "alias rej");
+
+    // 内置多相重采样器，使用其自带的阶段统计
+    {
+        resampler_t resampler;
+        if (!resampler.init(audio.sample_rate, BENCH_OUTPUT_RATE, n_block)) {
+            return -1;
+        }
+
+        std::vector<int16_t> block(resampler.max_output(n_block));
+        std::vector<int16_t> out;
+        for (int r = 0; r < n_rounds; r++) {
+            for (size_t i = 0; i < audio.pcm.size(); i += n_block) {
+                const size_t k = std::min(n_block, audio.pcm.size() - i);
+                const size_t m = resampler.process(audio.pcm.data() + i, k, block.data());
+                if (r == 0) {
+                    out.insert(out.end(), block.begin(), block.begin() + m);
+                }
+            }
+        }
+
+        const resampler_stats_t rs = resampler.stats();
+        bench_timing_t t;
+        t.n_blocks = rs.n_blocks;
+        t.ns_total = rs.ns_total;
+        t.ns_max   = rs.ns_max;
+
+        char name[32];
+        snprintf(name, sizeof(name), "poly/%s", resampler_t::impl());
+        bench_resample_report(name, t, audio, n_rounds, out);
+    }
+
+#ifdef WHISPER_FUZZY_SDL2
+    // SDL 音频流转换，与 SDL 采集回调内部使用的是同一套转换代码
+    {
+        SDL_SetHintWithPriority(SDL_HINT_AUDIO_RESAMPLING_MODE, "medium", SDL_HINT_OVERRIDE);
+
+        SDL_AudioStream *stream = SDL_NewAudioStream(AUDIO_S16SYS, 1, audio.sample_rate, AUDIO_S16SYS, 1, BENCH_OUTPUT_RATE);
+        if (!stream) {
+            LOG_ERR("fail to create SDL audio stream: %s", SDL_GetError());
+            return -1;
+        }
+
+        std::vector<int16_t> block(n_block * 2 + 64);
+        std::vector<int16_t> out;
+        bench_timing_t t;
+        for (int r = 0; r < n_rounds; r++) {
+            for (size_t i = 0; i < audio.pcm.size(); i += n_block) {
+                const size_t k = std::min(n_block, audio.pcm.size() - i);
+
+                const auto t0 = std::chrono::steady_clock::now();
+                SDL_AudioStreamPut(stream, audio.pcm.data() + i, (int)(k * sizeof(int16_t)));
+                const int n_bytes = SDL_AudioStreamGet(stream, block.data(), (int)(block.size() * sizeof(int16_t)));
+                const uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - t0).count();
+
+                t.n_blocks++;
+                t.ns_total += ns;
+                t.ns_max = std::max(t.ns_max, ns);
+
+                if (r == 0 && n_bytes > 0) {
+                    out.insert(out.end(), block.begin(), block.begin() + n_bytes / sizeof(int16_t));
+                }
+            }
+        }
+
+        SDL_FreeAudioStream(stream);
+
+        bench_resample_report("sdl", t, audio, n_rounds, out);
+    }
+#else
+    printf("  %-10s built without SDL2, skipped\n", "sdl");
+#endif
+
+    return 0;
+}
+
+/**
+ * 合成语音检测基准测试的输入：低电平白噪声，每 3 秒中间的 1 秒是带谐波的 200 Hz 浊音段。
+ *
+ * @param audio 输出的音频（16 kHz，60 秒）。
+ */
+static void bench_vad_synth(bench_audio_t &audio)
+{
+    audio.sample_rate = BENCH_OUTPUT_RATE;
+    audio.synthetic   = true;
+    audio.pcm.resize((size_t)audio.sample_rate * 60);
+
+    uint32_t seed = 12345;
+    for (size_t i = 0; i < audio.pcm.size(); i++) {
+        seed = seed * 1664525u + 1013904223u;
+        const double t = (double)i / audio.sample_rate;
+        double v = 0.002 * ((double)(seed >> 8) / (1 << 24) - 0.5);
+        if (fmod(t, 3.0) >= 1.0 && fmod(t, 3.0) < 2.0) {
+            for (int h = 1; h <= 5; h++) {
+                v += 0.3 / h * sin(2.0 * M_PI * 200.0 * h * t);
+            }
+        }
+        audio.pcm[i] = (int16_t)lrint(std::max(-1.0, std::min(1.0, v)) * 32767.0);
+    }
+}
+
+/**
+ * 用一个实现逐帧处理整段音频，与 energy_gate_t 使用相同的 100 Hz 高通滤波。
+ *
+ * @param kernel 帧处理实现。
+ * @param audio 输入音频。
+ * @param n_frame 帧长（样本数）。
+ * @param n_rounds 重复的轮数。
+ * @param energy 输出第一轮每帧的能量（dBFS）。
+ * @param magnitude 输出第一轮每帧的平均幅度。
+ * @return 总耗时（纳秒）。
+ */
+static uint64_t bench_vad_run(const vad_kernel_t &kernel, const bench_audio_t &audio, size_t n_frame, int n_rounds,
+    std::vector<float> &energy, std::vector<float> &magnitude)
+{
+    const float rc = 1.0f / (2.0f * (float)M_PI * 100.0f);
+    const float dt = 1.0f / audio.sample_rate;
+
+    energy.clear();
+    magnitude.clear();
+
+    const auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < n_rounds; r++) {
+        vad_hpf_t hpf;
+        hpf.a = rc / (rc + dt);
+        for (size_t i = 0; i + n_frame <= audio.pcm.size(); i += n_frame) {
+            vad_frame_sums_t sums;
+            kernel.fn(audio.pcm.data() + i, n_frame, hpf, sums);
+            if (r == 0) {
+                energy.push_back(10.0f * log10f(sums.sum_sq / n_frame / (32768.0f * 32768.0f) + 1e-10f));
+                magnitude.push_back(sums.sum_abs / n_frame);
+            }
+        }
+    }
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count();
+}
+
+/**
+ * 语音检测帧处理基准测试：比较各个向量实现与标量参考实现的单帧耗时，
+ * 并逐帧校验能量和平均幅度与参考实现的偏差。
+ *
+ * @param params 命令行参数，-i 指定输入文件，未指定时使用合成信号。
+ * @return 成功返回 0，输入无效或偏差超出容差返回 -1。
+ */
+static int bench_vad(const whisper_params_t &params, const whisper_engine_task_t &)
+{
+    const float tol_db  = 0.01f;    // 能量的绝对容差（dB）
+    const float tol_mag = 1e-3f;    // 平均幅度的相对容差
+
+    bench_audio_t audio;
+    if (params.input.empty()) {
+        bench_vad_synth(audio);
+    } else if (!bench_load_audio(params, audio)) {
+        LOG_ERR("fail to load bench input");
+        return -1;
+    }
+
+    const size_t n_frame  = std::max(1, audio.sample_rate / 50);
+    const int    n_rounds = 20;
+    const std::vector<vad_kernel_t> kernels = vad_kernels_available();
+
+    printf("vad: %d Hz, %s, %.1f sec x %d rounds, %zu samples per frame, dispatch %s\n",
+        audio.sample_rate, audio.synthetic ? "noise + voiced bursts" : params.input.c_str(),
+        (double)audio.pcm.size() / audio.sample_rate, n_rounds, n_frame, vad_kernels_impl());
+    printf("  %-10s %12s %12s %10s %12s %12s\n", "kernel", "ns/frame", "x realtime", "speedup", "max err dB", "max err mag");
+
+    std::vector<float> ref_energy, ref_magnitude;
+    double ns_scalar = 0.0;
+    bool ok = true;
+
+    // 0 是整帧，其余帧长带有不足一个向量的尾部，用于校验尾部处理和跨帧状态
+    const size_t frame_sizes[] = { n_frame, n_frame + 3, 7 };
+
+    for (const vad_kernel_t &kernel : kernels) {
+        float err_db  = 0.0f;
+        float err_mag = 0.0f;
+        double ns_frame = 0.0;
+
+        for (size_t f = 0; f < sizeof(frame_sizes) / sizeof(frame_sizes[0]); f++) {
+            std::vector<float> energy, magnitude;
+            std::vector<float> ref_e, ref_m;
+            const uint64_t ns = bench_vad_run(kernel, audio, frame_sizes[f], f == 0 ? n_rounds : 1, energy, magnitude);
+            if (f == 0) {
+                ns_frame = energy.empty() ? 0.0 : (double)ns / n_rounds / energy.size();
+            }
+
+            if (&kernel == &kernels[0]) {
+                if (f == 0) {
+                    ref_energy    = energy;
+                    ref_magnitude = magnitude;
+                }
+                continue;
+            }
+
+            if (f == 0) {
+                ref_e = ref_energy;
+                ref_m = ref_magnitude;
+            } else {
+                bench_vad_run(kernels[0], audio, frame_sizes[f], 1, ref_e, ref_m);
+            }
+            for (size_t i = 0; i < energy.size(); i++) {
+                err_db  = std::max(err_db, fabsf(energy[i] - ref_e[i]));
+                err_mag = std::max(err_mag, fabsf(magnitude[i] - ref_m[i]) / std::max(ref_m[i], 1.0f));
+            }
+        }
+
+        if (&kernel == &kernels[0]) {
+            ns_scalar = ns_frame;
+        }
+        const double sec_frame = (double)n_frame / audio.sample_rate;
+        const bool pass = err_db <= tol_db && err_mag <= tol_mag;
+        ok = ok && pass;
+
+        printf("  %-10s %12.1f %12.0f %10.2f %12.2g %12.2g%s\n", kernel.name, ns_frame,
+            ns_frame > 0.0 ? sec_frame * 1e9 / ns_frame : 0.0,
+            ns_frame > 0.0 ? ns_scalar / ns_frame : 0.0,
+            err_db, err_mag, pass ? "" : "  FAIL");
+    }
+
+    if (!ok) {
+        LOG_ERR("vad kernels differ from the scalar reference by more than %g dB / %g", tol_db, tol_mag);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * 合成背景噪声：风扇（低频加重的宽带噪声、工频嗡声和随转速起伏的叶片音）在第 60 秒打开，
+ * 每 17 秒一次关门声（宽带冲击，150 ms 衰减），每 5 秒一串键盘敲击，共 5 分钟。
+ *
+ * @param audio 输出的音频（16 kHz）。
+ */
+static void bench_vad_noise_synth(bench_audio_t &audio)
+{
+    audio.sample_rate = BENCH_OUTPUT_RATE;
+    audio.synthetic   = true;
+    audio.pcm.resize((size_t)audio.sample_rate * 300);
+
+    uint32_t seed = 54321;
+    double brown = 0.0;
+    double thud  = 0.0;
+    for (size_t i = 0; i < audio.pcm.size(); i++) {
+        seed = seed * 1664525u + 1013904223u;
+        const double white = (double)(seed >> 8) / (1 << 24) - 0.5;
+        const double t = (double)i / audio.sample_rate;
+
+        double v = 0.001 * white;
+        if (t >= 60.0) {
+            brown = 0.995 * brown + 0.05 * white;
+            v += 0.15 * brown + 0.01 * white;
+            v += 0.01 * sin(2.0 * M_PI * 120.0 * t);
+            v += 0.008 * (1.0 + 0.5 * sin(2.0 * M_PI * 0.3 * t)) * sin(2.0 * M_PI * 180.0 * t);
+        }
+
+        // 关门声以 1 kHz 以下为主
+        thud = 0.7 * thud + 0.3 * white;
+        const double t_door = fmod(t, 17.0);
+        if (t > 1.0 && t_door < 0.15) {
+            v += 2.0 * exp(-t_door / 0.03) * thud;
+        }
+
+        const double t_key = fmod(t, 5.0);
+        if (t_key < 1.0 && fmod(t_key, 0.16) < 0.008) {
+            v += 0.1 * white * 2.0;
+        }
+
+        audio.pcm[i] = (int16_t)lrint(std::max(-1.0, std::min(1.0, v)) * 32767.0);
+    }
+}
+
+/**
+ * 用一种判决模型跑完整的流式语音检测，按 10 ms 一块输入，统计语音开始事件和语音时长。
+ *
+ * @param vparams 检测参数。
+ * @param audio 输入音频。
+ * @param n_starts 输出的语音开始事件数。
+ * @param n_speech 输出处于语音状态的样本数。
+ * @return 总耗时（纳秒），初始化失败返回 0。
+ */
+static uint64_t bench_vad_noise_run(const frame_vad_params_t &vparams, const bench_audio_t &audio,
+    uint64_t &n_starts, uint64_t &n_speech)
+{
+    frame_vad_t vad;
+    if (!vad.init(vparams)) {
+        return 0;
+    }
+
+    n_starts = 0;
+    n_speech = 0;
+
+    const size_t n_block = audio.sample_rate / 100;
+    std::vector<frame_vad_event_t> events;
+    uint64_t start = 0;
+
+    const auto t0 = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < audio.pcm.size(); i += n_block) {
+        const size_t k = std::min(n_block, audio.pcm.size() - i);
+        vad.process(audio.pcm.data() + i, k, i, events);
+        for (const frame_vad_event_t &ev : events) {
+            if (ev.type == FRAME_VAD_START) {
+                n_starts++;
+                start = ev.at;
+            } else {
+                n_speech += ev.at - start;
+            }
+        }
+    }
+    const uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count();
+
+    if (vad.in_speech()) {
+        n_speech += audio.pcm.size() - start;
+    }
+    return std::max<uint64_t>(ns, 1);
+}
+
+/**
+ * 语音判决模型基准测试：在背景噪声上统计每小时误触发次数和语音占比，并给出每小时音频的 CPU 时间。
+ * 另用合成的浊音段检查每种模型仍能检测到语音。
+ *
+ * 误触发即一次完整的 whisper_full，所以每小时误触发次数直接对应浪费的推理次数。
+ *
+ * @param params 命令行参数，-i 指定背景噪声录音（16 kHz），未指定时使用合成噪声；
+ *               --vad-start、--hangover 等检测参数与流处理相同。
+ * @return 成功返回 0，失败返回 -1。
+ */
+static int bench_vad_noise(const whisper_params_t &params, const whisper_engine_task_t &)
+{
+    bench_audio_t noise;
+    if (params.input.empty()) {
+        bench_vad_noise_synth(noise);
+    } else if (!bench_load_audio(params, noise)) {
+        LOG_ERR("fail to load bench input");
+        return -1;
+    }
+    if (noise.sample_rate != BENCH_OUTPUT_RATE) {
+        LOG_ERR("vad-noise needs %d Hz input, got %d Hz", BENCH_OUTPUT_RATE, noise.sample_rate);
+        return -1;
+    }
+
+    bench_audio_t speech;
+    bench_vad_synth(speech);
+    const int n_bursts = (int)(speech.pcm.size() / speech.sample_rate / 3);
+
+    frame_vad_params_t vparams;
+    if (!whisper_stream_vad_params(params, vparams)) {
+        LOG_ERR("unknown vad model '%s'", params.vad_model.c_str());
+        return -1;
+    }
+
+    const double hours = (double)noise.pcm.size() / noise.sample_rate / 3600.0;
+
+    printf("vad-noise: %s, %.1f sec; speech check: %d voiced bursts; start %d ms, hangover %d ms\n",
+        noise.synthetic ? "fan + door slams + typing" : params.input.c_str(),
+        hours * 3600.0, n_bursts, vparams.start_ms, vparams.hangover_ms);
+    printf("  %-10s %12s %12s %12s %14s %10s\n", "model", "triggers", "triggers/h", "speech %", "cpu sec/hour", "detected");
+
+    struct { vad_model_type_t model; int mode; } configs[] = {
+        { VAD_MODEL_ENERGY, 0 },
+        { VAD_MODEL_GMM,    0 },
+        { VAD_MODEL_GMM,    1 },
+        { VAD_MODEL_GMM,    2 },
+        { VAD_MODEL_GMM,    3 },
+    };
+
+    for (const auto &c : configs) {
+        vparams.model = c.model;
+        vparams.mode  = c.mode;
+
+        uint64_t n_starts = 0, n_speech = 0;
+        const uint64_t ns = bench_vad_noise_run(vparams, noise, n_starts, n_speech);
+        uint64_t n_detected = 0, n_detected_speech = 0;
+        if (!ns || !bench_vad_noise_run(vparams, speech, n_detected, n_detected_speech)) {
+            return -1;
+        }
+
+        char name[32];
+        if (c.model == VAD_MODEL_GMM) {
+            snprintf(name, sizeof(name), "gmm/%d", c.mode);
+        } else {
+            snprintf(name, sizeof(name), "%s", vad_model_name(c.model));
+        }
+
+        printf("  %-10s %12llu %12.1f %12.2f %14.3f %6llu/%d\n", name,
+            (unsigned long long)n_starts, n_starts / hours,
+            100.0 * n_speech / noise.pcm.size(),
+            ns / 1e9 / hours,
+            (unsigned long long)n_detected, n_bursts);
+    }
+
+    return 0;
+}
+
+/**
+ * 录音中的一个语音段。
+ */
+struct bench_span_t {
+    size_t t0 = 0;              ///< 起点（样本）
+    size_t t1 = 0;              ///< 终点（样本）
+};
+
+/**
+ * 用与流处理相同的 VAD 参数把录音切成语音段：从语音起点前 --preroll 到最后一个语音帧后 --postroll，
+ * 最长 --preroll 加 --length，与 VAD 模式每次送入推理的音频一致。
+ *
+ * @param params 命令行参数。
+ * @param vparams 检测参数。
+ * @param audio 录音（16 kHz）。
+ * @param spans 输出的语音段。
+ * @return 成功返回 true，检测初始化失败返回 false。
+ */
+static bool bench_speech_spans(const whisper_params_t &params, const frame_vad_params_t &vparams,
+    const bench_audio_t &audio, std::vector<bench_span_t> &spans)
+{
+    frame_vad_t vad;
+    if (!vad.init(vparams)) {
+        return false;
+    }
+
+    const size_t n_pre  = (size_t)(1e-3 * std::max(0, params.preroll_ms) * audio.sample_rate);
+    const size_t n_post = (size_t)(1e-3 * std::max(0, params.postroll_ms) * audio.sample_rate);
+    const size_t n_len  = (size_t)(1e-3 * std::max(0, params.length_ms) * audio.sample_rate);
+    const size_t n_block = audio.sample_rate / 50;
+
+    std::vector<frame_vad_event_t> events;
+    size_t onset = 0;
+    size_t last  = 0;
+
+    auto add = [&](size_t speech_end) {
+        bench_span_t span;
+        span.t1 = std::min(audio.pcm.size(), speech_end + n_post);
+        span.t0 = onset - std::min(onset, n_pre);
+        span.t0 = std::max(span.t0, last);
+        span.t0 = std::max(span.t0, span.t1 - std::min(span.t1, n_pre + n_len));
+        if (span.t0 < span.t1) {
+            spans.push_back(span);
+            last = span.t1;
+        }
+    };
+
+    for (size_t i = 0; i < audio.pcm.size(); i += n_block) {
+        const size_t k = std::min(n_block, audio.pcm.size() - i);
+        vad.process(audio.pcm.data() + i, k, i, events);
+        for (const frame_vad_event_t &ev : events) {
+            if (ev.type == FRAME_VAD_START) {
+                onset = ev.at;
+            } else {
+                add(ev.at);
+            }
+        }
+    }
+    if (vad.in_speech()) {
+        add(audio.pcm.size());
+    }
+    return true;
+}
+
+/**
+ * 用与 VAD 模式相同的解码参数转写一段音频。
+ *
+ * @param ctx 模型。
+ * @param state 推理状态。
+ * @param params 命令行参数。
+ * @param pcmf32 样本。
+ * @param audio_ctx 音频上下文大小，0 表示全部。
+ * @param text 输出的文本，各段拼接。
+ * @param ns 输出的推理耗时（纳秒）。
+ * @param n_passes 非空时输出解码的轮数，1 表示没有温度回退。
+ * @param grammar 非空时按该语法约束解码，惩罚为 --gr-penalty。
+ * @return 成功返回 true，失败返回 false。
+ */
+static bool bench_transcribe(whisper_context *ctx, whisper_state *state, const whisper_params_t &params,
+    const std::vector<float> &pcmf32, int audio_ctx, std::string &text, uint64_t &ns, int *n_passes = nullptr,
+    const command_grammar_t *grammar = nullptr)
+{
+    whisper_full_params wparams = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+
+    wparams.print_progress   = false;
+    wparams.print_special    = false;
+    wparams.print_realtime   = false;
+    wparams.print_timestamps = false;
+    wparams.translate        = params.translate;
+    wparams.single_segment   = false;
+    wparams.no_context       = true;
+    wparams.max_tokens       = 0;
+    wparams.language         = params.language.c_str();
+    wparams.n_threads        = params.n_threads;
+    wparams.audio_ctx        = audio_ctx;
+    wparams.temperature_inc  = params.no_fallback ? 0.0f : wparams.temperature_inc;
+
+    if (grammar) {
+        command_grammar_apply(*grammar, wparams, params.grammar_penalty);
+    }
+
+    // 每个解码器在第一个 token 之前调用一次 logits 过滤回调：温度为 0 时一个解码器，回退后 best_of 个
+    int n_starts = 0;
+    if (n_passes) {
+        wparams.logits_filter_callback = [](whisper_context *, whisper_state *, const whisper_token_data *,
+            int n_tokens, float *, void *user_data) {
+            if (n_tokens == 0) {
+                ++*(int *)user_data;
+            }
+        };
+        wparams.logits_filter_callback_user_data = &n_starts;
+    }
+
+    const auto t0 = std::chrono::steady_clock::now();
+    if (whisper_full_with_state(ctx, state, wparams, pcmf32.data(), (int)pcmf32.size()) != 0) {
+        LOG_ERR("fail to transcribe");
+        return false;
+    }
+    ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count();
+
+    if (n_passes) {
+        const int best_of = std::max(1, wparams.greedy.best_of);
+        *n_passes = n_starts <= 1 ? n_starts : 1 + (n_starts - 1 + best_of - 1) / best_of;
+    }
+
+    text.clear();
+    const int n_segments = whisper_full_n_segments_from_state(state);
+    for (int i = 0; i < n_segments; i++) {
+        text += whisper_full_get_segment_text_from_state(state, i);
+    }
+    return true;
+}
+
+/**
+ * 基准测试用的模型：与识别会话一样由引擎加载并用静音预热，再借一个推理状态，析构时归还并释放。
+ */
+struct bench_model_t {
+    whisper_engine_t engine;                ///< 模型和推理状态池
+    whisper_engine_task_t task;             ///< 借用推理状态的任务
+    whisper_context *ctx = nullptr;         ///< 模型
+    whisper_state *state = nullptr;         ///< 借到的推理状态
+
+    ~bench_model_t()
+    {
+        whisper_engine_release(task);
+        whisper_engine_free(engine);
+    }
+};
+
+/**
+ * 加载 -m 指定的模型并预热。预热推理不计入结果，之后的第一次推理不再承担分配缓冲区和冷缓存的开销。
+ *
+ * @param params 命令行参数。
+ * @param model 输出的模型和推理状态。
+ * @return 成功返回 true，失败返回 false。
+ */
+static bool bench_model_load(const whisper_params_t &params, bench_model_t &model)
+{
+    whisper_engine_start(model.engine, params);
+
+    model.task.engine = &model.engine;
+    model.task.params = params;
+    model.state = whisper_engine_acquire(model.task);
+    if (!model.state) {
+        LOG_ERR("fail to load model '%s'", params.model.c_str());
+        return false;
+    }
+    model.ctx = model.engine.ctx;
+    return true;
+}
+
+/**
+ * 把文本拆成小写单词，去掉标点。
+ *
+ * @param text 文本。
+ * @return 单词列表。
+ */
+static std::vector<std::string> bench_words(const std::string &text)
+{
+    std::vector<std::string> words;
+    std::string word;
+    for (char c : text) {
+        if (isalnum((unsigned char)c) || c == '\'' || (c & 0x80)) {
+            word += (char)tolower((unsigned char)c);
+        } else if (!word.empty()) {
+            words.push_back(word);
+            word.clear();
+        }
+    }
+    if (!word.empty()) {
+        words.push_back(word);
+    }
+    return words;
+}
+
+/**
+ * 单词级编辑距离。
+ *
+ * @param ref 参考单词。
+ * @param hyp 待比较单词。
+ * @return 替换、插入和删除的总数。
+ */
+static size_t bench_word_edits(const std::vector<std::string> &ref, const std::vector<std::string> &hyp)
+{
+    std::vector<size_t> prev(hyp.size() + 1), cur(hyp.size() + 1);
+    for (size_t j = 0; j <= hyp.size(); j++) {
+        prev[j] = j;
+    }
+    for (size_t i = 1; i <= ref.size(); i++) {
+        cur[0] = i;
+        for (size_t j = 1; j <= hyp.size(); j++) {
+            const size_t sub = prev[j - 1] + (ref[i - 1] == hyp[j - 1] ? 0 : 1);
+            cur[j] = std::min(sub, std::min(prev[j], cur[j - 1]) + 1);
+        }
+        prev.swap(cur);
+    }
+    return prev[hyp.size()];
+}
+
+/**
+ * 一种音频上下文设置的统计。
+ */
+struct bench_ctx_stats_t {
+    uint64_t ns_total = 0;      ///< 累计推理耗时（纳秒）
+    uint64_t ns_max   = 0;      ///< 单次最大推理耗时（纳秒）
+    uint64_t n_ctx    = 0;      ///< 累计音频上下文大小（编码器帧）
+    size_t n_edits    = 0;      ///< 相对固定设置的单词编辑数
+    size_t n_same     = 0;      ///< 文本与固定设置完全相同的语音段数
+};
+
+/**
+ * 音频上下文基准测试：把 -i 指定的语音录音按 VAD 切成语音段，每段分别用固定的 -ac
+ * （默认 -1 时为完整的 30 秒上下文）和按长度计算的上下文转写，比较推理耗时和文本差异。
+ *
+ * 准确率以固定设置的结果为参考，给出单词错误率和完全相同的段数；-d 4 时逐段输出两种结果。
+ *
+ * @param params 命令行参数，-m 指定模型，-i 指定 16 kHz 语音录音，--ac-margin、--ac-min 为被测设置。
+ * @return 成功返回 0，失败返回 -1。
+ */
+static int bench_audio_ctx(const whisper_params_t &params, const whisper_engine_task_t &)
+{
+    if (params.input.empty()) {
+        LOG_ERR("audio-ctx needs a speech recording, pass it with -i");
+        return -1;
+    }
+
+    bench_audio_t audio;
+    if (!bench_load_audio(params, audio)) {
+        LOG_ERR("fail to load bench input");
+        return -1;
+    }
+    if (audio.sample_rate != BENCH_OUTPUT_RATE) {
+        LOG_ERR("audio-ctx needs %d Hz input, got %d Hz", BENCH_OUTPUT_RATE, audio.sample_rate);
+        return -1;
+    }
+
+    frame_vad_params_t vparams;
+    if (!whisper_stream_vad_params(params, vparams)) {
+        LOG_ERR("unknown vad model '%s'", params.vad_model.c_str());
+        return -1;
+    }
+
+    std::vector<bench_span_t> spans;
+    if (!bench_speech_spans(params, vparams, audio, spans) || spans.empty()) {
+        LOG_ERR("no speech found in %s", params.input.c_str());
+        return -1;
+    }
+
+    bench_model_t model;
+    if (!bench_model_load(params, model)) {
+        return -1;
+    }
+    whisper_context *ctx = model.ctx;
+    whisper_state *state = model.state;
+
+    const int n_ctx_max = whisper_model_n_audio_ctx(ctx);
+    const int fixed_ctx = std::max(0, params.audio_ctx);
+
+    whisper_params_t auto_params = params;
+    auto_params.audio_ctx = -1;
+
+    bench_ctx_stats_t fixed, dynamic;
+    size_t n_ref_words = 0;
+    std::vector<float> pcmf32;
+    std::string ref_text, text;
+    int ret = 0;
+
+    uint64_t ns = 0;
+
+    for (size_t i = 0; ret == 0 && i < spans.size(); i++) {
+        const bench_span_t &span = spans[i];
+        pcmf32.resize(span.t1 - span.t0);
+        pcm_s16_to_f32(audio.pcm.data() + span.t0, pcmf32.data(), pcmf32.size());
+
+        const int auto_ctx = whisper_stream_audio_ctx(auto_params, (int)pcmf32.size(), n_ctx_max);
+
+        if (!bench_transcribe(ctx, state, params, pcmf32, fixed_ctx, ref_text, ns)) {
+            ret = -1;
+            break;
+        }
+        fixed.ns_total += ns;
+        fixed.ns_max    = std::max(fixed.ns_max, ns);
+        fixed.n_ctx    += fixed_ctx > 0 ? fixed_ctx : n_ctx_max;
+
+        if (!bench_transcribe(ctx, state, params, pcmf32, auto_ctx, text, ns)) {
+            ret = -1;
+            break;
+        }
+        dynamic.ns_total += ns;
+        dynamic.ns_max    = std::max(dynamic.ns_max, ns);
+        dynamic.n_ctx    += auto_ctx > 0 ? auto_ctx : n_ctx_max;
+
+        const std::vector<std::string> ref_words = bench_words(ref_text);
+        const std::vector<std::string> words = bench_words(text);
+        n_ref_words      += ref_words.size();
+        dynamic.n_edits  += bench_word_edits(ref_words, words);
+        dynamic.n_same   += ref_words == words;
+        fixed.n_same++;
+
+        LOG_DBG("#%zu %.2f-%.2f sec, audio_ctx %d: fixed '%s' | auto '%s'", i,
+            (double)span.t0 / audio.sample_rate, (double)span.t1 / audio.sample_rate, auto_ctx,
+            ref_text.c_str(), text.c_str());
+    }
+
+    if (ret != 0) {
+        return ret;
+    }
+
+    const double n_spans = (double)spans.size();
+    double sec = 0.0;
+    for (const bench_span_t &span : spans) {
+        sec += (double)(span.t1 - span.t0) / audio.sample_rate;
+    }
+
+    printf("audio-ctx: %s, %zu utterances, %.2f sec mean; auto margin %d ms, floor %d of %d\n",
+        params.input.c_str(), spans.size(), sec / n_spans, params.audio_ctx_margin_ms, params.audio_ctx_min, n_ctx_max);
+    printf("  %-12s %12s %10s %10s %9s %12s %10s\n", "setting", "audio_ctx", "ms/run", "max ms", "speedup", "WER vs fixed", "identical");
+
+    char name[32];
+    snprintf(name, sizeof(name), "fixed %d", fixed_ctx);
+    const bench_ctx_stats_t *rows[] = { &fixed, &dynamic };
+    const char *names[] = { name, "auto" };
+    for (int r = 0; r < 2; r++) {
+        const bench_ctx_stats_t &st = *rows[r];
+        printf("  %-12s %12.0f %10.1f %10.1f %8.2fx %11.2f%% %6zu/%zu\n", names[r],
+            st.n_ctx / n_spans, st.ns_total / 1e6 / n_spans, st.ns_max / 1e6,
+            st.ns_total ? (double)fixed.ns_total / st.ns_total : 0.0,
+            n_ref_words ? 100.0 * st.n_edits / n_ref_words : 0.0, st.n_same, spans.size());
+    }
+
+    return 0;
+}
+
+/**
+ * 校验并测量各个 FFT 蝶形实现：与双精度直接 DFT 比较正变换误差，检查逆变换往返误差，
+ * 并测量降噪使用的 512 点实数变换（正逆各一次）的耗时。
+ *
+ * @return 全部实现的误差都在容差以内返回 true。
+ */
+static bool bench_denoise_fft()
+{
+    const size_t n_fft    = 512;
+    const int    n_rounds = 20000;
+    const double tol      = 1e-5;  // 相对频谱峰值的容差
+
+    std::vector<float> x(n_fft), y(n_fft), re(n_fft / 2 + 1), im(n_fft / 2 + 1);
+    uint32_t seed = 2024;
+    for (float &v : x) {
+        seed = seed * 1664525u + 1013904223u;
+        v = (float)(seed >> 8) / (1 << 24) - 0.5f;
+    }
+
+    std::vector<double> ref_re(n_fft / 2 + 1), ref_im(n_fft / 2 + 1);
+    double peak = 0.0;
+    for (size_t k = 0; k <= n_fft / 2; k++) {
+        double sr = 0.0, si = 0.0;
+        for (size_t j = 0; j < n_fft; j++) {
+            const double a = -2.0 * M_PI * (double)((j * k) % n_fft) / n_fft;
+            sr += x[j] * cos(a);
+            si += x[j] * sin(a);
+        }
+        ref_re[k] = sr;
+        ref_im[k] = si;
+        peak = std::max(peak, std::sqrt(sr * sr + si * si));
+    }
+
+    const std::vector<fft_kernel_t> kernels = fft_kernels_available();
+    printf("fft: %zu-point real transform, forward + inverse x %d rounds, dispatch %s\n", n_fft, n_rounds, fft_kernels_impl());
+    printf("  %-10s %12s %10s %14s %14s\n", "kernel", "ns/frame", "speedup", "err vs dft", "round trip");
+
+    double ns_scalar = 0.0;
+    bool ok = true;
+    for (const fft_kernel_t &kernel : kernels) {
+        rfft_plan_t plan;
+        if (!plan.init(n_fft, &kernel)) {
+            return false;
+        }
+
+        plan.forward(x.data(), re.data(), im.data());
+        double err = 0.0;
+        for (size_t k = 0; k <= n_fft / 2; k++) {
+            err = std::max(err, std::fabs(re[k] - ref_re[k]) + std::fabs(im[k] - ref_im[k]));
+        }
+        err /= peak;
+
+        plan.inverse(re.data(), im.data(), y.data());
+        double err_rt = 0.0;
+        for (size_t j = 0; j < n_fft; j++) {
+            err_rt = std::max(err_rt, (double)std::fabs(y[j] - x[j]));
+        }
+
+        const auto t0 = std::chrono::steady_clock::now();
+        for (int r = 0; r < n_rounds; r++) {
+            plan.forward(y.data(), re.data(), im.data());
+            plan.inverse(re.data(), im.data(), y.data());
+        }
+        const double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - t0).count() / n_rounds;
+        if (&kernel == &kernels[0]) {
+            ns_scalar = ns;
+        }
+
+        const bool pass = err <= tol && err_rt <= tol;
+        ok = ok && pass;
+        printf("  %-10s %12.1f %10.2f %14.2g %14.2g%s\n", kernel.name, ns, ns > 0.0 ? ns_scalar / ns : 0.0,
+            err, err_rt, pass ? "" : "  FAIL");
+    }
+
+    if (!ok) {
+        LOG_ERR("fft kernels differ from the direct dft by more than %g", tol);
+    }
+    return ok;
+}
+
+/**
+ * 合成平稳的房间噪声：低频加重的宽带噪声（风扇、空调）加上工频嗡声。
+ *
+ * @param noise 输出的噪声，范围约 [-0.5, 0.5]，长度不变。
+ */
+static void bench_denoise_noise_synth(std::vector<float> &noise)
+{
+    uint32_t seed = 777;
+    double brown = 0.0;
+    for (size_t i = 0; i < noise.size(); i++) {
+        seed = seed * 1664525u + 1013904223u;
+        const double white = (double)(seed >> 8) / (1 << 24) - 0.5;
+        const double t = (double)i / BENCH_OUTPUT_RATE;
+        brown = 0.995 * brown + 0.05 * white;
+        noise[i] = (float)(brown + 0.1 * white + 0.05 * sin(2.0 * M_PI * 120.0 * t));
+    }
+}
+
+/**
+ * 在合成的浊音段上叠加不同信噪比的房间噪声，按 --length 分块降噪，
+ * 统计语音段的信噪比提升（残差包括剩余噪声和语音失真）和静音段的噪声衰减。
+ *
+ * @param params 命令行参数，--dn-floor 为增益下限，--length 为块长。
+ * @return 成功返回 true，失败返回 false。
+ */
+static bool bench_denoise_synth(const whisper_params_t &params)
+{
+    bench_audio_t speech;
+    bench_vad_synth(speech);
+
+    const size_t n = speech.pcm.size();
+    std::vector<float> clean(n), noise(n), noisy(n);
+    pcm_s16_to_f32(speech.pcm.data(), clean.data(), n);
+    bench_denoise_noise_synth(noise);
+
+    // 浊音段即每 3 秒中间的 1 秒
+    std::vector<bool> voiced(n);
+    double p_speech = 0.0, p_noise = 0.0;
+    size_t n_voiced = 0;
+    for (size_t i = 0; i < n; i++) {
+        const double t = fmod((double)i / speech.sample_rate, 3.0);
+        voiced[i] = t >= 1.0 && t < 2.0;
+        if (voiced[i]) {
+            p_speech += (double)clean[i] * clean[i];
+            n_voiced++;
+        }
+        p_noise += (double)noise[i] * noise[i];
+    }
+    p_speech /= std::max<size_t>(n_voiced, 1);
+    p_noise  /= n;
+
+    const size_t n_block = (size_t)std::max(1, params.length_ms) * speech.sample_rate / 1000;
+
+    denoise_params_t dparams;
+    dparams.floor_db = params.denoise_floor_db;
+
+    printf("denoise: voiced bursts + fan noise, %.1f sec in %zu ms blocks, gain floor %.1f dB\n",
+        (double)n / speech.sample_rate, n_block * 1000 / speech.sample_rate, dparams.floor_db);
+    printf("  %-10s %12s %12s %14s %12s %12s\n", "input snr", "output snr", "snr gain", "noise removed", "ns/frame", "x realtime");
+
+    const float snrs[] = { 0.0f, 5.0f, 10.0f, 20.0f };
+    for (float snr : snrs) {
+        const float scale = (float)std::sqrt(p_speech / p_noise / pow(10.0, snr / 10.0));
+        for (size_t i = 0; i < n; i++) {
+            noisy[i] = clean[i] + scale * noise[i];
+        }
+
+        denoiser_t dn;
+        if (!dn.init(dparams, n_block)) {
+            LOG_ERR("fail to init denoiser");
+            return false;
+        }
+
+        std::vector<float> out = noisy;
+        for (size_t i = 0; i < n; i += n_block) {
+            dn.process(out.data() + i, std::min(n_block, n - i));
+        }
+
+        double s_in = 0.0, e_in = 0.0, e_out = 0.0, q_in = 0.0, q_out = 0.0;
+        for (size_t i = 0; i < n; i++) {
+            if (voiced[i]) {
+                s_in  += (double)clean[i] * clean[i];
+                e_in  += (double)(noisy[i] - clean[i]) * (noisy[i] - clean[i]);
+                e_out += (double)(out[i] - clean[i]) * (out[i] - clean[i]);
+            } else {
+                q_in  += (double)noisy[i] * noisy[i];
+                q_out += (double)out[i] * out[i];
+            }
+        }
+
+        const denoise_stats_t &st = dn.stats();
+        const double snr_in  = 10.0 * log10(s_in / std::max(e_in, 1e-20));
+        const double snr_out = 10.0 * log10(s_in / std::max(e_out, 1e-20));
+        const double ns_frame = st.n_frames ? (double)st.ns_total / st.n_frames : 0.0;
+        printf("  %7.1f dB %9.1f dB %9.1f dB %11.1f dB %12.1f %12.0f\n", snr_in, snr_out, snr_out - snr_in,
+            10.0 * log10(q_in / std::max(q_out, 1e-20)), ns_frame,
+            st.ns_total ? (double)n / speech.sample_rate * 1e9 / st.ns_total : 0.0);
+    }
+
+    return true;
+}
+
+/**
+ * 一种前端设置的解码统计。
+ */
+struct bench_decode_stats_t {
+    uint64_t ns_total   = 0;    ///< 累计推理耗时（纳秒）
+    uint64_t ns_denoise = 0;    ///< 累计降噪耗时（纳秒）
+    uint64_t n_passes   = 0;    ///< 累计解码轮数
+    size_t n_fallback   = 0;    ///< 发生温度回退的语音段数
+    size_t n_empty      = 0;    ///< 没有输出文本的语音段数
+};
+
+/**
+ * 在 -i 指定的带噪录音上比较降噪前后的解码：按 VAD 切出语音段（两种设置用同样的语音段），
+ * 每段分别直接转写和降噪后转写，统计温度回退和推理耗时。降噪器跨段保持噪声估计，与 VAD 模式一致。
+ *
+ * @param params 命令行参数，-m 指定模型，-i 指定 16 kHz 带噪录音。
+ * @return 成功返回 true，失败返回 false。
+ */
+static bool bench_denoise_decode(const whisper_params_t &params)
+{
+    bench_audio_t audio;
+    if (!bench_load_audio(params, audio)) {
+        LOG_ERR("fail to load bench input");
+        return false;
+    }
+    if (audio.sample_rate != BENCH_OUTPUT_RATE) {
+        LOG_ERR("denoise needs %d Hz input, got %d Hz", BENCH_OUTPUT_RATE, audio.sample_rate);
+        return false;
+    }
+
+    frame_vad_params_t vparams;
+    if (!whisper_stream_vad_params(params, vparams)) {
+        LOG_ERR("unknown vad model '%s'", params.vad_model.c_str());
+        return false;
+    }
+
+    std::vector<bench_span_t> spans;
+    if (!bench_speech_spans(params, vparams, audio, spans) || spans.empty()) {
+        LOG_ERR("no speech found in %s", params.input.c_str());
+        return false;
+    }
+
+    size_t n_max = 0;
+    for (const bench_span_t &span : spans) {
+        n_max = std::max(n_max, span.t1 - span.t0);
+    }
+
+    denoise_params_t dparams;
+    dparams.floor_db = params.denoise_floor_db;
+    denoiser_t dn;
+    if (!dn.init(dparams, n_max)) {
+        LOG_ERR("fail to init denoiser");
+        return false;
+    }
+
+    bench_model_t model;
+    if (!bench_model_load(params, model)) {
+        return false;
+    }
+    whisper_context *ctx = model.ctx;
+    whisper_state *state = model.state;
+
+    const int n_ctx_max = whisper_model_n_audio_ctx(ctx);
+
+    bench_decode_stats_t raw, clean;
+    std::vector<float> pcmf32;
+    std::string raw_text, text;
+    uint64_t ns = 0;
+    int n_passes = 0;
+    bool ok = true;
+
+    for (size_t i = 0; ok && i < spans.size(); i++) {
+        const bench_span_t &span = spans[i];
+        pcmf32.resize(span.t1 - span.t0);
+        pcm_s16_to_f32(audio.pcm.data() + span.t0, pcmf32.data(), pcmf32.size());
+
+        const int audio_ctx = whisper_stream_audio_ctx(params, (int)pcmf32.size(), n_ctx_max);
+
+        bench_decode_stats_t *rows[] = { &raw, &clean };
+        std::string *texts[] = { &raw_text, &text };
+        for (int r = 0; ok && r < 2; r++) {
+            bench_decode_stats_t &st = *rows[r];
+            if (r == 1) {
+                const uint64_t ns_before = dn.stats().ns_total;
+                dn.process(pcmf32.data(), pcmf32.size());
+                st.ns_denoise += dn.stats().ns_total - ns_before;
+            }
+
+            if (!bench_transcribe(ctx, state, params, pcmf32, audio_ctx, *texts[r], ns, &n_passes)) {
+                ok = false;
+                break;
+            }
+            st.ns_total   += ns;
+            st.n_passes   += n_passes;
+            st.n_fallback += n_passes > 1;
+            st.n_empty    += bench_words(*texts[r]).empty();
+        }
+
+        LOG_DBG("#%zu %.2f-%.2f sec: raw '%s' | denoised '%s'", i,
+            (double)span.t0 / audio.sample_rate, (double)span.t1 / audio.sample_rate,
+            raw_text.c_str(), text.c_str());
+    }
+
+    if (!ok) {
+        return false;
+    }
+
+    const double n_spans = (double)spans.size();
+    printf("decode: %s, %zu utterances, %s, noise estimate %.1f dBFS\n", params.input.c_str(), spans.size(),
+        params.no_fallback ? "temperature fallback disabled" : "temperature fallback enabled", dn.noise_db());
+    printf("  %-10s %12s %14s %10s %12s %12s %10s\n", "front end", "passes/utt", "fallback utts", "empty", "ms/utt", "denoise ms", "speedup");
+
+    const bench_decode_stats_t *rows[] = { &raw, &clean };
+    const char *names[] = { "raw", "denoise" };
+    for (int r = 0; r < 2; r++) {
+        const bench_decode_stats_t &st = *rows[r];
+        const uint64_t ns_all = st.ns_total + st.ns_denoise;
+        printf("  %-10s %12.2f %8zu/%-5zu %10zu %12.1f %12.2f %9.2fx\n", names[r],
+            st.n_passes / n_spans, st.n_fallback, spans.size(), st.n_empty,
+            ns_all / 1e6 / n_spans, st.ns_denoise / 1e6 / n_spans,
+            ns_all ? (double)raw.ns_total / ns_all : 0.0);
+    }
+
+    return true;
+}
+
+/**
+ * 降噪基准测试：校验 FFT 的各个向量实现并测量耗时，在合成的带噪语音上测量信噪比提升和每帧耗时；
+ * -i 指定带噪语音录音时，再用 -m 指定的模型比较降噪前后的温度回退次数和总解码耗时。
+ *
+ * @param params 命令行参数，--dn-floor 为增益下限，-i 为可选的 16 kHz 带噪语音录音。
+ * @return 成功返回 0，失败返回 -1。
+ */
+static int bench_denoise(const whisper_params_t &params, const whisper_engine_task_t &)
+{
+    if (!bench_denoise_fft()) {
+        return -1;
+    }
+    printf("\n");
+
+    if (!bench_denoise_synth(params)) {
+        return -1;
+    }
+
+    if (params.input.empty()) {
+        return 0;
+    }
+    printf("\n");
+
+    return bench_denoise_decode(params) ? 0 : -1;
+}
+
+/**
+ * 一种解码方式的统计。
+ */
+struct bench_grammar_stats_t {
+    uint64_t ns_total   = 0;    ///< 累计推理耗时（纳秒）
+    uint64_t n_passes   = 0;    ///< 累计解码轮数
+    size_t n_fallback   = 0;    ///< 发生温度回退的语音段数
+    size_t n_matched    = 0;    ///< 输出文本匹配到命令代码的语音段数
+};
+
+/**
+ * 语法约束解码基准测试：在 -i 指定的命令录音上按 VAD 切出语音段，每段分别不加约束和按 -u 生成的语法解码，
+ * 比较推理耗时、温度回退和匹配到命令代码的语音段数。
+ *
+ * @param params 命令行参数，-m 指定模型，-i 指定 16 kHz 命令录音，--gr-penalty 为语法惩罚。
+ * @param task 识别任务，提供命令表和由它生成的语法。
+ * @return 成功返回 0，失败返回 -1。
+ */
+static int bench_grammar(const whisper_params_t &params, const whisper_engine_task_t &task)
+{
+    if (!task.grammar || !task.fuzzy) {
+        LOG_ERR("grammar needs the command texts of -u");
+        return -1;
+    }
+    if (params.input.empty()) {
+        LOG_ERR("grammar needs a recording of spoken commands, use -i");
+        return -1;
+    }
+
+    bench_audio_t audio;
+    if (!bench_load_audio(params, audio)) {
+        LOG_ERR("fail to load bench input");
+        return -1;
+    }
+    if (audio.sample_rate != BENCH_OUTPUT_RATE) {
+        LOG_ERR("grammar needs %d Hz input, got %d Hz", BENCH_OUTPUT_RATE, audio.sample_rate);
+        return -1;
+    }
+
+    frame_vad_params_t vparams;
+    if (!whisper_stream_vad_params(params, vparams)) {
+        LOG_ERR("unknown vad model '%s'", params.vad_model.c_str());
+        return -1;
+    }
+
+    std::vector<bench_span_t> spans;
+    if (!bench_speech_spans(params, vparams, audio, spans) || spans.empty()) {
+        LOG_ERR("no speech found in %s", params.input.c_str());
+        return -1;
+    }
+
+    bench_model_t model;
+    if (!bench_model_load(params, model)) {
+        return -1;
+    }
+    whisper_context *ctx = model.ctx;
+    whisper_state *state = model.state;
+
+    const int n_ctx_max = whisper_model_n_audio_ctx(ctx);
+    const command_grammar_t *grammars[] = { nullptr, task.grammar };
+
+    bench_grammar_stats_t stats[2];
+    std::vector<float> pcmf32;
+    std::string texts[2];
+    const char *codes[2] = { "", "" };
+    uint64_t ns = 0;
+    int n_passes = 0;
+    bool ok = true;
+
+    for (size_t i = 0; ok && i < spans.size(); i++) {
+        const bench_span_t &span = spans[i];
+        pcmf32.resize(span.t1 - span.t0);
+        pcm_s16_to_f32(audio.pcm.data() + span.t0, pcmf32.data(), pcmf32.size());
+
+        const int audio_ctx = whisper_stream_audio_ctx(params, (int)pcmf32.size(), n_ctx_max);
+
+        for (int r = 0; r < 2; r++) {
+            bench_grammar_stats_t &st = stats[r];
+            if (!bench_transcribe(ctx, state, params, pcmf32, audio_ctx, texts[r], ns, &n_passes, grammars[r])) {
+                ok = false;
+                break;
+            }
+            codes[r] = whisper_fuzzy_code(task.fuzzy, texts[r].c_str());
+
+            st.ns_total   += ns;
+            st.n_passes   += n_passes;
+            st.n_fallback += n_passes > 1;
+            st.n_matched  += strcmp(codes[r], "0x00") != 0;
+        }
+
+        LOG_DBG("#%zu %.2f-%.2f sec: free '%s' (%s) | grammar '%s' (%s)", i,
+            (double)span.t0 / audio.sample_rate, (double)span.t1 / audio.sample_rate,
+            texts[0].c_str(), codes[0], texts[1].c_str(), codes[1]);
+    }
+
+    if (!ok) {
+        return -1;
+    }
+
+    const double n_spans = (double)spans.size();
+    printf("decode: %s, %zu utterances, %zu commands in %zu grammar rules, penalty %.1f, %s\n",
+        params.input.c_str(), spans.size(), task.grammar->n_texts, task.grammar->rules.size(), params.grammar_penalty,
+        params.no_fallback ? "temperature fallback disabled" : "temperature fallback enabled");
+    printf("  %-10s %12s %14s %14s %12s %10s\n", "decoding", "passes/utt", "fallback utts", "matched utts", "ms/utt", "speedup");
+
+    const char *names[] = { "free", "grammar" };
+    for (int r = 0; r < 2; r++) {
+        const bench_grammar_stats_t &st = stats[r];
+        printf("  %-10s %12.2f %8zu/%-5zu %8zu/%-5zu %12.1f %9.2fx\n", names[r],
+            st.n_passes / n_spans, st.n_fallback, spans.size(), st.n_matched, spans.size(),
+            st.ns_total / 1e6 / n_spans, st.ns_total ? (double)stats[0].ns_total / st.ns_total : 0.0);
+    }
+
+    return 0;
+}
+
+/**
+ * 基准测试表项。
+ */
+struct bench_entry_t {
+    const char *name;                                                   ///< 名称
+    int (*run)(const whisper_params_t &, const whisper_engine_task_t &); ///< 入口函数
+};
+
+static const bench_entry_t g_benches[] = {
+    { "resample", bench_resample },
+    { "vad",      bench_vad },
+    { "vad-noise", bench_vad_noise },
+    { "audio-ctx", bench_audio_ctx },
+    { "denoise",  bench_denoise },
+    { "grammar",  bench_grammar },
+};
+
+/**
+ * 运行 --bench 指定的基准测试，结果输出到标准输出。
+ *
+ * @param task 识别任务，task.params.bench 为基准测试名称；grammar 还用到其中的命令表和语法。
+ * @return 成功返回 0，失败返回 -1。
+ */
+int whisper_bench_main(const whisper_engine_task_t &task)
+{
+    const whisper_params_t &params = task.params;
+
+    for (const bench_entry_t &b : g_benches) {
+        if (params.bench == b.name) {
+            return b.run(params, task);
+        }
+    }
+
+    LOG_ERR("unknown benchmark '%s', available:", params.bench.c_str());
+    for (const bench_entry_t &b : g_benches) {
+        LOG_ERR("    %s", b.name);
+    }
+    return -1;
+}
@@ -0,0 +1,14 @@
+#ifndef WHISPER_BENCH_H_
+#define WHISPER_BENCH_H_
+
+#include "whisper_stream.h"
+
+/**
+ * 运行 --bench 指定的基准测试，结果输出到标准输出。
+ *
+ * @param task 识别任务，task.params.bench 为基准测试名称；grammar 还用到其中的命令表和语法。
+ * @return 成功返回 0，失败返回 -1。
+ */
+int whisper_bench_main(const whisper_engine_task_t &task);
+
+#endif  // WHISPER_BENCH_H_
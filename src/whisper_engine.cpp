@@ -0,0 +1,214 @@
+#include "whisper_engine.h"
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+
+#include "whisper.h"
+#include "debug.h"
+
+/**
+ * 加载线程：加载模型，创建第一个推理状态，并用一段静音按识别会话的参数推理一次。
+ *
+ * @param engine 引擎。
+ * @param params 命令行参数的副本。
+ */
+static void whisper_engine_load(whisper_engine_t &engine, whisper_params_t params)
+{
+    const auto t_start = std::chrono::steady_clock::now();
+
+    struct whisper_context_params cparams = whisper_context_default_params();
+
+    cparams.use_gpu    = params.use_gpu;
+    cparams.flash_attn = params.flash_attn;
+
+    // 不带默认 state：每个会话各自创建 whisper_state
+    whisper_context *ctx = whisper_init_from_file_with_params_no_state(params.model.c_str(), cparams);
+    if (!ctx) {
+        LOG_ERR("%s: failed to load model '%s'\n", __func__, params.model.c_str());
+        return;
+    }
+
+    whisper_state *state = whisper_init_state(ctx);
+    if (!state) {
+        LOG_ERR("%s: failed to init whisper state\n", __func__);
+        whisper_free(ctx);
+        return;
+    }
+
+    const auto t_loaded = std::chrono::steady_clock::now();
+
+    // 静音的长度取一个完整窗口，编码器按相同的 audio_ctx 分配和运行
+    const int n_samples = (1e-3*std::min(std::max(params.length_ms, 1000), 30000))*WHISPER_SAMPLE_RATE;
+    std::vector<float> silence(n_samples, 0.0f);
+
+    whisper_full_params wparams = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+
+    wparams.print_progress   = false;
+    wparams.print_special    = false;
+    wparams.print_realtime   = false;
+    wparams.print_timestamps = false;
+    wparams.no_context       = true;
+    wparams.single_segment   = true;
+    wparams.language         = whisper_is_multilingual(ctx) ? params.language.c_str() : "en";
+    wparams.n_threads        = params.n_threads;
+    wparams.audio_ctx        = whisper_stream_audio_ctx(params, n_samples, whisper_model_n_audio_ctx(ctx));
+    wparams.temperature_inc  = 0.0f;   // 只为预热，静音上不需要温度回退
+
+    if (whisper_full_with_state(ctx, state, wparams, silence.data(), n_samples) != 0) {
+        LOG_ERR("%s: warm-up inference failed\n", __func__);
+        whisper_free_state(state);
+        whisper_free(ctx);
+        return;
+    }
+
+    const auto t_end = std::chrono::steady_clock::now();
+
+    engine.ctx = ctx;
+    engine.states.push_back(state);
+    engine.idle.push_back(state);
+    engine.t_load_us   = std::chrono::duration_cast<std::chrono::microseconds>(t_loaded - t_start).count();
+    engine.t_warmup_us = std::chrono::duration_cast<std::chrono::microseconds>(t_end - t_loaded).count();
+    engine.loaded = true;
+}
+
+/**
+ * 在后台线程中加载模型并用一段静音做一次推理预热，立即返回。
+ *
+ * 预热让第一次真正的推理不再承担计算缓冲区分配、权重首次访问和冷缓存的开销。
+ *
+ * @param engine 引擎，调用前不能已经在加载。
+ * @param params 命令行参数，加载线程使用其副本。
+ */
+void whisper_engine_start(whisper_engine_t &engine, const whisper_params_t &params)
+{
+    whisper_engine_t *e = &engine;
+    engine.loader = std::thread([e, params]() { whisper_engine_load(*e, params); });
+}
+
+/**
+ * 等待后台加载和预热完成，可重复调用。
+ *
+ * @param engine 引擎。
+ * @return 模型可用返回 true，加载失败返回 false。
+ */
+bool whisper_engine_wait(whisper_engine_t &engine)
+{
+    // 多个任务可能同时等待，只能有一个线程 join
+    std::lock_guard<std::mutex> lock(engine.mutex);
+    if (engine.loader.joinable()) {
+        engine.loader.join();
+    }
+    return engine.loaded;
+}
+
+/**
+ * 为任务借一个推理状态：优先复用空闲的，没有时新建。归还之前只由这个任务使用。
+ *
+ * @param task 任务，借到的状态记录在 task.states 中。
+ * @return 推理状态，模型不可用或创建失败返回 nullptr。
+ */
+whisper_state *whisper_engine_acquire(whisper_engine_task_t &task)
+{
+    whisper_engine_t &engine = *task.engine;
+    if (!whisper_engine_wait(engine)) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(engine.mutex);
+
+    whisper_state *state = nullptr;
+    if (!engine.idle.empty()) {
+        state = engine.idle.back();
+        engine.idle.pop_back();
+    } else {
+        state = whisper_init_state(engine.ctx);
+        if (!state) {
+            LOG_ERR("%s: failed to init whisper state %d\n", __func__, (int) engine.states.size());
+            return nullptr;
+        }
+        engine.states.push_back(state);
+    }
+
+    engine.n_busy++;
+    engine.n_busy_max = std::max(engine.n_busy_max, engine.n_busy);
+    task.states.push_back(state);
+
+    return state;
+}
+
+/**
+ * 归还任务借用的全部推理状态，调用前使用这些状态的线程必须已结束。
+ *
+ * @param task 任务。
+ */
+void whisper_engine_release(whisper_engine_task_t &task)
+{
+    if (task.states.empty()) {
+        return;
+    }
+
+    whisper_engine_t &engine = *task.engine;
+    std::lock_guard<std::mutex> lock(engine.mutex);
+
+    for (whisper_state *state : task.states) {
+        engine.idle.push_back(state);
+        engine.n_busy--;
+    }
+    task.states.clear();
+}
+
+/**
+ * 把识别到的文本转换为命令代码，交给任务自己的回调，可在多个线程中同时调用。
+ *
+ * @param task 任务。
+ * @param stream 识别会话序号。
+ * @param leat_count 剩余匹配数量。
+ * @param text 识别到的文本。
+ * @return 回调的返回值，没有回调返回 -1。
+ */
+int whisper_engine_match(const whisper_engine_task_t &task, int stream, size_t leat_count, const char *text)
+{
+    if (!text || (!task.callback && !task.stream_callback)) {
+        LOG_ERR("args fail!  text(%p), callback(%p)", text, (void *) task.callback);
+        return -1;
+    }
+
+    const char *code = whisper_fuzzy_code(task.fuzzy, text);
+
+    if (task.stream_callback) {
+        return task.stream_callback(stream, leat_count, text, code, task.userdata);
+    }
+    return task.callback(leat_count, text, code, task.userdata);
+}
+
+/**
+ * 等待加载线程结束，释放全部推理状态和模型。调用前所有任务必须已结束。
+ *
+ * @param engine 引擎。
+ */
+void whisper_engine_free(whisper_engine_t &engine)
+{
+    whisper_engine_wait(engine);
+
+    std::lock_guard<std::mutex> lock(engine.mutex);
+
+    if (engine.n_busy_max > 0) {
+        LOG_INFO("engine: %d whisper states for up to %d concurrent streams, one shared model",
+            (int) engine.states.size(), engine.n_busy_max);
+    }
+
+    // whisper_state 引用模型，必须先于 ctx 释放
+    for (whisper_state *state : engine.states) {
+        whisper_free_state(state);
+    }
+    engine.states.clear();
+    engine.idle.clear();
+    engine.n_busy = 0;
+
+    if (engine.ctx) {
+        whisper_free(engine.ctx);
+        engine.ctx = nullptr;
+    }
+    engine.loaded = false;
+}
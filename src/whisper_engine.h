@@ -0,0 +1,102 @@
+#ifndef WHISPER_ENGINE_H_
+#define WHISPER_ENGINE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "whisper_stream.h"
+
+struct command_grammar_t;
+
+/**
+ * 识别引擎：常驻模型和推理状态池，所有识别任务共享。
+ *
+ * 模型权重（whisper_context）只加载一次；每一路采集各从池中借一个 whisper_state（KV 缓存和计算缓冲区），
+ * 用 whisper_full_with_state() 推理。N 路同时识别只占一份模型内存加上 N 个状态，
+ * 任务结束后状态归还到池中，下一个任务直接复用，不用重新分配。
+ * 除 whisper_engine_start() 和 whisper_engine_free() 外，所有函数都可以在多个线程中同时调用。
+ */
+struct whisper_engine_t {
+    whisper_context *ctx = nullptr;         ///< 模型，加载失败时为空
+    std::thread loader;                     ///< 加载和预热线程
+    bool loaded = false;                    ///< 加载线程是否成功完成，loader 结束后才可读取
+    int64_t t_load_us   = 0;                ///< 加载模型耗时（微秒）
+    int64_t t_warmup_us = 0;                ///< 预热推理耗时（微秒）
+
+    std::mutex mutex;                       ///< 保护以下成员和 loader 的 join
+    std::vector<whisper_state *> states;    ///< 已创建的全部推理状态
+    std::vector<whisper_state *> idle;      ///< 空闲的推理状态，最近归还的在末尾
+    int n_busy     = 0;                     ///< 借出的推理状态数
+    int n_busy_max = 0;                     ///< 同时借出的最大推理状态数
+};
+
+/**
+ * 一个识别任务，即一次 whisper_fuzzy() 调用：自己的参数副本、回调和推理状态，
+ * 与同时运行的其他任务互不干扰，只共享引擎和只读的命令表。
+ */
+struct whisper_engine_task_t {
+    whisper_engine_t *engine = nullptr;                 ///< 共享的引擎
+    whisper_fuzzy_t *fuzzy = nullptr;                   ///< 命令表，只读
+    const command_grammar_t *grammar = nullptr;         ///< 由命令表生成的解码语法，只读，没有 -gr 和 --bench grammar 时为空
+    whisper_params_t params;                            ///< 本任务的参数副本，识别过程中会按模式调整
+    whisper_callback_t callback = nullptr;              ///< 事件回调
+    whisper_stream_callback_t stream_callback = nullptr; ///< 带识别会话序号的事件回调，设置时优先使用
+    void *userdata = nullptr;                           ///< 用户数据
+    std::vector<whisper_state *> states;                ///< 本任务借用的推理状态，结束时归还
+};
+
+/**
+ * 在后台线程中加载模型并用一段静音做一次推理预热，立即返回。
+ *
+ * 预热让第一次真正的推理不再承担计算缓冲区分配、权重首次访问和冷缓存的开销。
+ *
+ * @param engine 引擎，调用前不能已经在加载。
+ * @param params 命令行参数，加载线程使用其副本。
+ */
+void whisper_engine_start(whisper_engine_t &engine, const whisper_params_t &params);
+
+/**
+ * 等待后台加载和预热完成，可重复调用。
+ *
+ * @param engine 引擎。
+ * @return 模型可用返回 true，加载失败返回 false。
+ */
+bool whisper_engine_wait(whisper_engine_t &engine);
+
+/**
+ * 为任务借一个推理状态：优先复用空闲的，没有时新建。归还之前只由这个任务使用。
+ *
+ * @param task 任务，借到的状态记录在 task.states 中。
+ * @return 推理状态，模型不可用或创建失败返回 nullptr。
+ */
+whisper_state *whisper_engine_acquire(whisper_engine_task_t &task);
+
+/**
+ * 归还任务借用的全部推理状态，调用前使用这些状态的线程必须已结束。
+ *
+ * @param task 任务。
+ */
+void whisper_engine_release(whisper_engine_task_t &task);
+
+/**
+ * 把识别到的文本转换为命令代码，交给任务自己的回调，可在多个线程中同时调用。
+ *
+ * @param task 任务。
+ * @param stream 识别会话序号。
+ * @param leat_count 剩余匹配数量。
+ * @param text 识别到的文本。
+ * @return 回调的返回值，没有回调返回 -1。
+ */
+int whisper_engine_match(const whisper_engine_task_t &task, int stream, size_t leat_count, const char *text);
+
+/**
+ * 等待加载线程结束，释放全部推理状态和模型。调用前所有任务必须已结束。
+ *
+ * @param engine 引擎。
+ */
+void whisper_engine_free(whisper_engine_t &engine);
+
+#endif  // WHISPER_ENGINE_H_
@@ -1,11 +1,17 @@
 #include "whisper_stream.h"
 
+#include <algorithm>
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
+#include <new>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "whisper.h"
+#include "whisper_engine.h"
+#include "command_grammar.h"
 #include "json.hpp"
 #include "debug.h"
 
@@ -16,10 +22,10 @@ using json = nlohmann::json;
  * Whisper 结构体，包含语音计数和映射数据。
  */
 typedef struct whisper_fuzzy_t {
-    whisper_params_t *params;                           ///< 输入参数
-    whisper_callback_t callback;                        ///< 事件回调
-    void *userdata;                                     ///< 用户数据
-    std::unordered_map<std::string, std::string>* map;  ///< 指向存储文本转换映射的哈希表指针。
+    whisper_params_t *params;                           ///< 输入参数，每次 whisper_fuzzy() 调用复制一份
+    std::unordered_map<std::string, std::string>* map;  ///< 指向存储文本转换映射的哈希表指针，初始化后只读。
+    whisper_engine_t *engine;                           ///< 常驻模型和推理状态池，--bench 模式下为空
+    command_grammar_t *grammar;                         ///< 由命令文本生成的解码语法，只在 -gr 或 --bench grammar 时生成，初始化后只读
 } whisper_fuzzy_t;
 
 /**
@@ -32,6 +38,35 @@ whisper_params_t *whisper_fuzzy_get_params(whisper_fuzzy_t *w)
     return w ? w->params : nullptr;
 }
 
+/**
+ * 解析以逗号分隔的设备 ID 列表，例如 "0,2"。
+ *
+ * @param str 设备 ID 列表。
+ * @param ids 输出的设备 ID，覆盖原有内容。
+ * @return 解析成功返回 true，失败返回 false。
+ */
+static bool whisper_fuzzy_parse_ids(const std::string &str, std::vector<int32_t> &ids)
+{
+    ids.clear();
+
+    size_t pos = 0;
+    while (pos <= str.size()) {
+        const size_t end = std::min(str.find(',', pos), str.size());
+        const std::string item = str.substr(pos, end - pos);
+
+        char *tail = nullptr;
+        const long id = strtol(item.c_str(), &tail, 10);
+        if (item.empty() || *tail != '\0') {
+            fprintf(stderr, "error: bad device id list: %s\n", str.c_str());
+            return false;
+        }
+        ids.push_back((int32_t) id);
+        pos = end + 1;
+    }
+
+    return true;
+}
+
 /**
  * 解析命令行参数并填充 whisper_params_t 结构体。
  *
@@ -51,13 +86,28 @@ static bool whisper_fuzzy_params_parse(int argc, char const* argv[], whisper_par
         }
         else if (arg == "-t"    || arg == "--threads")       { params.n_threads     = std::stoi(argv[++i]); }
         else if (                  arg == "--step")          { params.step_ms       = std::stoi(argv[++i]); }
+        else if (arg == "-sv"   || arg == "--step-vad")      { params.step_vad      = true; }
         else if (                  arg == "--length")        { params.length_ms     = std::stoi(argv[++i]); }
         else if (                  arg == "--keep")          { params.keep_ms       = std::stoi(argv[++i]); }
-        else if (arg == "-c"    || arg == "--capture")       { params.capture_id    = std::stoi(argv[++i]); }
+        else if (arg == "-c"    || arg == "--capture")       { if (!whisper_fuzzy_parse_ids(argv[++i], params.capture_ids)) { whisper_print_usage(params); exit(0); } }
         else if (arg == "-d"    || arg == "--debug")         { set_dbg_enable(log_dbg_flag_t(std::stoi(argv[++i]))); }
         else if (arg == "-mt"   || arg == "--max-tokens")    { params.max_tokens    = std::stoi(argv[++i]); }
         else if (arg == "-ac"   || arg == "--audio-ctx")     { params.audio_ctx     = std::stoi(argv[++i]); }
+        else if (                  arg == "--ac-margin")     { params.audio_ctx_margin_ms = std::stoi(argv[++i]); }
+        else if (                  arg == "--ac-min")        { params.audio_ctx_min = std::stoi(argv[++i]); }
         else if (arg == "-vth"  || arg == "--vad-thold")     { params.vad_thold     = std::stof(argv[++i]); }
+        else if (                  arg == "--vad-start")     { params.vad_start_ms  = std::stoi(argv[++i]); }
+        else if (                  arg == "--vad-end")       { params.vad_end_ms    = std::stoi(argv[++i]); }
+        else if (                  arg == "--vad")           { params.vad_model     = argv[++i]; }
+        else if (                  arg == "--vad-mode")      { params.vad_mode      = std::stoi(argv[++i]); }
+        else if (                  arg == "--hangover")      { params.hangover_ms   = std::stoi(argv[++i]); }
+        else if (                  arg == "--vad-margin")    { params.vad_margin_db = std::stof(argv[++i]); }
+        else if (                  arg == "--vad-min")       { params.vad_min_db    = std::stof(argv[++i]); }
+        else if (                  arg == "--vad-max")       { params.vad_max_db    = std::stof(argv[++i]); }
+        else if (arg == "-dn"   || arg == "--denoise")       { params.denoise       = true; }
+        else if (                  arg == "--dn-floor")      { params.denoise_floor_db = std::stof(argv[++i]); }
+        else if (arg == "-gr"   || arg == "--grammar")       { params.grammar       = true; }
+        else if (                  arg == "--gr-penalty")    { params.grammar_penalty = std::stof(argv[++i]); }
         else if (arg == "-fth"  || arg == "--freq-thold")    { params.freq_thold    = std::stof(argv[++i]); }
         else if (arg == "-tr"   || arg == "--translate")     { params.translate     = true; }
         else if (arg == "-nf"   || arg == "--no-fallback")   { params.no_fallback   = true; }
@@ -71,6 +121,26 @@ static bool whisper_fuzzy_params_parse(int argc, char const* argv[], whisper_par
         else if (arg == "-sa"   || arg == "--save-audio")    { params.save_audio    = true; }
         else if (arg == "-ng"   || arg == "--no-gpu")        { params.use_gpu       = false; }
         else if (arg == "-fa"   || arg == "--flash-attn")    { params.flash_attn    = true; }
+        else if (arg == "-i"    || arg == "--input")         { params.input         = argv[++i]; }
+        else if (arg == "-if"   || arg == "--input-fmt")     { params.input_format  = argv[++i]; }
+        else if (arg == "-np"   || arg == "--no-pace")       { params.input_paced   = false; }
+        else if (arg == "-ab"   || arg == "--backend")       { params.audio_backend = argv[++i]; }
+        else if (arg == "-ad"   || arg == "--alsa-dev")      { params.alsa_devices.push_back(argv[++i]); }
+        else if (                  arg == "--period-ms")     { params.period_ms     = std::stoi(argv[++i]); }
+        else if (                  arg == "--buffer-ms")     { params.buffer_ms     = std::stoi(argv[++i]); }
+        else if (arg == "-ar"   || arg == "--audio-rate")    { params.audio_rate    = std::stoi(argv[++i]); }
+        else if (arg == "-pr"   || arg == "--preroll")       { params.preroll_ms    = std::stoi(argv[++i]); }
+        else if (                  arg == "--idle")          { params.idle_ms       = std::stoi(argv[++i]); }
+        else if (arg == "-po"   || arg == "--postroll")      { params.postroll_ms   = std::stoi(argv[++i]); }
+        else if (                  arg == "--rt")            { params.realtime      = true; }
+        else if (                  arg == "--rt-prio")       { params.rt_prio       = std::stoi(argv[++i]); }
+        else if (                  arg == "--cpus")          { params.infer_cpus    = argv[++i]; }
+        else if (                  arg == "--overload")      { params.overload      = argv[++i]; }
+        else if (                  arg == "--bench")         { params.bench         = argv[++i]; }
+        else if (                  arg == "--archive")       { params.archive_dir   = argv[++i]; }
+        else if (                  arg == "--archive-pad")   { params.archive_pad_ms = std::stoi(argv[++i]); }
+        else if (                  arg == "--archive-sec")   { params.archive_sec   = std::stoi(argv[++i]); }
+        else if (                  arg == "--archive-mb")    { params.archive_mb    = std::stoi(argv[++i]); }
 
         else {
             fprintf(stderr, "error: unknown argument: %s\n", arg.c_str());
@@ -99,9 +169,11 @@ void to_lower(std::string& str)
  *
  * @param filename 配置文件的路径。
  * @param map 存储键值对的哈希表。
+ * @param texts 非空时追加配置文件中原样的命令文本，用于生成解码语法。
  * @return 成功返回 0，失败返回 -1。
  */
-int read_config(const std::string& filename, std::unordered_map<std::string, std::string>& map)
+int read_config(const std::string& filename, std::unordered_map<std::string, std::string>& map,
+                std::vector<std::string>* texts = nullptr)
 {
     std::ifstream file(filename);
     if (!file) {
@@ -115,6 +187,9 @@ int read_config(const std::string& filename, std::unordered_map<std::string, std
     for (const auto& item : config) {
         for (const auto& text : item["text"]) {
             std::string text_lower = text.get<std::string>();
+            if (texts) {
+                texts->push_back(text_lower);
+            }
             to_lower(text_lower);
 
             std::string code = item["code"].get<std::string>(); 
@@ -160,11 +235,13 @@ const char* text_to_code(std::unordered_map<std::string, std::string>& map, cons
     std::string text_lower = text;
     to_lower(text_lower);
 
-    if (map.find(text_lower) == map.end()) {
+    // 只查找不插入，多个识别会话可以同时调用
+    const auto it = map.find(text_lower);
+    if (it == map.end()) {
         LOG_ERR("unknow %s ", text_lower.c_str());
         return "0x00";
     }
-    return map[text_lower].c_str();
+    return it->second.c_str();
 }
 
 /**
@@ -178,12 +255,12 @@ whisper_fuzzy_t* whisper_fuzzy_init(int argc, char const* argv[])
 {
     int ret = 0;
 
-    whisper_fuzzy_t* w = (whisper_fuzzy_t*)malloc(sizeof(whisper_fuzzy_t));
+    // 值初始化：指针成员都为空
+    whisper_fuzzy_t* w = new (std::nothrow) whisper_fuzzy_t();
     if (!w) {
-        LOG_ERR("fail to malloc whisper");
+        LOG_ERR("fail to new whisper");
         return nullptr;
     }
-    memset(w, 0, sizeof(whisper_fuzzy_t));
     
     w->params = new whisper_params_t;
     if (!w->params) {
@@ -208,10 +285,27 @@ whisper_fuzzy_t* whisper_fuzzy_init(int argc, char const* argv[])
         goto _exit;
     }
 
-    ret = read_config(w->params->user.c_str(), *w->map);
-    if (ret < 0) {
-        LOG_DBG("fail to read_config");
-        goto _exit;
+    // 加载模型最慢，放到后台线程，与读取配置和 whisper_fuzzy() 中打开采集设备并行
+    if (w->params->bench.empty()) {
+        w->engine = new whisper_engine_t;
+        whisper_engine_start(*w->engine, *w->params);
+    }
+
+    {
+        std::vector<std::string> texts;
+        ret = read_config(w->params->user.c_str(), *w->map, &texts);
+        if (ret < 0) {
+            LOG_DBG("fail to read_config");
+            goto _exit;
+        }
+
+        if (w->params->grammar || w->params->bench == "grammar") {
+            w->grammar = new command_grammar_t;
+            if (!command_grammar_build(*w->grammar, texts)) {
+                LOG_ERR("fail to build grammar from %s", w->params->user.c_str());
+                goto _exit;
+            }
+        }
     }
     return w;
 
@@ -229,6 +323,12 @@ void whisper_fuzzy_exit(whisper_fuzzy_t* w)
 {
     if (!w)
         return;
+
+    if (w->engine) {
+        whisper_engine_free(*w->engine);
+        delete w->engine;
+        w->engine = nullptr;
+    }
     
     if (w->params) {
         delete w->params;
@@ -239,46 +339,138 @@ void whisper_fuzzy_exit(whisper_fuzzy_t* w)
         delete w->map;
         w->map = nullptr;
     }
-    free(w);
+
+    if (w->grammar) {
+        delete w->grammar;
+        w->grammar = nullptr;
+    }
+    delete w;
 }
 
 /**
  * 进行模糊匹配流程。
  *
+ * 回调由调用者给出：whisper_fuzzy_init() 返回的对象被多个任务共享，不保存任何任务的回调。
+ *
  * @param w 指向 whisper_fuzzy_t 结构体的指针。
+ * @param callback 接收匹配结果的回调。
+ * @param userdata 传递给回调函数的用户数据。
  * @param leat_count 剩余匹配数量。
  * @param text 需要匹配的文本字符串。
  * @return 成功返回匹配的评分值，失败返回 -1。
  */
-int whisper_fuzzy_match(whisper_fuzzy_t* w, size_t leat_count, const char* text)
+int whisper_fuzzy_match(whisper_fuzzy_t* w, whisper_callback_t callback, void* userdata,
+                        size_t leat_count, const char* text)
 {
-    if (!text || !w || !w->callback || !w->map) {
-        LOG_ERR("args fail!  text(%p), w(%p), callback(%p), map(%p)",
-            text, w, w ? w->callback : nullptr, w ? w->map : nullptr);
+    if (!w) {
+        LOG_ERR("whisper_fuzzy is nullptr!");
         return -1;
     }
-    std::string trim_text = str_trim(text);
-    const char* code = text_to_code(*w->map, trim_text.c_str());
 
-    return w->callback(leat_count, text, code, w->userdata);
+    whisper_engine_task_t task;
+    task.fuzzy    = w;
+    task.callback = callback;
+    task.userdata = userdata;
+
+    return whisper_engine_match(task, 0, leat_count, text);
 }
 
 /**
- * 处理 Whisper 任务。
+ * 对指定识别会话的文本进行模糊匹配流程，结果交给调用者给出的回调，可在多个线程中同时调用。
  *
  * @param w 指向 whisper_fuzzy_t 结构体的指针。
- * @param callback 处理完成后的回调函数。
+ * @param callback 接收匹配结果的带会话序号的回调。
+ * @param userdata 传递给回调函数的用户数据。
+ * @param stream 识别会话序号。
+ * @param leat_count 剩余匹配数量。
+ * @param text 需要匹配的文本字符串。
+ * @return 成功返回匹配的评分值，失败返回 -1。
+ */
+int whisper_fuzzy_match_stream(whisper_fuzzy_t* w, whisper_stream_callback_t callback, void* userdata,
+                               int stream, size_t leat_count, const char* text)
+{
+    if (!w) {
+        LOG_ERR("whisper_fuzzy is nullptr!");
+        return -1;
+    }
+
+    whisper_engine_task_t task;
+    task.fuzzy           = w;
+    task.stream_callback = callback;
+    task.userdata        = userdata;
+
+    return whisper_engine_match(task, stream, leat_count, text);
+}
+
+/**
+ * 把识别到的文本转换为 config.json 中的命令代码，只读，可在多个线程中同时调用。
+ *
+ * @param w 指向 whisper_fuzzy_t 结构体的指针。
+ * @param text 识别到的文本，忽略首尾空白和大小写。
+ * @return 命令代码，没有匹配时返回 "0x00"。
+ */
+const char* whisper_fuzzy_code(whisper_fuzzy_t* w, const char* text)
+{
+    if (!w || !w->map || !text) {
+        LOG_ERR("args fail!  text(%p), w(%p), map(%p)", text, w, w ? w->map : nullptr);
+        return "0x00";
+    }
+    std::string trim_text = str_trim(text);
+    return text_to_code(*w->map, trim_text.c_str());
+}
+
+/**
+ * 运行一个识别任务：复制参数，记下回调，从引擎借推理状态，返回前归还。
+ *
+ * @param w 指向 whisper_fuzzy_t 结构体的指针。
+ * @param callback 事件回调，与 stream_callback 二选一。
+ * @param stream_callback 带识别会话序号的事件回调。
  * @param userdata 传递给回调函数的用户数据。
  * @return 成功返回 0，失败返回 -1。
  */
-int whisper_fuzzy(whisper_fuzzy_t* w, whisper_callback_t callback, void* userdata)
+static int whisper_fuzzy_run(whisper_fuzzy_t* w, whisper_callback_t callback,
+                             whisper_stream_callback_t stream_callback, void* userdata)
 {
     if (!w) {
         LOG_ERR("whisper_fuzzy is nullptr!");
         return -1;
     }
-    w->callback = callback;
-    w->userdata = userdata;
 
-    return whisper_stream_main(w);
+    // 每次调用一个任务，参数和回调都是自己的，多个线程同时调用互不覆盖
+    whisper_engine_task_t task;
+    task.engine          = w->engine;
+    task.fuzzy           = w;
+    task.grammar         = w->grammar;
+    task.params          = *w->params;
+    task.callback        = callback;
+    task.stream_callback = stream_callback;
+    task.userdata        = userdata;
+
+    return whisper_stream_main(task);
+}
+
+/**
+ * 处理 Whisper 任务，可在多个线程中同时调用，共享同一份模型。
+ *
+ * @param w 指向 whisper_fuzzy_t 结构体的指针。
+ * @param callback 处理完成后的回调函数。
+ * @param userdata 传递给回调函数的用户数据。
+ * @return 成功返回 0，失败返回 -1。
+ */
+int whisper_fuzzy(whisper_fuzzy_t* w, whisper_callback_t callback, void* userdata)
+{
+    return whisper_fuzzy_run(w, callback, nullptr, userdata);
+}
+
+/**
+ * 处理 Whisper 任务，每个采集设备一路识别会话，回调中带有会话序号。可在多个线程中同时调用，共享同一份模型。
+ *
+ * @param w 指向 whisper_fuzzy_t 结构体的指针。
+ * @param callback 处理完成后的回调函数，多个会话可能在各自线程中同时调用。
+ * @param userdata 传递给回调函数的用户数据。
+ * @return 成功返回 0，失败返回 -1。
+ */
+int whisper_fuzzy_streams(whisper_fuzzy_t* w, whisper_stream_callback_t callback, void* userdata)
+{
+    return whisper_fuzzy_run(w, nullptr, callback, userdata);
 }
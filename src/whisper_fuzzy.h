@@ -24,6 +24,18 @@ struct whisper_params_t;
  */
 typedef int (*whisper_callback_t)(size_t leat_count, const char* text, const char* code, void* userdata);
 
+/**
+ * 多路采集时带识别会话序号的回调函数类型定义。
+ * 每个采集设备一路识别会话，各自在独立线程中运行，回调可能被同时调用。
+ *
+ * @param stream 识别会话序号，即 -c / -ad 给出的第几个设备（从 0 开始）。
+ * @param leat_count 识别到的文本剩余数量, 0表示最后一个
+ * @param text 识别到的文本代码。
+ * @param code 处理后的文本代码。
+ * @param userdata 用户自定义数据指针。
+ */
+typedef int (*whisper_stream_callback_t)(int stream, size_t leat_count, const char* text, const char* code, void* userdata);
+
 /**
  * 获取解析参数
  * @param w 指向 whisper_fuzzy_t 结构体的指针。
@@ -33,6 +45,7 @@ whisper_params_t* whisper_fuzzy_get_params(whisper_fuzzy_t* w);
 
 /**
  * 初始化 Whisper 组件。
+ * 模型在后台线程中加载并预热，与读取配置、打开采集设备并行；whisper_fuzzy() 开始识别之前等待其完成。
  *
  * @param argc 参数个数
  * @param argv 参数列表
@@ -49,23 +62,64 @@ void whisper_fuzzy_exit(whisper_fuzzy_t* w);
 
 /**
  * 处理 Whisper 任务。
+ * 每次调用是一个独立的任务，有自己的参数副本、回调和推理状态，可在多个线程中同时调用，
+ * 共享 whisper_fuzzy_init() 加载的同一份模型。
  *
  * @param w 指向 whisper_fuzzy_t 结构体的指针。
- * @param callback 处理完成后的回调函数。
+ * @param callback 处理完成后的回调函数，指定多个采集设备时可能被同时调用。
  * @param userdata 传递给回调函数的用户数据。
  * @return 成功返回 0，失败返回 -1。
  */
 int whisper_fuzzy(whisper_fuzzy_t* w, whisper_callback_t callback, void* userdata);
 
+/**
+ * 处理 Whisper 任务，每个采集设备一路识别会话，回调中带有会话序号。
+ * 与 whisper_fuzzy() 一样可在多个线程中同时调用。
+ *
+ * @param w 指向 whisper_fuzzy_t 结构体的指针。
+ * @param callback 处理完成后的回调函数，多个会话可能在各自线程中同时调用。
+ * @param userdata 传递给回调函数的用户数据。
+ * @return 成功返回 0，失败返回 -1。
+ */
+int whisper_fuzzy_streams(whisper_fuzzy_t* w, whisper_stream_callback_t callback, void* userdata);
+
 /**
  * 进行模糊匹配流程。
  *
+ * 回调由调用者给出：whisper_fuzzy_init() 返回的对象被多个任务共享，不保存任何任务的回调。
+ *
  * @param w 指向 whisper_fuzzy_t 结构体的指针。
+ * @param callback 接收匹配结果的回调。
+ * @param userdata 传递给回调函数的用户数据。
  * @param leat_count 剩余匹配数量。
  * @param text 需要匹配的文本字符串。
  * @return 成功返回匹配的评分值，失败返回 -1。
  */
-int whisper_fuzzy_match(whisper_fuzzy_t* w, size_t leat_count, const char* text);
+int whisper_fuzzy_match(whisper_fuzzy_t* w, whisper_callback_t callback, void* userdata,
+                        size_t leat_count, const char* text);
+
+/**
+ * 对指定识别会话的文本进行模糊匹配流程，结果交给调用者给出的回调，可在多个线程中同时调用。
+ *
+ * @param w 指向 whisper_fuzzy_t 结构体的指针。
+ * @param callback 接收匹配结果的带会话序号的回调。
+ * @param userdata 传递给回调函数的用户数据。
+ * @param stream 识别会话序号。
+ * @param leat_count 剩余匹配数量。
+ * @param text 需要匹配的文本字符串。
+ * @return 成功返回匹配的评分值，失败返回 -1。
+ */
+int whisper_fuzzy_match_stream(whisper_fuzzy_t* w, whisper_stream_callback_t callback, void* userdata,
+                               int stream, size_t leat_count, const char* text);
+
+/**
+ * 把识别到的文本转换为 config.json 中的命令代码，只读，可在多个线程中同时调用。
+ *
+ * @param w 指向 whisper_fuzzy_t 结构体的指针。
+ * @param text 识别到的文本，忽略首尾空白和大小写。
+ * @return 命令代码，没有匹配时返回 "0x00"。
+ */
+const char* whisper_fuzzy_code(whisper_fuzzy_t* w, const char* text);
 
 #ifdef __cplusplus
 }
@@ -5,18 +5,157 @@
 
 #include "whisper_stream.h"
 
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <cmath>
+#include <csignal>
 #include <cstdio>
 #include <string>
 #include <thread>
 #include <vector>
 #include <fstream>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <sstream>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
-#include "common-sdl.h"
 #include "common.h"
 #include "whisper.h"
 
+#include "audio_archive.h"
+#include "audio_source.h"
+#include "audio_window.h"
+#include "command_grammar.h"
 #include "debug.h"
+#include "denoise.h"
+#include "energy_gate.h"
+#include "frame_vad.h"
+#include "onset_tap.h"
+#include "overload.h"
+#include "pcm_convert.h"
+#include "rt_sched.h"
+#include "stage_queue.h"
+#include "vad_kernels.h"
+#include "wav_recorder.h"
+#include "whisper_bench.h"
+#include "whisper_engine.h"
+
+static std::atomic<bool> g_interrupted(false);  ///< 是否收到 Ctrl + C 或 SIGTERM
+static int g_signal_fd[2] = { -1, -1 };         ///< Ctrl + C 时写入的管道，所有任务共用，进程结束前不关闭
+
+/**
+ * 向管道写入一个字节，唤醒阻塞在 whisper_stream_wait() 中的线程，可在信号处理函数中调用。
+ *
+ * @param fd 管道写端，小于 0 时忽略。
+ */
+static void whisper_stream_wake(int fd)
+{
+    if (fd >= 0) {
+        const char c = 0;
+        const ssize_t ret = write(fd, &c, 1);
+        (void) ret;
+    }
+}
+
+/**
+ * 创建非阻塞管道。
+ *
+ * @param fd 输出的读端和写端，失败时都为 -1。
+ * @return 成功返回 true，失败返回 false。
+ */
+static bool whisper_stream_pipe(int fd[2])
+{
+    if (pipe(fd) != 0) {
+        fd[0] = fd[1] = -1;
+        return false;
+    }
+    fcntl(fd[0], F_SETFL, O_NONBLOCK);
+    fcntl(fd[1], F_SETFL, O_NONBLOCK);
+    return true;
+}
+
+/**
+ * 任务的主线程等待 Ctrl + C 或本任务的会话结束，不轮询。管道创建失败时退化为睡眠。
+ *
+ * Ctrl + C 的管道不读空：退出标志不会复位，同时运行的每个任务都要被它唤醒。
+ *
+ * @param wake_fd 本任务的唤醒管道读端。
+ * @param timeout_ms 超时时间（毫秒），-1 表示一直等待。
+ */
+static void whisper_stream_wait(int wake_fd, int timeout_ms)
+{
+    if (wake_fd < 0 || g_signal_fd[0] < 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(timeout_ms < 0 ? 50 : timeout_ms));
+        return;
+    }
+
+    struct pollfd pfd[2] = { { wake_fd, POLLIN, 0 }, { g_signal_fd[0], POLLIN, 0 } };
+    if (poll(pfd, 2, timeout_ms) > 0 && (pfd[0].revents & POLLIN)) {
+        char buf[16];
+        while (read(wake_fd, buf, sizeof(buf)) > 0) {
+        }
+    }
+}
+
+/**
+ * SIGINT / SIGTERM 信号处理函数。SDL 音频源初始化时禁止 SDL 安装自己的处理函数，两种信号都走这里。
+ *
+ * @param signo 信号编号。
+ */
+static void whisper_stream_signal(int signo)
+{
+    (void) signo;
+    g_interrupted = true;
+    whisper_stream_wake(g_signal_fd[1]);
+}
+
+/**
+ * 安装 SIGINT 和 SIGTERM 处理函数，第一次调用时创建 Ctrl + C 管道，之后的任务共用。
+ * SIGTERM（例如 systemctl stop）与 Ctrl + C 一样正常退出，录音文件头回填、归档写完、设备关闭。
+ */
+static void whisper_stream_install_signals()
+{
+    static std::once_flag once;
+    std::call_once(once, []() {
+        whisper_stream_pipe(g_signal_fd);
+
+        struct sigaction sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sa_handler = whisper_stream_signal;
+        sigemptyset(&sa.sa_mask);
+        sa.sa_flags = SA_RESTART;
+        sigaction(SIGINT, &sa, nullptr);
+        sigaction(SIGTERM, &sa, nullptr);
+    });
+}
+
+/**
+ * 把设备列表拼接成逗号分隔的字符串，用于使用说明。
+ *
+ * @param items 设备列表。
+ * @param empty 列表为空时显示的默认值。
+ * @return 拼接后的字符串。
+ */
+template <typename T>
+static std::string whisper_stream_join(const std::vector<T> &items, const char *empty)
+{
+    if (items.empty()) {
+        return empty;
+    }
+
+    std::ostringstream oss;
+    for (size_t i = 0; i < items.size(); i++) {
+        oss << (i ? "," : "") << items[i];
+    }
+    return oss.str();
+}
 
 /**
  * 打印命令行参数的使用说明。
@@ -34,14 +173,29 @@ void whisper_print_usage(const whisper_params_t & params) {
     printf("  -u FNAME, --user FNAME    [%-7s] user config.json path\n",                          params.user.c_str());
     printf("  -t N,     --threads N     [%-7d] number of threads to use during computation\n",    params.n_threads);
     printf("            --step N        [%-7d] audio step size in milliseconds\n",                params.step_ms);
+    printf("  -sv,      --step-vad      [%-7s] in step mode, skip inference on steps without speech\n", params.step_vad ? "true" : "false");
     printf("            --length N      [%-7d] audio length in milliseconds\n",                   params.length_ms);
     printf("            --keep N        [%-7d] audio to keep from previous step in ms\n",         params.keep_ms);
-    printf("  -c ID,    --capture ID    [%-7d] capture device ID\n",                              params.capture_id);
+    printf("  -c ID,..  --capture ID,.. [%-7s] capture device IDs, one recognition stream per device\n", whisper_stream_join(params.capture_ids, "-1").c_str());
     printf("  -d N,     --debug N       [%-7d] debug flag, ERR(%d), INFO(%d), DBG(%d) \n",        get_dbg_enable(),
         log_dbg_flag_t::LOG_ERR_FLAG, log_dbg_flag_t::LOG_INFO_FLAG, log_dbg_flag_t::LOG_DBG_FLAG);
     printf("  -mt N,    --max-tokens N  [%-7d] maximum number of tokens per audio chunk\n",       params.max_tokens);
-    printf("  -ac N,    --audio-ctx N   [%-7d] audio context size (0 - all)\n",                   params.audio_ctx);
+    printf("  -ac N,    --audio-ctx N   [%-7d] audio context size (0 - all, -1 - from the length of each window)\n", params.audio_ctx);
+    printf("            --ac-margin N   [%-7d] audio context kept beyond the window with -ac -1, in ms\n", params.audio_ctx_margin_ms);
+    printf("            --ac-min N      [%-7d] lower bound of the audio context with -ac -1, in 20 ms frames\n", params.audio_ctx_min);
     printf("  -vth N,   --vad-thold N   [%-7.2f] voice activity detection threshold\n",           params.vad_thold);
+    printf("            --vad-start N   [%-7d] speech needed before an utterance starts, in ms\n", params.vad_start_ms);
+    printf("            --vad-end N     [%-7d] window for the end-of-speech decision, in ms\n",   params.vad_end_ms);
+    printf("            --vad NAME      [%-7s] per-frame speech model: energy or gmm\n",        params.vad_model.c_str());
+    printf("            --vad-mode N    [%-7d] gmm aggressiveness, 0 (most speech) to 3 (fewest false triggers)\n", params.vad_mode);
+    printf("            --hangover N    [%-7d] trailing silence that ends an utterance, in ms (0 - use -vth)\n", params.hangover_ms);
+    printf("            --vad-margin N  [%-7.1f] frame speech threshold above the tracked noise floor, in dB\n", params.vad_margin_db);
+    printf("            --vad-min N     [%-7.1f] lower bound of the frame speech threshold, in dBFS\n", params.vad_min_db);
+    printf("            --vad-max N     [%-7.1f] upper bound of the frame speech threshold, in dBFS\n", params.vad_max_db);
+    printf("  -dn,      --denoise       [%-7s] spectral noise suppression before inference\n", params.denoise ? "true" : "false");
+    printf("            --dn-floor N    [%-7.1f] maximum attenuation of --denoise per frequency bin, in dB\n", params.denoise_floor_db);
+    printf("  -gr,      --grammar       [%-7s] constrain decoding to the command texts of -u\n", params.grammar ? "true" : "false");
+    printf("            --gr-penalty N  [%-7.1f] logit penalty of tokens outside the --grammar\n", params.grammar_penalty);
     printf("  -fth N,   --freq-thold N  [%-7.2f] high-pass frequency cutoff\n",                   params.freq_thold);
     printf("  -tr,      --translate     [%-7s] translate from source language to english\n",      params.translate ? "true" : "false");
     printf("  -nf,      --no-fallback   [%-7s] do not use temperature fallback while decoding\n", params.no_fallback ? "true" : "false");
@@ -54,328 +208,1467 @@ void whisper_print_usage(const whisper_params_t & params) {
     printf("  -sa,      --save-audio    [%-7s] save the recorded audio to a file\n",              params.save_audio ? "true" : "false");
     printf("  -ng,      --no-gpu        [%-7s] disable GPU inference\n",                          params.use_gpu ? "false" : "true");
     printf("  -fa,      --flash-attn    [%-7s] flash attention during inference\n",               params.flash_attn ? "true" : "false");
+    printf("  -i FNAME, --input FNAME   [%-7s] read audio from file instead of microphone ('-' for stdin)\n", params.input.c_str());
+    printf("  -if FMT,  --input-fmt FMT [%-7s] input audio format: wav, s16 or f32 (raw mono)\n", params.input_format.c_str());
+    printf("  -np,      --no-pace       [%-7s] feed input file as fast as inference allows\n",   params.input_paced ? "false" : "true");
+    printf("  -ab NAME, --backend NAME  [%-7s] capture backend: sdl or alsa\n",                   params.audio_backend.c_str());
+    printf("  -ad DEV,  --alsa-dev DEV  [%-7s] ALSA capture device, repeat for one stream per device\n", whisper_stream_join(params.alsa_devices, "default").c_str());
+    printf("            --period-ms N   [%-7d] ALSA period size in milliseconds\n",              params.period_ms);
+    printf("            --buffer-ms N   [%-7d] ALSA buffer size in milliseconds\n",              params.buffer_ms);
+    printf("  -ar N,    --audio-rate N  [%-7d] capture/input sample rate (0 - device native or wav header)\n", params.audio_rate);
+    printf("  -pr N,    --preroll N     [%-7d] audio kept before speech onset in VAD mode, in ms\n", params.preroll_ms);
+    printf("  -po N,    --postroll N    [%-7d] audio kept after speech end in VAD mode, in ms\n", params.postroll_ms);
+    printf("            --idle N        [%-7d] silence before entering power save in VAD mode or with -sv, in ms (0 - off)\n", params.idle_ms);
+    printf("            --rt            [%-7s] SCHED_FIFO capture thread and locked memory\n",    params.realtime ? "true" : "false");
+    printf("            --rt-prio N     [%-7d] SCHED_FIFO priority of the capture thread with --rt\n", params.rt_prio);
+    printf("            --cpus LIST     [%-7s] pin inference threads to these CPUs, e.g. 2,3 or 1-3\n", params.infer_cpus.c_str());
+    printf("            --overload P    [%-7s] when inference falls behind: drop, skip, shrink or vad\n", params.overload.c_str());
+    printf("            --bench NAME    [%-7s] run a benchmark instead of streaming: resample, vad, vad-noise, audio-ctx, denoise, grammar\n", params.bench.c_str());
+    printf("            --archive DIR   [%-7s] archive speech-only audio segments to DIR\n",   params.archive_dir.c_str());
+    printf("            --archive-pad N [%-7d] archive padding around speech in milliseconds\n",  params.archive_pad_ms);
+    printf("            --archive-sec N [%-7d] archive segment length in seconds (0 - no limit)\n", params.archive_sec);
+    printf("            --archive-mb N  [%-7d] archive segment size in MB (0 - no limit)\n",     params.archive_mb);
     printf("\n");
 }
 
 /**
- * 运行 Whisper 语音流处理的主函数。
+ * 流处理配置，由命令行参数换算得到，所有识别会话共用且只读。
+ */
+struct stream_config_t {
+    int n_samples_step  = 0;        ///< step 模式每次处理的新样本数，<= 0 表示 VAD 模式
+    int n_samples_len   = 0;        ///< 每次送入推理的最大样本数
+    int n_samples_keep  = 0;        ///< step 模式换行时保留的样本数
+    int n_samples_vad   = 0;        ///< 语音结束判决窗口（2 * --vad-end）
+    int n_samples_poll  = 0;        ///< VAD 模式每次等待的新样本数
+    int n_samples_pre   = 0;        ///< VAD 模式语音起点之前保留的样本数
+    int n_samples_post  = 0;        ///< VAD 模式语音终点之后保留的样本数
+    int n_samples_frame = 0;        ///< 语音检测的帧长
+    frame_vad_params_t vad;         ///< VAD 模式的流式语音检测参数
+    bool use_vad        = false;    ///< 是否为 VAD 模式
+    bool step_vad       = false;    ///< step 模式是否跳过静音的 step
+    int n_samples_idle  = 0;        ///< 连续静音多少样本后进入省电状态，0 表示不启用
+    int n_new_line      = 1;        ///< step 模式每隔多少步换行
+    overload_policy_t overload = OVERLOAD_DROP; ///< 推理跟不上采集时的策略
+    std::vector<int> infer_cpus;    ///< 推理线程绑定的 CPU，空表示不绑定
+};
+
+#define STREAM_PIPELINE_DEPTH 2     ///< 流水线相邻两级之间的缓冲区个数：一个在下游处理，一个在上游准备
+
+/**
+ * 一个窗口或结果经过流水线各级的耗时（微秒），随缓冲区在队列中传递。
+ */
+struct stream_timing_t {
+    int64_t t_ready     = 0;        ///< 窗口组装完成、进入推理队列的时刻（steady_clock）
+    int64_t t_done      = 0;        ///< 推理完成、结果进入输出队列的时刻（steady_clock）
+    int64_t assemble    = 0;        ///< 组装：格式转换和降噪
+    int64_t infer_wait  = 0;        ///< 在推理队列中等待
+    int64_t infer       = 0;        ///< 推理
+    int64_t output_wait = 0;        ///< 在输出队列中等待
+    int64_t output      = 0;        ///< 匹配、打印和写文件
+};
+
+/**
+ * 组装好的一个推理窗口，由会话线程交给推理线程。
+ */
+struct stream_window_t {
+    std::vector<float> pcm;         ///< 送入推理的浮点样本，按分析窗口容量预分配
+    int n_samples       = 0;        ///< 样本数
+    uint64_t t0         = 0;        ///< VAD 模式下窗口起点的采样时钟
+    uint64_t t1         = 0;        ///< VAD 模式下窗口终点的采样时钟
+    float vad_thold     = 0.0f;     ///< 组装时 VAD 的判决门限（dBFS），用于输出
+    bool prompt_reset   = false;    ///< 推理前清空提示 token（--step-vad 语音重新开始）
+    bool break_before   = false;    ///< 输出前先换行（--step-vad 语音重新开始时上一行未结束）
+    bool new_line       = false;    ///< step 模式本窗口之后换行，本次结果作为之后的提示
+    stream_timing_t timing;         ///< 各级耗时
+};
+
+/**
+ * 一个转写片段。
+ */
+struct stream_segment_t {
+    std::string text;               ///< 文本
+    int64_t t0          = 0;        ///< 起点（10 ms）
+    int64_t t1          = 0;        ///< 终点（10 ms）
+    bool speaker_turn   = false;    ///< 之后是否换说话人（tinydiarize）
+};
+
+/**
+ * 一个窗口的推理结果，由推理线程交给输出线程。
+ */
+struct stream_result_t {
+    int iter            = 0;        ///< 推理序号
+    std::vector<stream_segment_t> segments; ///< 转写片段，只有前 n_segments 个有效，字符串在结果之间复用
+    int n_segments      = 0;        ///< 片段数
+    uint64_t t0         = 0;        ///< 同 stream_window_t
+    uint64_t t1         = 0;        ///< 同 stream_window_t
+    float vad_thold     = 0.0f;     ///< 同 stream_window_t
+    bool break_before   = false;    ///< 同 stream_window_t
+    bool new_line       = false;    ///< 同 stream_window_t
+    stream_timing_t timing;         ///< 各级耗时
+};
+
+/**
+ * 流水线耗时统计，由输出线程在每个结果输出后累加。
+ */
+struct stream_pipeline_stats_t {
+    uint64_t n_windows  = 0;        ///< 走完流水线的窗口数
+    stream_timing_t sum;            ///< 各级耗时之和，t_ready 和 t_done 不用
+    int64_t t_first     = 0;        ///< 第一个窗口进入推理队列的时刻
+    int64_t t_last      = 0;        ///< 最后一个结果输出完的时刻
+};
+
+/**
+ * 一路采集设备的识别会话。
  *
- * @param whisper_fuzzy_ctx 指向 whisper_fuzzy_t 结构体的指针，包含语音处理的上下文信息。
- * @return 成功返回 0，失败返回 -1。
+ * 每个会话拥有自己的音频源、旁路、分析窗口、VAD 状态和 whisper_state；
+ * 所有会话共享同一个 whisper_context，模型权重只加载一次。
  *
- * 该函数负责管理 Whisper 的音频流处理，调用相关的语音识别和匹配功能，
- * 以便实时处理输入音频数据并执行模糊匹配任务。
+ * 每个会话是三级流水线，各有一个线程：会话线程等待音频并组装窗口，推理线程运行 whisper_full，
+ * 输出线程匹配、打印和写文件。相邻两级之间是容量为 STREAM_PIPELINE_DEPTH 的有界队列和同样多的预分配缓冲区，
+ * 推理线程处理第 N 个窗口时会话线程已在准备第 N + 1 个，组装和输出都不再占用推理的时间。
+ */
+struct stream_session_t {
+    int index = 0;                              ///< 会话序号，即回调中的 stream
+    std::string tag;                            ///< 多路时的输出前缀，单路为空
+    const whisper_engine_task_t *task = nullptr; ///< 所属任务，匹配结果交给它的回调
+    int wake_fd = -1;                           ///< 会话结束时唤醒任务主线程的管道写端
+    const whisper_params_t *params = nullptr;   ///< 命令行参数
+    const stream_config_t *config = nullptr;    ///< 流处理配置
+    whisper_context *ctx = nullptr;             ///< 共享的模型
+    whisper_state *state = nullptr;             ///< 本会话的推理状态，从引擎借用，任务结束时归还
+
+    // 录音器和存档必须比音频源活得久：音频源先析构，停止采集后它们才写完并关闭文件
+    wav_recorder_t recorder;                    ///< --save-audio 录音
+    audio_archive_t archive;                    ///< 语音存档
+    onset_tap_t onset;                          ///< 省电状态下的语音起点检测
+    std::unique_ptr<audio_source_t> audio;      ///< 音频源
+
+    audio_window_t window;                      ///< 分析窗口
+    denoiser_t denoise;                         ///< --denoise 频域降噪，在会话线程中运行
+    frame_vad_t vad;                            ///< VAD 模式的流式语音检测
+    std::vector<frame_vad_event_t> vad_events;  ///< 每块新样本中的语音事件
+    std::vector<whisper_token> prompt_tokens;   ///< step 模式的提示 token，只由推理线程访问
+    std::ofstream fout;                         ///< -f 文本输出，只由输出线程访问
+
+    stream_window_t windows[STREAM_PIPELINE_DEPTH];         ///< 推理窗口缓冲区
+    stream_result_t results[STREAM_PIPELINE_DEPTH];         ///< 推理结果缓冲区
+    stage_queue_t<stream_window_t *> q_window_free;         ///< 空闲的窗口缓冲区
+    stage_queue_t<stream_window_t *> q_window;              ///< 待推理的窗口
+    stage_queue_t<stream_result_t *> q_result_free;         ///< 空闲的结果缓冲区
+    stage_queue_t<stream_result_t *> q_result;              ///< 待输出的结果
+    stream_pipeline_stats_t pipeline;           ///< 流水线耗时统计，只由输出线程更新
+
+    std::thread worker;                         ///< 会话线程，组装窗口
+    std::thread infer_worker;                   ///< 推理线程
+    std::thread output_worker;                  ///< 输出线程
+    std::atomic<bool> done{false};              ///< 会话线程是否已结束
+    int ret = 0;                                ///< 会话线程的返回值
+    bool overloaded = false;                    ///< 是否处于过载状态
+    overload_stats_t overload;                  ///< 过载统计
+    int n_iter = 0;                             ///< 推理次数，只由推理线程更新
+    int64_t t_infer_us = 0;                     ///< 累计推理耗时（微秒），只由推理线程更新
+    int64_t n_ctx_sum = 0;                      ///< 累计音频上下文大小（编码器帧），用于统计平均值，只由推理线程更新
+    uint64_t n_steps = 0;                       ///< step 模式处理的 step 数
+    uint64_t n_idle_steps = 0;                  ///< --step-vad 跳过的静音 step 数
+    std::atomic<bool> idle{false};              ///< 是否处于省电状态
+    uint64_t last_active = 0;                   ///< 最近一次有语音的采样时钟
+    uint64_t n_idle_dropped = 0;                ///< 省电状态下未经 VAD 直接丢弃的样本数
+    int64_t t_idle_us = 0;                      ///< 省电状态下阻塞等待的累计时长（微秒）
+    bool vad_thold_seen = false;                ///< 是否已记录过 VAD 判决门限
+    float vad_thold_logged = 0.0f;              ///< 最近一次输出的 VAD 判决门限（dBFS）
+    uint64_t vad_thold_at = 0;                  ///< 最近一次输出门限时的采样时钟
+    float vad_thold_min = 0.0f;                 ///< 会话中 VAD 判决门限的最小值（dBFS）
+    float vad_thold_max = 0.0f;                 ///< 会话中 VAD 判决门限的最大值（dBFS）
+};
+
+/**
+ * 多路识别时给输出文件名加上会话序号，插在扩展名之前，例如 out.txt -> out-1.txt。
+ *
+ * @param path 文件名。
+ * @param index 会话序号。
+ * @return 加上序号后的文件名。
  */
-int whisper_stream_main(whisper_fuzzy_t *whisper_fuzzy_ctx) {
-    if (!whisper_fuzzy_ctx) {
-        LOG_ERR("whisper_fuzzy_ctx null");
-        return -1;
+static std::string whisper_stream_suffix(const std::string &path, int index)
+{
+    const size_t slash = path.find_last_of('/');
+    const size_t dot   = path.find_last_of('.');
+    const std::string suffix = "-" + std::to_string(index);
+
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+        return path + suffix;
     }
-    whisper_params_t *params_tmp = whisper_fuzzy_get_params(whisper_fuzzy_ctx);
-    if (!params_tmp) {
-        LOG_ERR("fail to get params\n");
-        return -1;
+    return path.substr(0, dot) + suffix + path.substr(dot);
+}
+
+/**
+ * 创建会话的音频源、旁路和分析窗口。推理状态由调用者在模型就绪后设置，之后才开始采集。
+ *
+ * @param s 会话，调用前已设置 index、tag、task、params 和 config。
+ * @param sparams 音频源参数，已填入本会话的设备。
+ * @param n_sessions 会话总数，多于一个时输出文件名带上会话序号。
+ * @return 成功返回 true，失败返回 false。
+ */
+static bool whisper_session_init(stream_session_t &s, const audio_source_params_t &sparams, int n_sessions)
+{
+    const whisper_params_t &params = *s.params;
+    const stream_config_t &config  = *s.config;
+
+    s.audio.reset(audio_source_create(sparams));
+    if (!s.audio) {
+        LOG_ERR("%s: audio source %d init failed!\n", __func__, s.index);
+        return false;
     }
-    whisper_params_t &params = *params_tmp;
 
-    params.keep_ms   = std::min(params.keep_ms,   params.step_ms);
-    params.length_ms = std::max(params.length_ms, params.step_ms);
+    // save wav file
+    if (params.save_audio) {
+        // Get current date/time for filename
+        time_t now = time(0);
+        char buffer[80];
+        strftime(buffer, sizeof(buffer), "%Y%m%d%H%M%S", localtime(&now));
+        std::string filename = std::string(buffer) + ".wav";
+        if (n_sessions > 1) {
+            filename = whisper_stream_suffix(filename, s.index);
+        }
 
-    const int n_samples_step = (1e-3*params.step_ms  )*WHISPER_SAMPLE_RATE;
-    const int n_samples_len  = (1e-3*params.length_ms)*WHISPER_SAMPLE_RATE;
-    const int n_samples_keep = (1e-3*params.keep_ms  )*WHISPER_SAMPLE_RATE;
-    const int n_samples_30s  = (1e-3*30000.0         )*WHISPER_SAMPLE_RATE;
+        // 队列容纳 10 秒音频，磁盘停顿更久时整块丢弃而不是阻塞采集
+        if (!s.recorder.open(filename, WHISPER_SAMPLE_RATE, 10*WHISPER_SAMPLE_RATE)) {
+            return false;
+        }
+        s.audio->add_tap(&s.recorder);
+    }
 
-    const bool use_vad = n_samples_step <= 0; // sliding window mode uses VAD
+    // speech-only archive，多路时每个设备一个子目录
+    if (!params.archive_dir.empty()) {
+        audio_archive_params_t aparams;
+        aparams.dir           = params.archive_dir;
+        aparams.sample_rate   = WHISPER_SAMPLE_RATE;
+        aparams.pad_ms        = params.archive_pad_ms;
+        aparams.segment_sec   = params.archive_sec;
+        aparams.segment_bytes = (uint64_t) params.archive_mb << 20;
+        aparams.freq_thold    = params.freq_thold;
+
+        if (n_sessions > 1) {
+            if (mkdir(params.archive_dir.c_str(), 0755) != 0 && errno != EEXIST) {
+                LOG_ERR("%s: fail to create archive dir %s: %s\n", __func__, params.archive_dir.c_str(), strerror(errno));
+                return false;
+            }
+            aparams.dir += "/" + std::to_string(s.index);
+        }
 
-    const int n_new_line = !use_vad ? std::max(1, params.length_ms / params.step_ms - 1) : 1; // number of steps to print new line
+        if (!s.archive.open(aparams)) {
+            return false;
+        }
+        s.audio->add_tap(&s.archive);
+    }
 
-    params.no_timestamps  = !use_vad;
-    params.no_context    |= use_vad;
-    params.max_tokens     = 0;
+    // 省电状态下由采集线程检测语音起点，提前唤醒阻塞等待的会话线程
+    if (config.n_samples_idle > 0) {
+        if (!s.onset.init(&s.audio->ring, WHISPER_SAMPLE_RATE, config.vad.frame_ms, params.freq_thold,
+                params.vad_margin_db, params.vad_min_db, params.vad_max_db)) {
+            return false;
+        }
+        s.audio->add_tap(&s.onset);
+    }
 
-    // init audio
+    // 分析窗口只分配一次：step 模式保存 keep + length，VAD 模式保存最近的 pre-roll + length（至少 VAD 窗口）
+    if (!s.window.init(!config.use_vad ? config.n_samples_keep + config.n_samples_len
+                                       : std::max(config.n_samples_pre + config.n_samples_len, config.n_samples_vad))) {
+        LOG_ERR("%s: failed to init audio window\n", __func__);
+        return false;
+    }
 
-    audio_async audio(params.length_ms);
-    if (!audio.init(params.capture_id, WHISPER_SAMPLE_RATE)) {
-        LOG_ERR("%s: audio.init() failed!\n", __func__);
-        return 1;
+    // 窗口保存 16 位整数样本，组装时一次性转换到预先分配的浮点缓冲，交给推理线程
+    s.q_window_free.init(STREAM_PIPELINE_DEPTH);
+    s.q_window.init(STREAM_PIPELINE_DEPTH);
+    s.q_result_free.init(STREAM_PIPELINE_DEPTH);
+    s.q_result.init(STREAM_PIPELINE_DEPTH);
+    for (int i = 0; i < STREAM_PIPELINE_DEPTH; i++) {
+        s.windows[i].pcm.assign(s.window.capacity(), 0.0f);
+        s.q_window_free.push(&s.windows[i]);
+        s.q_result_free.push(&s.results[i]);
     }
 
-    audio.resume();
+    if (params.denoise) {
+        denoise_params_t dparams;
+        dparams.floor_db = params.denoise_floor_db;
+        if (!s.denoise.init(dparams, s.window.capacity())) {
+            LOG_ERR("%s: failed to init denoiser\n", __func__);
+            return false;
+        }
+    }
+    if ((config.use_vad || config.step_vad) && !s.vad.init(config.vad)) {
+        return false;
+    }
+    s.vad_events.reserve(16);
 
-    // whisper init
-    if (params.language != "auto" && whisper_lang_id(params.language.c_str()) == -1){
-        LOG_ERR("error: unknown language '%s'\n", params.language.c_str());
-        whisper_print_usage(params);
-        exit(0);
+    if (params.fname_out.length() > 0) {
+        const std::string fname = n_sessions > 1 ? whisper_stream_suffix(params.fname_out, s.index) : params.fname_out;
+        s.fout.open(fname);
+        if (!s.fout.is_open()) {
+            LOG_ERR("%s: failed to open output file '%s'!\n", __func__, fname.c_str());
+            return false;
+        }
     }
 
-    struct whisper_context_params cparams = whisper_context_default_params();
+    if (n_sessions > 1) {
+        LOG_INFO("stream %d: %s", s.index, s.audio->name());
+    }
 
-    cparams.use_gpu    = params.use_gpu;
-    cparams.flash_attn = params.flash_attn;
+    return true;
+}
 
-    struct whisper_context * ctx = whisper_init_from_file_with_params(params.model.c_str(), cparams);
+/**
+ * 根据积压更新会话的过载状态，进入和退出过载时各输出一条日志。
+ *
+ * @param s 会话。
+ * @param n_avail 待处理的样本数。
+ * @param n_high 积压超过该值时进入过载。
+ * @param n_low 积压不超过该值时退出过载。
+ * @return 当前是否过载。
+ */
+static bool whisper_session_overloaded(stream_session_t &s, size_t n_avail, size_t n_high, size_t n_low)
+{
+    if (!s.overloaded && n_avail > n_high) {
+        s.overloaded = true;
+        s.overload.n_events++;
+        LOG_ERR("%s%s: WARNING: cannot process audio fast enough, %.1f sec queued, overload policy: %s\n", s.tag.c_str(), __func__,
+            (double) n_avail / WHISPER_SAMPLE_RATE, overload_policy_name(s.config->overload));
+    } else if (s.overloaded && n_avail <= n_low) {
+        s.overloaded = false;
+        LOG_INFO("%scaught up, %.1f sec queued", s.tag.c_str(), (double) n_avail / WHISPER_SAMPLE_RATE);
+    }
+    return s.overloaded;
+}
 
-    std::vector<float> pcmf32    (n_samples_30s, 0.0f);
-    std::vector<float> pcmf32_old;
-    std::vector<float> pcmf32_new(n_samples_30s, 0.0f);
+/**
+ * 记录 VAD 当前的判决门限：统计会话内的范围，门限相对上次输出变化 3 dB 以上时输出一次，
+ * 两次输出至少间隔 5 秒（采样时钟），噪声底缓慢变化时不会刷屏。
+ *
+ * @param s 会话。
+ * @param clock 当前采样时钟。
+ */
+static void whisper_session_vad_threshold(stream_session_t &s, uint64_t clock)
+{
+    const vad_model_t &model = s.vad.model();
+    const float thold = model.threshold();
+
+    if (!s.vad_thold_seen) {
+        s.vad_thold_seen = true;
+        s.vad_thold_min = thold;
+        s.vad_thold_max = thold;
+    } else {
+        s.vad_thold_min = std::min(s.vad_thold_min, thold);
+        s.vad_thold_max = std::max(s.vad_thold_max, thold);
+        if (fabsf(thold - s.vad_thold_logged) < 3.0f || clock - s.vad_thold_at < 5 * (uint64_t) WHISPER_SAMPLE_RATE) {
+            return;
+        }
+    }
 
-    std::vector<whisper_token> prompt_tokens;
+    s.vad_thold_logged = thold;
+    s.vad_thold_at = clock;
+    LOG_INFO("%svad threshold %.1f dBFS (noise floor %.1f dBFS) at %.1f sec", s.tag.c_str(), thold, model.noise(),
+        (double) clock / WHISPER_SAMPLE_RATE);
+}
 
-    // print some info about the processing
-    {
-        LOG_ERR("");
-        if (!whisper_is_multilingual(ctx)) {
-            if (params.language != "en" || params.translate) {
-                params.language = "en";
-                params.translate = false;
-                LOG_ERR("%s: WARNING: model is not multilingual, ignoring language and translation options\n", __func__);
-            }
+/**
+ * 根据最近一次 VAD 的结果更新省电状态：有语音时退出，连续静音达到 --idle 时进入。
+ *
+ * @param s 会话。
+ * @param clock 当前采样时钟。
+ */
+static void whisper_session_idle_update(stream_session_t &s, uint64_t clock)
+{
+    if (s.vad.in_speech() || !s.vad_events.empty()) {
+        s.last_active = clock;
+        if (s.idle) {
+            s.idle = false;
+            s.onset.disarm();
+            LOG_INFO("%sspeech at %.2f sec, leaving power save", s.tag.c_str(), (double) clock / WHISPER_SAMPLE_RATE);
         }
-        LOG_ERR("%s: processing %d samples (step = %.1f sec / len = %.1f sec / keep = %.1f sec), %d threads, lang = %s, task = %s, timestamps = %d ...\n",
-                __func__,
-                n_samples_step,
-                float(n_samples_step)/WHISPER_SAMPLE_RATE,
-                float(n_samples_len )/WHISPER_SAMPLE_RATE,
-                float(n_samples_keep)/WHISPER_SAMPLE_RATE,
-                params.n_threads,
-                params.language.c_str(),
-                params.translate ? "translate" : "transcribe",
-                params.no_timestamps ? 0 : 1);
-
-        if (!use_vad) {
-            LOG_ERR("%s: n_new_line = %d, no_context = %d\n", __func__, n_new_line, params.no_context);
-        } else {
-            LOG_ERR("%s: using VAD, will transcribe on speech activity\n", __func__);
+    } else if (!s.idle && clock >= s.last_active + s.config->n_samples_idle) {
+        // 采集端领先时还没读到的样本里可能已有语音，先处理完；arm() 之后再查一次，
+        // 避免语音帧恰好在两者之间到达而漏掉唤醒
+        if (s.onset.last_speech() > clock) {
+            return;
         }
+        s.onset.arm();
+        if (s.onset.last_speech() > clock) {
+            s.onset.disarm();
+            return;
+        }
+        s.idle = true;
+        LOG_INFO("%sentering power save at %.2f sec", s.tag.c_str(), (double) clock / WHISPER_SAMPLE_RATE);
+    }
+}
+
+/**
+ * 省电状态下等待新样本：阻塞到积压达到半个 ring，或采集线程检测到语音起点为止，其间不做任何处理。
+ *
+ * 进入省电状态之后 ring 中的样本都经过起点检测，起点之前的都是静音。醒来后更早的静音直接丢弃，
+ * 窗口与之不再连续，一并清空：检测到起点时从起点前 pre-roll 处保留，并立即退出省电状态；
+ * 否则只留下最近的 pre-roll 和一帧交给 VAD。
+ *
+ * @param s 会话。
+ */
+static void whisper_session_idle_wait(stream_session_t &s)
+{
+    audio_ring_t &ring = s.audio->ring;
+    const size_t n_pre = s.config->n_samples_pre;
+
+    // 超时只是为了定期检查退出标志
+    const auto t_start = std::chrono::steady_clock::now();
+    const size_t n_avail = ring.wait(ring.capacity()/2, 1000);
+    s.t_idle_us += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - t_start).count();
+
+    // 旁路先于写入 ring 检测，先取 n_avail 再看起点：没有起点时这些样本都已判过是静音
+    const bool onset = s.onset.triggered();
+    const uint64_t head = ring.clock() + n_avail;
+
+    size_t n_keep = n_pre + s.config->n_samples_frame;
+    if (onset) {
+        const uint64_t at = s.onset.onset_at();
+        const uint64_t from = at - std::min<uint64_t>(at, n_pre);
+        n_keep = head > from ? (size_t) (head - from) : 0;
+    }
+    n_keep = std::min(n_keep, n_avail);
 
-        LOG_ERR("");
+    if (n_avail > n_keep) {
+        ring.consume(n_avail - n_keep);
+        s.n_idle_dropped += n_avail - n_keep;
+        s.window.clear();
     }
 
-    int n_iter = 0;
+    if (onset) {
+        s.onset.disarm();
+        s.idle = false;
+        s.last_active = ring.clock();
+        LOG_INFO("%sspeech onset at %.2f sec, leaving power save", s.tag.c_str(), (double) s.onset.onset_at() / WHISPER_SAMPLE_RATE);
+    }
+}
 
-    bool is_running = true;
+/**
+ * 获取单调时钟的当前时刻，用于流水线各级计时。
+ *
+ * @return 微秒。
+ */
+static int64_t whisper_stream_now_us()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
 
-    std::ofstream fout;
-    if (params.fname_out.length() > 0) {
-        fout.open(params.fname_out);
-        if (!fout.is_open()) {
-            LOG_ERR("%s: failed to open output file '%s'!\n", __func__, params.fname_out.c_str());
-            return 1;
+/**
+ * 推理线程：逐个取出组装好的窗口运行 whisper_full，把片段拷贝到结果缓冲区交给输出线程。
+ * 窗口队列关闭并取空后关闭结果队列并返回。
+ *
+ * 提示 token 只在本线程中维护：step 模式换行的窗口推理完后用它的结果作为之后的提示，
+ * 所以会话线程可以在上一个窗口出结果之前就组装下一个。
+ *
+ * @param s 会话。
+ * @param running 所有会话共用的运行标志，置为 false 后不再推理排队中的窗口；推理失败时本函数把它置为 false。
+ */
+static void whisper_session_infer(stream_session_t &s, std::atomic<bool> &running)
+{
+    const whisper_params_t &params = *s.params;
+    const stream_config_t &config  = *s.config;
+
+    // ggml 的计算线程在本线程中创建并继承 CPU 绑定；采集线程和会话线程不受影响
+    if (!config.infer_cpus.empty()) {
+        rt_sched_pin(config.infer_cpus, "inference");
+    } else if (params.realtime) {
+        rt_sched_log("inference");
+    }
+
+    stream_window_t *w = nullptr;
+    while (s.q_window.pop(w)) {
+        stream_result_t *r = nullptr;
+        if (!running || !s.q_result_free.pop(r)) {
+            s.q_window_free.push(w);
+            continue;
+        }
+
+        const int64_t t_start = whisper_stream_now_us();
+
+        if (w->prompt_reset) {
+            s.prompt_tokens.clear();
         }
+
+        whisper_full_params wparams = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+
+        wparams.print_progress   = false;
+        wparams.print_special    = params.print_special;
+        wparams.print_realtime   = false;
+        wparams.print_timestamps = !params.no_timestamps;
+        wparams.translate        = params.translate;
+        wparams.single_segment   = !config.use_vad;
+        wparams.max_tokens       = params.max_tokens;
+        wparams.language         = params.language.c_str();
+        wparams.n_threads        = params.n_threads;
+
+        wparams.audio_ctx        = whisper_stream_audio_ctx(params, w->n_samples, whisper_model_n_audio_ctx(s.ctx));
+
+        wparams.tdrz_enable      = params.tinydiarize; // [TDRZ]
+
+        // disable temperature fallback
+        //wparams.temperature_inc  = -1.0f;
+        wparams.temperature_inc  = params.no_fallback ? 0.0f : wparams.temperature_inc;
+
+        wparams.prompt_tokens    = params.no_context ? nullptr : s.prompt_tokens.data();
+        wparams.prompt_n_tokens  = params.no_context ? 0       : s.prompt_tokens.size();
+
+        // 只允许输出 config.json 中的命令文本，省掉无关文本的解码和由此引起的温度回退
+        if (params.grammar && s.task->grammar) {
+            command_grammar_apply(*s.task->grammar, wparams, params.grammar_penalty);
+        }
+
+        if (whisper_full_with_state(s.ctx, s.state, wparams, w->pcm.data(), w->n_samples) != 0) {
+            LOG_ERR("%s: failed to process audio\n", params.program_name);
+            s.ret = 6;
+            running = false;
+            // 会话线程可能阻塞在窗口队列的任一端
+            s.q_window.close();
+            s.q_window_free.close();
+            s.q_result_free.push(r);
+            break;
+        }
+
+        const int64_t t_end = whisper_stream_now_us();
+
+        s.t_infer_us += t_end - t_start;
+        s.n_ctx_sum  += wparams.audio_ctx > 0 ? wparams.audio_ctx : whisper_model_n_audio_ctx(s.ctx);
+
+        const int n_segments = whisper_full_n_segments_from_state(s.state);
+        if ((int) r->segments.size() < n_segments) {
+            r->segments.resize(n_segments);
+        }
+        for (int i = 0; i < n_segments; ++i) {
+            stream_segment_t &seg = r->segments[i];
+            seg.text         = whisper_full_get_segment_text_from_state(s.state, i);
+            seg.t0           = whisper_full_get_segment_t0_from_state(s.state, i);
+            seg.t1           = whisper_full_get_segment_t1_from_state(s.state, i);
+            seg.speaker_turn = whisper_full_get_segment_speaker_turn_next_from_state(s.state, i);
+        }
+
+        // Add tokens of the last full length segment as the prompt
+        if (w->new_line && !params.no_context) {
+            s.prompt_tokens.clear();
+
+            for (int i = 0; i < n_segments; ++i) {
+                const int token_count = whisper_full_n_tokens_from_state(s.state, i);
+                for (int j = 0; j < token_count; ++j) {
+                    s.prompt_tokens.push_back(whisper_full_get_token_id_from_state(s.state, i, j));
+                }
+            }
+        }
+
+        r->iter         = s.n_iter++;
+        r->n_segments   = n_segments;
+        r->t0           = w->t0;
+        r->t1           = w->t1;
+        r->vad_thold    = w->vad_thold;
+        r->break_before = w->break_before;
+        r->new_line     = w->new_line;
+        r->timing       = w->timing;
+        r->timing.infer_wait = t_start - w->timing.t_ready;
+        r->timing.infer      = t_end - t_start;
+
+        s.q_window_free.push(w);
+
+        r->timing.t_done = whisper_stream_now_us();
+        s.q_result.push(r);
     }
 
-    wav_writer wavWriter;
-    // save wav file
-    if (params.save_audio) {
-        // Get current date/time for filename
-        time_t now = time(0);
-        char buffer[80];
-        strftime(buffer, sizeof(buffer), "%Y%m%d%H%M%S", localtime(&now));
-        std::string filename = std::string(buffer) + ".wav";
+    s.q_result.close();
+}
 
-        wavWriter.open(filename, WHISPER_SAMPLE_RATE, 16, 1);
+/**
+ * 输出线程：逐个取出推理结果，匹配命令、打印并写入 -f 文件，累计流水线耗时。
+ * 结果队列关闭并取空后返回。
+ *
+ * @param s 会话。
+ */
+static void whisper_session_output(stream_session_t &s)
+{
+    const whisper_params_t &params = *s.params;
+    const bool use_vad = s.config->use_vad;
+    audio_source_t *audio = s.audio.get();
+
+    stream_result_t *r = nullptr;
+    while (s.q_result.pop(r)) {
+        const int64_t t_start = whisper_stream_now_us();
+
+        if (r->break_before) {
+            LOG_DBG("");
+        }
+
+        // print result;
+        {
+            if (!use_vad) {
+                LOG_DBG("\33[2K\r");
+
+                // print long empty line to clear the previous line
+                LOG_DBG("%s", std::string(100, ' ').c_str());
+
+                LOG_DBG("\33[2K\r");
+            } else {
+                const int64_t t0 = r->t0*1000/WHISPER_SAMPLE_RATE;
+                const int64_t t1 = r->t1*1000/WHISPER_SAMPLE_RATE;
+
+                LOG_DBG("");
+                LOG_DBG("%s### Transcription %d START | t0 = %d ms | t1 = %d ms | vad threshold = %.1f dBFS\n", s.tag.c_str(),
+                    r->iter, (int) t0, (int) t1, r->vad_thold);
+
+                // 由最近一块的采集时间戳推算 t1 处样本的采集时刻，得到从采集到出结果的延迟
+                uint64_t ts_sample = 0;
+                int64_t  ts_ns     = 0;
+                if (audio->realtime() && audio->timestamp(ts_sample, ts_ns)) {
+                    const int64_t t1_ns  = ts_ns - ((int64_t) ts_sample - (int64_t) r->t1)*1000000000/WHISPER_SAMPLE_RATE;
+                    const int64_t now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now().time_since_epoch()).count();
+                    LOG_DBG("%s### latency: %.1f ms from capture of t1 to result\n", s.tag.c_str(), (now_ns - t1_ns)/1e6);
+                }
+                LOG_DBG("");
+            }
+
+            const int n_segments = r->n_segments;
+            for (int i = 0; i < n_segments; ++i) {
+                const stream_segment_t &seg = r->segments[i];
+                const char * text = seg.text.c_str();
+
+                whisper_engine_match(*s.task, s.index, n_segments - i - 1, text);
+
+                if (params.no_timestamps) {
+                    LOG_DBG("%s%s", s.tag.c_str(), text);
+                    fflush(stdout);
+
+                    if (params.fname_out.length() > 0) {
+                        s.fout << text;
+                    }
+                } else {
+                    std::string output = "[" + to_timestamp(seg.t0, false) + " --> " + to_timestamp(seg.t1, false) + "]  " + text;
+
+                    if (seg.speaker_turn) {
+                        output += " [SPEAKER_TURN]";
+                    }
+
+                    output += "\n";
+
+                    LOG_DBG("%s%s", s.tag.c_str(), output.c_str());
+                    fflush(stdout);
+
+                    if (params.fname_out.length() > 0) {
+                        s.fout << output;
+                    }
+                }
+            }
+
+            if (params.fname_out.length() > 0) {
+                s.fout << std::endl;
+            }
+
+            if (use_vad) {
+                LOG_DBG("");
+                LOG_DBG("%s### Transcription %d END\n", s.tag.c_str(), r->iter);
+            }
+        }
+
+        if (r->new_line) {
+            LOG_DBG("");
+        }
+        fflush(stdout);
+
+        const int64_t t_end = whisper_stream_now_us();
+
+        stream_pipeline_stats_t &st = s.pipeline;
+        if (st.n_windows == 0) {
+            st.t_first = r->timing.t_ready;
+        }
+        st.n_windows++;
+        st.t_last = t_end;
+        st.sum.assemble    += r->timing.assemble;
+        st.sum.infer_wait  += r->timing.infer_wait;
+        st.sum.infer       += r->timing.infer;
+        st.sum.output_wait += t_start - r->timing.t_done;
+        st.sum.output      += t_end - t_start;
+
+        s.q_result_free.push(r);
     }
-    LOG_DBG("[Start speaking]\n");
-    fflush(stdout);
+}
 
-    auto t_last  = std::chrono::high_resolution_clock::now();
-    const auto t_start = t_last;
+/**
+ * 会话线程主循环：等待新样本、按 step 或 VAD 模式截取音频、组装成窗口交给推理线程。
+ * 推理线程和输出线程由本函数启动，退出前排空流水线并等它们结束。
+ *
+ * @param s 会话。
+ * @param running 所有会话共用的运行标志，置为 false 时退出；推理失败时推理线程也会把它置为 false。
+ */
+static void whisper_session_run(stream_session_t &s, std::atomic<bool> &running)
+{
+    const whisper_params_t &params = *s.params;
+    const stream_config_t &config  = *s.config;
+    audio_source_t *audio = s.audio.get();
+    audio_window_t &window = s.window;
+
+    const int n_samples_step  = config.n_samples_step;
+    const int n_samples_len   = config.n_samples_len;
+    const int n_samples_keep  = config.n_samples_keep;
+    const int n_samples_vad   = config.n_samples_vad;
+    const int n_samples_poll  = config.n_samples_poll;
+    const int n_samples_pre   = config.n_samples_pre;
+    const int n_samples_post  = config.n_samples_post;
+    const int n_samples_frame = config.n_samples_frame;
+    const bool use_vad        = config.use_vad;
+
+    // 积压逼近环形缓冲区容量时无论什么策略都先丢弃最旧的音频，否则采集端会丢掉最新的音频
+    const size_t n_samples_full = audio->ring.capacity()*3/4;
+
+    // shrink 策略下送入推理的音频长度，step 模式最短一个 step，VAD 模式最短 --vad-end
+    const int n_samples_len_min = use_vad ? n_samples_vad/2 : n_samples_step;
+    int n_samples_len_eff = n_samples_len;
+
+    stream_session_t *p = &s;
+    s.infer_worker  = std::thread([p, &running]() { whisper_session_infer(*p, running); });
+    s.output_worker = std::thread([p]() { whisper_session_output(*p); });
+
+    const int16_t *pcm_data = nullptr;  // 本次送入推理的音频，指向 window 内部
+    int pcm_size = 0;
+
+    // VAD 模式下的位置都用采样时钟（audio->ring.clock()）表示，与墙上时间和推理耗时无关
+    const uint64_t no_onset = UINT64_MAX;
+    uint64_t onset   = no_onset;  // 上次转写之后第一个语音帧的位置
+    uint64_t utt_end = 0;         // 上次转写的音频终点，之前的音频不会再送入推理
+    uint64_t pcm_t0  = 0;         // 本次送入推理的音频起点
+    uint64_t pcm_t1  = 0;         // 本次送入推理的音频终点
+
+    bool step_idle  = false;      // --step-vad：上一个 step 是否为静音
+    int  n_line_steps = 0;        // step 模式当前行已推理的 step 数
+    bool prompt_reset = false;    // 下一个窗口推理前清空提示 token
+    bool break_before = false;    // 下一个窗口输出前先换行
+
+    energy_gate_t onset_gate;     // step 模式 vad 过载策略的逐帧判决
+    onset_gate.init(WHISPER_SAMPLE_RATE, params.freq_thold, params.vad_margin_db, params.vad_min_db, params.vad_max_db);
+
+    uint64_t n_rec_dropped = 0;  // 已报告的录音丢弃块数
+    uint64_t n_arc_dropped = 0;  // 已报告的存档丢弃块数
 
     // main audio loop
-    while (is_running) {
-        if (params.save_audio) {
-            wavWriter.write(pcmf32_new.data(), pcmf32_new.size());
+    while (running) {
+        if (s.recorder.dropped_blocks() != n_rec_dropped) {
+            n_rec_dropped = s.recorder.dropped_blocks();
+            LOG_ERR("%s: WARNING: disk too slow, recording dropped %llu blocks so far\n", __func__, (unsigned long long) n_rec_dropped);
         }
-        // handle Ctrl + C
-        is_running = sdl_poll_events();
 
-        if (!is_running) {
-            break;
+        if (s.archive.dropped_blocks() != n_arc_dropped) {
+            n_arc_dropped = s.archive.dropped_blocks();
+            LOG_ERR("%s: WARNING: disk too slow, archive dropped %llu blocks so far\n", __func__, (unsigned long long) n_arc_dropped);
         }
 
         // process new audio
 
+        if (s.idle) {
+            whisper_session_idle_wait(s);
+        }
+
         if (!use_vad) {
-            while (true) {
-                audio.get(params.step_ms, pcmf32_new);
+            // 阻塞等待一个 step 的新样本，超时只是为了定期检查退出标志
+            size_t n_avail = audio->ring.wait(n_samples_step, 100);
+
+            if (audio->realtime()) {
+                s.overload.depth(n_avail);
+
+                if (whisper_session_overloaded(s, n_avail, 2*n_samples_step, n_samples_step)) {
+                    if (config.overload == OVERLOAD_DROP || n_avail >= n_samples_full) {
+                        // 只保留最新的一个 step，窗口中的旧音频与之不再连续，一并清空
+                        const size_t n_drop = n_avail - n_samples_step;
+                        audio->ring.consume(n_drop);
+                        window.clear();
+                        s.overload.n_dropped += n_drop;
+                        n_avail -= n_drop;
+                    } else if (config.overload == OVERLOAD_SKIP) {
+                        // 除最新一个 step 外逐个推入窗口但不推理，窗口中的音频保持连续
+                        while (n_avail >= (size_t) 2*n_samples_step) {
+                            window.push(audio->ring.peek(n_samples_step));
+                            audio->ring.consume(n_samples_step);
+                            n_avail -= n_samples_step;
+                            s.overload.n_skipped++;
+                        }
+                    } else if (config.overload == OVERLOAD_SHRINK) {
+                        n_samples_len_eff = std::max(n_samples_len_min, n_samples_len_eff/2);
+                    }
+                }
+            }
 
-                if ((int) pcmf32_new.size() > 2*n_samples_step) {
-                    LOG_ERR("\n\n%s: WARNING: cannot process audio fast enough, dropping audio ...\n\n", __func__);
-                    audio.clear();
+            if (n_avail < (size_t) n_samples_step) {
+                // 文件输入结束：处理最后不足一个 step 的音频后退出
+                if (!audio->ring.is_closed()) {
                     continue;
                 }
-
-                if ((int) pcmf32_new.size() >= n_samples_step) {
-                    audio.clear();
+                if (n_avail == 0) {
                     break;
                 }
+            }
+
+            const audio_ring_view_t view = audio->ring.peek(n_samples_step);
+            const int n_samples_new = view.total();
+            const uint64_t clock_before = audio->ring.clock();
+
+            window.push(view);
+            audio->ring.consume(n_samples_new);
+            s.n_steps++;
+
+            // 读过 ring 的丢样位置时采样时钟多走了丢弃的样本数，之前的音频与这个 step 不再连续，与 drop 策略一样丢掉
+            if (audio->ring.clock() - clock_before > (uint64_t) n_samples_new) {
+                window.keep(n_samples_new);
+                s.vad.reset();
+            }
+
+            // --step-vad：新样本逐帧检测，没有语音的 step 不推理；语音刚结束的那个 step 仍推理一次，补全最后的词
+            if (config.step_vad) {
+                const uint64_t win_end = audio->ring.clock();
+                s.vad.process(window.tail(n_samples_new), n_samples_new, win_end - n_samples_new, s.vad_events);
+                whisper_session_vad_threshold(s, win_end);
+                if (config.n_samples_idle > 0) {
+                    whisper_session_idle_update(s, win_end);
+                }
 
-                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                if (!s.vad.in_speech() && s.vad_events.empty()) {
+                    step_idle = true;
+                    s.n_idle_steps++;
+                    continue;
+                }
+
+                if (step_idle) {
+                    // 语音重新开始：窗口只留下起点前 pre-roll 的音频，上一段的文本不再作为提示，另起一行
+                    window.keep(std::min(window.size(), (size_t) (n_samples_new + n_samples_pre)));
+                    prompt_reset = true;
+                    break_before = n_line_steps > 0;
+                    n_line_steps = 0;
+                    step_idle = false;
+                }
             }
 
-            const int n_samples_new = pcmf32_new.size();
+            // vad 策略：过载期间新音频中没有语音帧就不推理；不过载时也逐帧判决，保持噪声底跟踪。
+            // --step-vad 时静音的 step 已经跳过，不再重复判决
+            if (config.overload == OVERLOAD_VAD && !config.step_vad) {
+                bool speech = false;
+                const int16_t *pcm_new = window.tail(n_samples_new);
+                for (int i = 0; i < n_samples_new; i += n_samples_frame) {
+                    speech |= onset_gate.process(pcm_new + i, std::min(n_samples_frame, n_samples_new - i));
+                }
+                if (s.overloaded && !speech) {
+                    s.overload.n_skipped++;
+                    continue;
+                }
+            }
 
             // take up to params.length_ms audio from previous iteration
-            const int n_samples_take = std::min((int) pcmf32_old.size(), std::max(0, n_samples_keep + n_samples_len - n_samples_new));
+            const int n_samples_take = std::min((int) window.size() - n_samples_new, std::max(0, n_samples_keep + n_samples_len_eff - n_samples_new));
 
-            //LOG_DBG("processing: take = %d, new = %d, old = %d\n", n_samples_take, n_samples_new, (int) pcmf32_old.size());
+            //LOG_DBG("processing: take = %d, new = %d, old = %d\n", n_samples_take, n_samples_new, (int) window.size() - n_samples_new);
 
-            pcmf32.resize(n_samples_new + n_samples_take);
+            pcm_size = n_samples_take + n_samples_new;
+            pcm_data = window.tail(pcm_size);
+        } else {
+            // 阻塞等待一帧新样本，语音结束后最多一帧就能开始推理
+            size_t n_avail = audio->ring.wait(n_samples_poll, 100);
+            if (n_avail < (size_t) n_samples_poll) {
+                if (!audio->ring.is_closed()) {
+                    continue;
+                }
+                // 输入结束时仍在语音中（离最后一个语音帧不到 hangover，不会再有结束事件）：
+                // 读出 0 个样本，由下面把这一段转写到输入末尾，下一轮 onset 已清空再退出
+                if (n_avail == 0 && onset == no_onset) {
+                    break;
+                }
+            }
 
-            for (int i = 0; i < n_samples_take; i++) {
-                pcmf32[i] = pcmf32_old[pcmf32_old.size() - n_samples_take + i];
+            // 落后超过一个 length 时：drop 丢弃最旧的音频；其他策略把积压一次读完，
+            // 逐帧判决照常进行，但只在最新位置转写一次
+            size_t n_read = n_samples_poll;
+            if (audio->realtime()) {
+                s.overload.depth(n_avail);
+
+                // 每次只等一帧，采集按块到达，积压降到 100ms 以内就算追上
+                if (whisper_session_overloaded(s, n_avail, n_samples_len, WHISPER_SAMPLE_RATE/10)) {
+                    if (config.overload == OVERLOAD_DROP || n_avail >= n_samples_full) {
+                        const size_t n_drop = n_avail - n_samples_poll;
+                        audio->ring.consume(n_drop);
+                        window.clear();
+                        s.overload.n_dropped += n_drop;
+
+                        onset   = no_onset;
+                        utt_end = audio->ring.clock();
+                        s.vad.reset();
+                    } else {
+                        n_read = std::min(n_avail, window.capacity());
+                        s.overload.n_skipped += n_read/n_samples_poll - 1;
+                        if (config.overload == OVERLOAD_SHRINK) {
+                            n_samples_len_eff = std::max(n_samples_len_min, n_samples_len_eff/2);
+                        }
+                    }
+                }
             }
 
-            memcpy(pcmf32.data() + n_samples_take, pcmf32_new.data(), n_samples_new*sizeof(float));
+            const audio_ring_view_t view = audio->ring.peek(n_read);
+            const int n_samples_new = view.total();
+            const uint64_t clock_before = audio->ring.clock();
+            window.push(view);
+            audio->ring.consume(n_samples_new);
+
+            const uint64_t win_end = audio->ring.clock();
+
+            // 读过 ring 的丢样位置时采样时钟多走了丢弃的样本数，窗口中的音频不再连续，
+            // 按 win_end 算出的位置都会偏移：与 drop 策略一样清空窗口和检测状态，从下一块重新开始
+            if (win_end - clock_before > (uint64_t) n_samples_new) {
+                window.clear();
+                onset   = no_onset;
+                utt_end = win_end;
+                s.vad.reset();
+                continue;
+            }
 
-            pcmf32_old = pcmf32;
-        } else {
-            const auto t_now  = std::chrono::high_resolution_clock::now();
-            const auto t_diff = std::chrono::duration_cast<std::chrono::milliseconds>(t_now - t_last).count();
+            // 每个新样本只经过一次逐帧检测：语音开始时记下起点，语音结束时转写
+            s.vad.process(window.tail(n_samples_new), n_samples_new, win_end - n_samples_new, s.vad_events);
+            whisper_session_vad_threshold(s, win_end);
+            if (config.n_samples_idle > 0) {
+                whisper_session_idle_update(s, win_end);
+            }
 
-            if (t_diff < 2000) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            bool utt_done = false;
+            uint64_t utt_onset = no_onset;
+            uint64_t utt_speech_end = win_end;
+            for (const frame_vad_event_t &ev : s.vad_events) {
+                if (ev.type == FRAME_VAD_START) {
+                    if (onset == no_onset) {
+                        onset = ev.at;
+                    }
+                } else {
+                    // 一块中可能先结束又开始新的一段，新一段的起点留给下一次
+                    if (!utt_done) {
+                        utt_onset = onset;
+                        utt_speech_end = ev.at;
+                    }
+                    utt_done = true;
+                    onset = no_onset;
+                }
+            }
 
+            if (n_samples_new == 0 && onset != no_onset) {
+                utt_done       = true;
+                utt_onset      = onset;
+                utt_speech_end = win_end;
+                onset          = no_onset;
+            }
+
+            if (!utt_done) {
                 continue;
             }
 
-            audio.get(2000, pcmf32_new);
+            // 只转写语音段本身：到最后一个语音帧之后 post-roll 处为止，拖尾的静音不送入推理
+            const uint64_t end = std::min(win_end, utt_speech_end + n_samples_post);
 
-            if (::vad_simple(pcmf32_new, WHISPER_SAMPLE_RATE, 1000, params.vad_thold, params.freq_thold, false)) {
-                audio.get(params.length_ms, pcmf32);
-            } else {
-                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            // 从语音起点前 pre-roll 处开始；没检测到起点时退回最近的 length。
+            // 不早于上次转写的终点，避免对已转写过的音频重复推理
+            uint64_t start = utt_onset != no_onset ? utt_onset - std::min<uint64_t>(utt_onset, n_samples_pre)
+                                                   : end - std::min<uint64_t>(end, n_samples_len_eff);
+            start = std::max(start, utt_end);
+            start = std::max(start, win_end - std::min<uint64_t>(win_end, window.size()));
+            start = std::max(start, end - std::min<uint64_t>(end, n_samples_pre + n_samples_len_eff));
 
+            if (start >= end) {
                 continue;
             }
 
-            t_last = t_now;
+            pcm_t0   = start;
+            pcm_t1   = end;
+            utt_end  = end;
+            pcm_size = (int) (pcm_t1 - pcm_t0);
+            pcm_data = window.tail((size_t) (win_end - pcm_t0));
         }
 
-        // run the inference
+        // 组装窗口交给推理线程：推理线程还在处理上一个窗口时这里不等待，两个缓冲区都在途时才阻塞
         {
-            whisper_full_params wparams = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+            stream_window_t *w = nullptr;
+            if (!s.q_window_free.pop(w)) {
+                break;
+            }
 
-            wparams.print_progress   = false;
-            wparams.print_special    = params.print_special;
-            wparams.print_realtime   = false;
-            wparams.print_timestamps = !params.no_timestamps;
-            wparams.translate        = params.translate;
-            wparams.single_segment   = !use_vad;
-            wparams.max_tokens       = params.max_tokens;
-            wparams.language         = params.language.c_str();
-            wparams.n_threads        = params.n_threads;
+            const int64_t t_start = whisper_stream_now_us();
 
-            wparams.audio_ctx        = params.audio_ctx;
+            pcm_s16_to_f32(pcm_data, w->pcm.data(), pcm_size);
+            if (params.denoise) {
+                s.denoise.process(w->pcm.data(), pcm_size);
+            }
 
-            wparams.tdrz_enable      = params.tinydiarize; // [TDRZ]
+            const bool new_line = !use_vad && (++n_line_steps % config.n_new_line) == 0;
 
-            // disable temperature fallback
-            //wparams.temperature_inc  = -1.0f;
-            wparams.temperature_inc  = params.no_fallback ? 0.0f : wparams.temperature_inc;
+            w->n_samples    = pcm_size;
+            w->t0           = pcm_t0;
+            w->t1           = pcm_t1;
+            w->vad_thold    = use_vad ? s.vad.model().threshold() : 0.0f;
+            w->prompt_reset = prompt_reset;
+            w->break_before = break_before;
+            w->new_line     = new_line;
 
-            wparams.prompt_tokens    = params.no_context ? nullptr : prompt_tokens.data();
-            wparams.prompt_n_tokens  = params.no_context ? 0       : prompt_tokens.size();
+            w->timing = stream_timing_t();
+            w->timing.t_ready  = whisper_stream_now_us();
+            w->timing.assemble = w->timing.t_ready - t_start;
 
-            if (whisper_full(ctx, wparams, pcmf32.data(), pcmf32.size()) != 0) {
-                LOG_ERR("%s: failed to process audio\n", params.program_name);
-                return 6;
+            if (!s.q_window.push(w)) {
+                break;
             }
+            prompt_reset = false;
+            break_before = false;
 
-            // print result;
-            {
-                if (!use_vad) {
-                    LOG_DBG("\33[2K\r");
+            // 追上之后每次推理恢复一点长度
+            if (!s.overloaded && n_samples_len_eff < n_samples_len) {
+                n_samples_len_eff = std::min(n_samples_len, n_samples_len_eff + n_samples_len_min);
+            }
 
-                    // print long empty line to clear the previous line
-                    LOG_DBG("%s", std::string(100, ' ').c_str());
+            if (new_line) {
+                // keep part of the audio for next iteration to try to mitigate word boundary issues
+                window.keep(n_samples_keep);
+                n_line_steps = 0;
+            }
+        }
+    }
 
-                    LOG_DBG("\33[2K\r");
-                } else {
-                    const int64_t t1 = (t_last - t_start).count()/1000000;
-                    const int64_t t0 = std::max(0.0, t1 - pcmf32.size()*1000.0/WHISPER_SAMPLE_RATE);
+    // 排空流水线：推理线程处理完已交出的窗口后关闭结果队列，输出线程随之退出
+    s.q_window.close();
+    s.infer_worker.join();
+    s.output_worker.join();
 
-                    LOG_DBG("");
-                    LOG_DBG("### Transcription %d START | t0 = %d ms | t1 = %d ms\n", n_iter, (int) t0, (int) t1);
-                    LOG_DBG("");
-                }
+    s.done = true;
+    whisper_stream_wake(s.wake_fd);
+}
 
-                const int n_segments = whisper_full_n_segments(ctx);
-                for (int i = 0; i < n_segments; ++i) {
-                    const char * text = whisper_full_get_segment_text(ctx, i);
-                    
-                    whisper_fuzzy_match(whisper_fuzzy_ctx, n_segments - i - 1, text);
+/**
+ * 停止会话的采集，关闭旁路并输出统计。调用前会话线程必须已结束。
+ *
+ * @param s 会话。
+ */
+static void whisper_session_finish(stream_session_t &s)
+{
+    if (!s.audio) {
+        return;
+    }
 
-                    if (params.no_timestamps) {
-                        LOG_DBG("%s", text);
-                        fflush(stdout);
+    s.audio->pause();
 
-                        if (params.fname_out.length() > 0) {
-                            fout << text;
-                        }
-                    } else {
-                        const int64_t t0 = whisper_full_get_segment_t0(ctx, i);
-                        const int64_t t1 = whisper_full_get_segment_t1(ctx, i);
+    if (s.recorder.is_open()) {
+        s.recorder.close();
+        LOG_INFO("%srecorded %.1f sec, dropped %llu blocks", s.tag.c_str(),
+            (double) s.recorder.written() / WHISPER_SAMPLE_RATE, (unsigned long long) s.recorder.dropped_blocks());
+    }
 
-                        std::string output = "[" + to_timestamp(t0, false) + " --> " + to_timestamp(t1, false) + "]  " + text;
+    if (s.archive.is_open()) {
+        s.archive.close();
+        LOG_INFO("%sarchived %.1f of %.1f sec in %llu spans / %llu segments, dropped %llu blocks, %llu io errors", s.tag.c_str(),
+            (double) s.archive.samples_kept() / WHISPER_SAMPLE_RATE, (double) s.archive.samples_in() / WHISPER_SAMPLE_RATE,
+            (unsigned long long) s.archive.spans(), (unsigned long long) s.archive.segments(),
+            (unsigned long long) s.archive.dropped_blocks(), (unsigned long long) s.archive.io_errors());
+    }
 
-                        if (whisper_full_get_segment_speaker_turn_next(ctx, i)) {
-                            output += " [SPEAKER_TURN]";
-                        }
+    const resampler_t *resample = s.audio->resample_stage();
+    if (resample) {
+        const resampler_stats_t rs = resample->stats();
+        const double sec = rs.n_in / (double) resample->rate_in;
+        LOG_INFO("%sresample stage: %d -> %d Hz, %llu blocks, %.1f us/block (max %.1f us), %.3f%% of real time", s.tag.c_str(),
+            resample->rate_in, resample->rate_out, (unsigned long long) rs.n_blocks,
+            rs.n_blocks ? rs.ns_total / 1e3 / rs.n_blocks : 0.0, rs.ns_max / 1e3,
+            sec > 0.0 ? 100.0 * rs.ns_total / (sec * 1e9) : 0.0);
+    }
 
-                        output += "\n";
+    if (s.params->denoise) {
+        const denoise_stats_t &ds = s.denoise.stats();
+        LOG_INFO("%sdenoise stage: %llu windows, %.1f us/window (max %.1f us), %.2f us/frame, %.2f%% of inference time, noise %.1f dBFS",
+            s.tag.c_str(), (unsigned long long) ds.n_blocks,
+            ds.n_blocks ? ds.ns_total / 1e3 / ds.n_blocks : 0.0, ds.ns_max / 1e3,
+            ds.n_frames ? ds.ns_total / 1e3 / ds.n_frames : 0.0,
+            s.t_infer_us > 0 ? 100.0 * ds.ns_total / (s.t_infer_us * 1e3) : 0.0, s.denoise.noise_db());
+    }
 
-                        LOG_DBG("%s", output.c_str());
-                        fflush(stdout);
+    if (s.audio->realtime()) {
+        const overload_stats_t &ov = s.overload;
+        LOG_INFO("%soverload policy %s: %llu events, dropped %.1f sec by policy and %.1f sec by full ring, skipped %llu windows",
+            s.tag.c_str(), overload_policy_name(s.config->overload), (unsigned long long) ov.n_events,
+            (double) ov.n_dropped / WHISPER_SAMPLE_RATE, (double) s.audio->ring.dropped() / WHISPER_SAMPLE_RATE,
+            (unsigned long long) ov.n_skipped);
+        LOG_INFO("%squeue depth: mean %.2f sec, max %.2f sec of %.2f sec (%.0f%% saturation)", s.tag.c_str(),
+            ov.n_polls ? (double) ov.depth_sum / ov.n_polls / WHISPER_SAMPLE_RATE : 0.0,
+            (double) ov.depth_max / WHISPER_SAMPLE_RATE, (double) s.audio->ring.capacity() / WHISPER_SAMPLE_RATE,
+            100.0 * ov.depth_max / s.audio->ring.capacity());
+    }
 
-                        if (params.fname_out.length() > 0) {
-                            fout << output;
-                        }
-                    }
-                }
+    if (s.config->n_samples_idle > 0) {
+        const double sec = (double) s.audio->ring.clock() / WHISPER_SAMPLE_RATE;
+        LOG_INFO("%spower save: blocked %.1f of %.1f sec, skipped %.1f sec of silence, woken %llu times by speech onset",
+            s.tag.c_str(), s.t_idle_us / 1e6, sec, (double) s.n_idle_dropped / WHISPER_SAMPLE_RATE,
+            (unsigned long long) s.onset.onsets());
+    }
 
-                if (params.fname_out.length() > 0) {
-                    fout << std::endl;
-                }
+    if (s.config->step_vad) {
+        LOG_INFO("%sstep vad: skipped %llu of %llu steps (%.0f%%) as silent", s.tag.c_str(),
+            (unsigned long long) s.n_idle_steps, (unsigned long long) s.n_steps,
+            s.n_steps ? 100.0 * s.n_idle_steps / s.n_steps : 0.0);
+    }
+
+    if (s.vad_thold_seen) {
+        LOG_INFO("%svad threshold: %.1f .. %.1f dBFS, last %.1f dBFS (noise floor %.1f dBFS)", s.tag.c_str(),
+            s.vad_thold_min, s.vad_thold_max, s.vad.model().threshold(), s.vad.model().noise());
+    }
+
+    LOG_INFO("%sinference: %d runs, %.1f ms total, %.1f ms/run, audio_ctx %.0f/run", s.tag.c_str(), s.n_iter,
+        s.t_infer_us / 1e3, s.n_iter ? s.t_infer_us / 1e3 / s.n_iter : 0.0, s.n_iter ? (double) s.n_ctx_sum / s.n_iter : 0.0);
+
+    const stream_pipeline_stats_t &pl = s.pipeline;
+    if (pl.n_windows > 0) {
+        const double n = (double) pl.n_windows;
+        const stream_timing_t &sum = pl.sum;
+        LOG_INFO("%spipeline: %llu windows, per window: assemble %.2f ms, queued %.1f ms, inference %.1f ms, queued %.2f ms, output %.2f ms",
+            s.tag.c_str(), (unsigned long long) pl.n_windows, sum.assemble / 1e3 / n, sum.infer_wait / 1e3 / n,
+            sum.infer / 1e3 / n, sum.output_wait / 1e3 / n, sum.output / 1e3 / n);
+
+        // 串行时每个窗口依次经过三级；流水线上组装和输出与推理重叠，窗口间隔在积压时逼近纯推理时间
+        const int64_t wall = pl.t_last - pl.t_first;
+        LOG_INFO("%spipeline: %.1f ms/window serial, %.1f ms/window elapsed, inference busy %.0f%% of %.1f sec", s.tag.c_str(),
+            (sum.assemble + sum.infer + sum.output) / 1e3 / n, wall / 1e3 / n,
+            wall > 0 ? 100.0 * sum.infer / wall : 0.0, wall / 1e6);
+    }
+}
+
+/**
+ * 计算一次推理的音频上下文大小，识别会话和 --bench 共用。
+ *
+ * -ac 为 -1 时按送入推理的样本数加上安全余量换算成编码器帧数，再限制在下限和模型上限之间；
+ * 否则直接使用 -ac 的值。
+ *
+ * @param params 命令行参数。
+ * @param n_samples 本次送入 whisper_full 的样本数。
+ * @param n_ctx_max 模型的音频上下文上限，即 whisper_model_n_audio_ctx()。
+ * @return whisper_full_params::audio_ctx 的值，0 表示全部。
+ */
+int whisper_stream_audio_ctx(const whisper_params_t &params, int n_samples, int n_ctx_max)
+{
+    if (params.audio_ctx >= 0) {
+        return params.audio_ctx;
+    }
+
+    // 编码器的卷积步长为 2，每个上下文帧对应两个 mel 帧
+    const int n_frame  = 2 * WHISPER_HOP_LENGTH;
+    const int n_margin = (int) ((1e-3 * std::max(0, params.audio_ctx_margin_ms)) * WHISPER_SAMPLE_RATE);
+    const int n_ctx    = (std::max(0, n_samples) + n_margin + n_frame - 1) / n_frame;
+
+    return std::min(n_ctx_max, std::max(n_ctx, params.audio_ctx_min));
+}
 
-                if (use_vad) {
-                    LOG_DBG("");
-                    LOG_DBG("### Transcription %d END\n", n_iter);
+/**
+ * 由命令行参数得到 VAD 模式的流式语音检测参数，识别会话和 --bench 共用。
+ *
+ * @param params 命令行参数。
+ * @param vad 输出的检测参数。
+ * @return 成功返回 true，VAD 模型名称未知返回 false。
+ */
+bool whisper_stream_vad_params(const whisper_params_t &params, frame_vad_params_t &vad)
+{
+    vad.sample_rate = WHISPER_SAMPLE_RATE;
+    vad.frame_ms    = 20;
+    vad.freq_thold  = params.freq_thold;
+    vad.gate_db     = params.vad_margin_db;
+    vad.floor_db    = params.vad_min_db;
+    vad.ceil_db     = params.vad_max_db;
+    vad.start_ms    = params.vad_start_ms;
+    vad.end_ms      = std::max(params.vad_end_ms, 20);
+    vad.end_thold   = params.vad_thold;
+    vad.hangover_ms = std::max(params.hangover_ms, 0);
+    vad.mode        = params.vad_mode;
+
+    return vad_model_parse(params.vad_model, vad.model);
+}
+
+/**
+ * 运行 Whisper 语音流处理的主函数。
+ *
+ * @param task 识别任务，包含参数副本、回调和共享的引擎；推理状态从引擎借用，返回前归还。
+ * @return 成功返回 0，失败返回 -1。
+ *
+ * 该函数负责管理 Whisper 的音频流处理，调用相关的语音识别和匹配功能，
+ * 以便实时处理输入音频数据并执行模糊匹配任务。
+ * 指定多个采集设备时每个设备一路识别会话，各自在独立线程中推理，共享同一份模型；
+ * 调用线程只负责处理退出事件并等待所有会话结束。多个任务可以在不同线程中同时运行。
+ */
+int whisper_stream_main(whisper_engine_task_t &task) {
+    // 参数是本任务的副本，下面按模式调整不影响同时运行的其他任务
+    whisper_params_t &params = task.params;
+
+    if (!params.bench.empty()) {
+        return whisper_bench_main(task);
+    }
+
+    if (!task.engine) {
+        LOG_ERR("%s: no engine, was whisper_fuzzy_init() called in bench mode?\n", __func__);
+        return 1;
+    }
+    whisper_engine_t &engine = *task.engine;
+
+    params.keep_ms   = std::min(params.keep_ms,   params.step_ms);
+    params.length_ms = std::max(params.length_ms, params.step_ms);
+
+    stream_config_t config;
+    config.n_samples_step  = (1e-3*params.step_ms  )*WHISPER_SAMPLE_RATE;
+    config.n_samples_len   = (1e-3*params.length_ms)*WHISPER_SAMPLE_RATE;
+    config.n_samples_keep  = (1e-3*params.keep_ms  )*WHISPER_SAMPLE_RATE;
+    config.n_samples_vad   = (1e-3*2*std::max(params.vad_end_ms, 20))*WHISPER_SAMPLE_RATE;  // 语音结束判决窗口
+    config.n_samples_poll  = (1e-3*20.0            )*WHISPER_SAMPLE_RATE;  // VAD 模式每次等待的新样本数，一帧
+    config.n_samples_pre   = (1e-3*std::max(0, params.preroll_ms))*WHISPER_SAMPLE_RATE;  // VAD 模式语音起点之前保留的样本数
+    config.n_samples_post  = (1e-3*std::max(0, params.postroll_ms))*WHISPER_SAMPLE_RATE; // VAD 模式语音终点之后保留的样本数
+    config.n_samples_frame = (1e-3*20.0            )*WHISPER_SAMPLE_RATE;  // 语音检测的帧长
+
+    if (!whisper_stream_vad_params(params, config.vad)) {
+        LOG_ERR("error: unknown vad model '%s'\n", params.vad_model.c_str());
+        whisper_print_usage(params);
+        return 1;
+    }
+
+    config.use_vad = config.n_samples_step <= 0; // sliding window mode uses VAD
+    config.step_vad = !config.use_vad && params.step_vad;
+    config.n_samples_idle = config.use_vad || config.step_vad ? (1e-3*std::max(0, params.idle_ms))*WHISPER_SAMPLE_RATE : 0;
+
+    config.n_new_line = !config.use_vad ? std::max(1, params.length_ms / params.step_ms - 1) : 1; // number of steps to print new line
+
+    params.no_timestamps  = !config.use_vad;
+    params.no_context    |= config.use_vad;
+    params.max_tokens     = 0;
+
+    // init audio
+
+    // 环形缓冲区至少能容纳一个完整窗口，并留出一倍余量给推理耗时
+    const size_t n_samples_ring = 2*std::max(std::max(config.n_samples_len, config.n_samples_vad), 2*config.n_samples_step);
+
+    audio_source_params_t sparams;
+    sparams.type         = AUDIO_SOURCE_SDL;
+    sparams.sample_rate  = WHISPER_SAMPLE_RATE;
+    sparams.capture_rate = params.audio_rate;
+    sparams.ring_samples = n_samples_ring;
+    sparams.path         = params.input;
+    sparams.paced        = params.input_paced;
+    sparams.period_ms    = params.period_ms;
+    sparams.buffer_ms    = params.buffer_ms;
+    sparams.rt_priority  = params.realtime ? params.rt_prio : 0;
+
+    if (!params.input.empty()) {
+        if (!audio_source_type_parse(params.input_format, sparams.type)) {
+            LOG_ERR("error: unknown input format '%s'\n", params.input_format.c_str());
+            whisper_print_usage(params);
+            return 1;
+        }
+    } else if (!audio_source_backend_parse(params.audio_backend, sparams.type)) {
+        LOG_ERR("error: unknown or unsupported audio backend '%s'\n", params.audio_backend.c_str());
+        whisper_print_usage(params);
+        return 1;
+    }
+
+    // 每个采集设备一路识别会话，文件输入只有一路
+    int n_sessions = 1;
+    if (sparams.type == AUDIO_SOURCE_SDL) {
+        n_sessions = std::max<int>(1, params.capture_ids.size());
+    } else if (sparams.type == AUDIO_SOURCE_ALSA) {
+        n_sessions = std::max<int>(1, params.alsa_devices.size());
+    } else if (params.capture_ids.size() > 1 || params.alsa_devices.size() > 1) {
+        LOG_ERR("error: multiple capture devices cannot be combined with an input file\n");
+        whisper_print_usage(params);
+        return 1;
+    }
+
+    if (!overload_policy_parse(params.overload, config.overload)) {
+        LOG_ERR("error: unknown overload policy '%s'\n", params.overload.c_str());
+        whisper_print_usage(params);
+        return 1;
+    }
+
+    if (!params.infer_cpus.empty() && !rt_sched_parse_cpus(params.infer_cpus, config.infer_cpus)) {
+        LOG_ERR("error: bad cpu list '%s'\n", params.infer_cpus.c_str());
+        whisper_print_usage(params);
+        return 1;
+    }
+
+    // whisper init
+    if (params.language != "auto" && whisper_lang_id(params.language.c_str()) == -1){
+        LOG_ERR("error: unknown language '%s'\n", params.language.c_str());
+        whisper_print_usage(params);
+        exit(0);
+    }
+
+    // 每个任务一个唤醒管道，会话结束时只唤醒自己的主线程
+    int wake_fd[2] = { -1, -1 };
+    whisper_stream_pipe(wake_fd);
+    whisper_stream_install_signals();
+
+    // 会话在独立线程中运行，必须在启动之前创建好全部会话，此后 params 只读
+    std::vector<std::unique_ptr<stream_session_t>> sessions;
+    int ret = 0;
+
+    // 打开采集设备与模型加载并行
+    for (int i = 0; i < n_sessions; i++) {
+        sessions.emplace_back(new stream_session_t);
+        stream_session_t &s = *sessions.back();
+
+        s.index  = i;
+        s.tag    = n_sessions > 1 ? "[" + std::to_string(i) + "] " : "";
+        s.task   = &task;
+        s.wake_fd = wake_fd[1];
+        s.params = &params;
+        s.config = &config;
+
+        audio_source_params_t dev = sparams;
+        dev.capture_id = i < (int) params.capture_ids.size() ? params.capture_ids[i] : -1;
+        dev.device     = i < (int) params.alsa_devices.size() ? params.alsa_devices[i] : "";
+
+        if (!whisper_session_init(s, dev, n_sessions)) {
+            ret = 1;
+            break;
+        }
+    }
+
+    // 模型在 whisper_fuzzy_init() 时已开始在后台加载，多次调用和同时运行的任务共用
+    const auto t_wait = std::chrono::steady_clock::now();
+    if (!whisper_engine_wait(engine)) {
+        LOG_ERR("%s: failed to load model '%s'\n", __func__, params.model.c_str());
+        ret = 1;
+    }
+    const int64_t t_wait_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - t_wait).count();
+
+    whisper_context *ctx = engine.ctx;
+
+    if (ret == 0 && !whisper_is_multilingual(ctx)) {
+        if (params.language != "en" || params.translate) {
+            params.language = "en";
+            params.translate = false;
+            LOG_ERR("%s: WARNING: model is not multilingual, ignoring language and translation options\n", __func__);
+        }
+    }
+
+    // 推理的中间结果和 KV 缓存在 state 中，每个会话从引擎借一份，模型权重共享；任务结束后归还复用
+    for (int i = 0; ret == 0 && i < n_sessions; i++) {
+        stream_session_t &s = *sessions[i];
+        s.ctx   = ctx;
+        s.state = whisper_engine_acquire(task);
+        if (!s.state) {
+            ret = 1;
+        }
+    }
+
+    if (ret == 0) {
+        // print some info about the processing
+        {
+            LOG_ERR("");
+            LOG_ERR("%s: processing %d samples (step = %.1f sec / len = %.1f sec / keep = %.1f sec), %d threads, lang = %s, task = %s, timestamps = %d ...\n",
+                    __func__,
+                    config.n_samples_step,
+                    float(config.n_samples_step)/WHISPER_SAMPLE_RATE,
+                    float(config.n_samples_len )/WHISPER_SAMPLE_RATE,
+                    float(config.n_samples_keep)/WHISPER_SAMPLE_RATE,
+                    params.n_threads,
+                    params.language.c_str(),
+                    params.translate ? "translate" : "transcribe",
+                    params.no_timestamps ? 0 : 1);
+
+            if (!config.use_vad) {
+                LOG_ERR("%s: n_new_line = %d, no_context = %d\n", __func__, config.n_new_line, params.no_context);
+                if (config.step_vad) {
+                    LOG_ERR("%s: using VAD (%s), will skip silent steps\n", __func__, vad_model_name(config.vad.model));
                 }
+            } else {
+                LOG_ERR("%s: using VAD (%s), will transcribe on speech activity\n", __func__, vad_model_name(config.vad.model));
             }
 
-            ++n_iter;
+            if (n_sessions > 1) {
+                LOG_ERR("%s: %d capture streams sharing one model\n", __func__, n_sessions);
+            }
 
-            if (!use_vad && (n_iter % n_new_line) == 0) {
-                LOG_DBG("");
+            LOG_ERR("%s: pcm conversion: %s\n", __func__, pcm_convert_impl());
+            LOG_ERR("%s: vad kernel: %s\n", __func__, vad_kernels_impl());
+            if (params.denoise) {
+                LOG_ERR("%s: denoise: fft kernel %s, gain floor %.1f dB\n", __func__, fft_kernels_impl(), params.denoise_floor_db);
+            }
+            if (params.grammar && task.grammar) {
+                LOG_ERR("%s: grammar: %zu commands, %zu rules, penalty %.1f\n", __func__,
+                    task.grammar->n_texts, task.grammar->rules.size(), params.grammar_penalty);
+            }
+            LOG_ERR("%s: model loaded in %.1f ms, warm-up %.1f ms, waited %.1f ms after audio init\n", __func__,
+                engine.t_load_us / 1e3, engine.t_warmup_us / 1e3, t_wait_us / 1e3);
 
-                // keep part of the audio for next iteration to try to mitigate word boundary issues
-                pcmf32_old = std::vector<float>(pcmf32.end() - n_samples_keep, pcmf32.end());
+            LOG_ERR("");
+        }
 
-                // Add tokens of the last full length segment as the prompt
-                if (!params.no_context) {
-                    prompt_tokens.clear();
+        if (!config.infer_cpus.empty() && (int) config.infer_cpus.size() < n_sessions*params.n_threads) {
+            LOG_ERR("%s: WARNING: %d inference threads share %d pinned cpus\n", __func__,
+                n_sessions*params.n_threads, (int) config.infer_cpus.size());
+        }
 
-                    const int n_segments = whisper_full_n_segments(ctx);
-                    for (int i = 0; i < n_segments; ++i) {
-                        const int token_count = whisper_full_n_tokens(ctx, i);
-                        for (int j = 0; j < token_count; ++j) {
-                            prompt_tokens.push_back(whisper_full_get_token_id(ctx, i, j));
-                        }
-                    }
-                }
+        // 模型权重和所有会话的缓冲区都已分配，锁定后推理不会再因缺页停顿
+        if (params.realtime) {
+            rt_sched_lock_memory();
+        }
+
+        for (auto &s : sessions) {
+            s->audio->resume();
+        }
+
+        LOG_DBG("[Start speaking]\n");
+        fflush(stdout);
+
+        std::atomic<bool> running(true);
+
+        for (auto &s : sessions) {
+            stream_session_t *p = s.get();
+            p->worker = std::thread([p, &running]() { whisper_session_run(*p, running); });
+        }
+
+        // 退出信号（Ctrl + C 或 SIGTERM）在调用线程中处理，所有会话结束（文件读完）时也退出
+        while (running) {
+            if (g_interrupted) {
+                running = false;
+                break;
+            }
+
+            bool all_done = true;
+            for (const auto &s : sessions) {
+                all_done = all_done && s->done;
+            }
+            if (all_done) {
+                break;
+            }
+
+            // 所有音频源都阻塞到 Ctrl + C、SIGTERM 或会话结束，不轮询
+            whisper_stream_wait(wake_fd[0], -1);
+        }
+        running = false;
+
+        // 省电状态下的会话线程可能正阻塞在 ring 上，叫醒它们尽快退出
+        for (auto &s : sessions) {
+            s->audio->ring.kick();
+        }
+
+        for (auto &s : sessions) {
+            s->worker.join();
+            if (ret == 0) {
+                ret = s->ret;
             }
-            fflush(stdout);
         }
     }
 
-    audio.pause();
+    for (auto &s : sessions) {
+        whisper_session_finish(*s);
+    }
+
+    // 会话线程都已结束，whisper_state 归还给引擎留给之后的任务，模型在 whisper_fuzzy_exit() 中释放
+    sessions.clear();
+    whisper_engine_release(task);
 
-    whisper_print_timings(ctx);
-    whisper_free(ctx);
+    if (wake_fd[0] >= 0) {
+        close(wake_fd[0]);
+        close(wake_fd[1]);
+    }
 
-    return 0;
+    return ret;
 }
@@ -3,11 +3,17 @@
 
 #include <thread>
 #include <string>
+#include <vector>
 
 #include "whisper_fuzzy.h"
 
 #include "stdint.h"
 
+struct frame_vad_params_t;
+struct whisper_engine_task_t;
+struct whisper_context;
+struct whisper_state;
+
 /**
  * 结构体：whisper_params_t
  * 用于存储命令行参数配置，影响 Whisper 语音处理的行为。
@@ -19,12 +25,32 @@ struct whisper_params_t {
     int32_t step_ms    = 1000;  // 每次音频处理的步长（毫秒）。
     int32_t length_ms  = 3000;  // 每次音频片段的长度（毫秒）。
     int32_t keep_ms    = 100;   // 处理时保留的音频长度（毫秒）。
-    int32_t capture_id = -1;    // 录音设备 ID，默认为 -1（未指定）。
     int32_t max_tokens = 8;     // 每个音频片段允许的最大 Token 数量。
-    int32_t audio_ctx  = 0;     // 音频上下文大小，0 表示全部。
+    int32_t audio_ctx  = -1;    // 音频上下文大小，0 表示全部，-1 表示按每次送入推理的音频长度计算。
+    int32_t audio_ctx_margin_ms = 500; // -ac -1 时在音频长度之外额外留给编码器的上下文（毫秒）。
+    int32_t audio_ctx_min = 256; // -ac -1 时音频上下文的下限（编码器帧数，每帧 20 毫秒）。
+    int32_t period_ms  = 10;    // ALSA 采集周期长度（毫秒）。
+    int32_t buffer_ms  = 80;    // ALSA 采集缓冲区长度（毫秒）。
+    int32_t audio_rate = 0;     // 采集/输入采样率，0 表示设备原生采样率或 WAV 文件头。
+    int32_t preroll_ms = 300;   // VAD 模式下在语音起点之前额外保留的音频（毫秒）。
+    int32_t vad_start_ms = 60;  // VAD 模式下连续语音达到该时长才算开始（毫秒）。
+    int32_t vad_end_ms = 1000;  // VAD 模式下语音结束判决窗口（毫秒），与 -vth 一起判断是否说完。
+    int32_t hangover_ms = 300;  // VAD 模式下语音后连续静音达到该时长即结束（毫秒），0 表示用 -vth 判决。
+    int32_t vad_mode    = 2;    // gmm VAD 的激进程度 0 ~ 3，越大越不容易误触发。
+    int32_t postroll_ms = 100;  // VAD 模式下在语音终点之后额外保留的音频（毫秒）。
+    int32_t idle_ms     = 0;    // VAD 模式（或 --step-vad）连续静音达到该时长后进入省电状态（毫秒），0 表示不启用。
+    int32_t rt_prio    = 70;    // 实时模式下采集线程的 SCHED_FIFO 优先级。
+    int32_t archive_pad_ms = 300; // 语音存档中语音段前后各保留的时长（毫秒）。
+    int32_t archive_sec = 600;  // 语音存档单个分段文件的最大时长（秒），0 表示不限。
+    int32_t archive_mb  = 0;    // 语音存档单个分段文件的最大大小（MB），0 表示不限。
 
     float vad_thold    = 0.6f;  // 语音活动检测（VAD）的阈值。
     float freq_thold   = 100.0f;// 高通滤波的截止频率（Hz）。
+    float vad_margin_db = 10.0f;// VAD 逐帧判决门限高出跟踪噪声底的 dB 数。
+    float vad_min_db   = -60.0f;// VAD 逐帧判决门限的下限（dBFS），安静房间里低于该能量一律算静音。
+    float vad_max_db   = -30.0f;// VAD 逐帧判决门限的上限（dBFS），嘈杂房间里门限不再继续升高。
+    float denoise_floor_db = -15.0f; // --denoise 的增益下限（dB），即每个频点的最大衰减量。
+    float grammar_penalty = 100.0f;  // --grammar 的语法惩罚，不符合命令语法的 token 的 logit 减去该值。
 
     bool translate     = false; // 是否将源语言翻译为英语。
     bool no_fallback   = false; // 是否禁用温度回退机制。
@@ -35,6 +61,11 @@ struct whisper_params_t {
     bool save_audio    = false; // 是否将录制的音频保存到文件。
     bool use_gpu       = true;  // 是否启用 GPU 加速。
     bool flash_attn    = false; // 是否在推理时使用 Flash Attention。
+    bool input_paced   = true;  // 文件输入是否按实时速度输出。
+    bool realtime      = false; // 实时模式：采集线程 SCHED_FIFO，锁定模型和音频缓冲区内存。
+    bool step_vad      = false; // step 模式下逐帧检测语音，静音的 step 不推理，语音重新开始时清空上下文。
+    bool denoise       = false; // 送入推理之前做频域降噪。
+    bool grammar       = false; // 用 config.json 的命令文本生成语法约束解码。
 
     // 语音的语言，默认为英语。
     std::string language  = "en"; 
@@ -42,6 +73,20 @@ struct whisper_params_t {
     std::string model     = "models/ggml-base.en.bin"; 
     std::string user      = ""; // 用户配置文件路径。
     std::string fname_out;      // 输出文件名。
+    std::string input;          // 输入音频文件路径，"-" 表示标准输入，空表示麦克风。
+    std::string input_format = "wav"; // 输入音频格式：wav、s16 或 f32。
+#ifdef WHISPER_FUZZY_SDL2
+    std::string audio_backend = "sdl";  // 采集后端：sdl 或 alsa。
+#else
+    std::string audio_backend = "alsa"; // 采集后端：sdl 或 alsa。
+#endif
+    std::vector<int32_t> capture_ids;     // SDL 录音设备 ID 列表，空表示默认设备；每个设备一路识别会话。
+    std::vector<std::string> alsa_devices; // ALSA 采集设备名列表，空表示 "default"；每个设备一路识别会话。
+    std::string bench;          // 基准测试名称，非空时只运行基准测试。
+    std::string archive_dir;    // 语音存档目录，非空时只保存语音段。
+    std::string infer_cpus;     // 推理线程绑定的 CPU 列表，例如 "2,3" 或 "1-3"，空表示不绑定。
+    std::string overload = "drop"; // 推理跟不上采集时的策略：drop、skip、shrink 或 vad。
+    std::string vad_model = "energy"; // VAD 模式的逐帧语音判决模型：energy 或 gmm。
     const char *program_name;   // 程序名称。
 };
 
@@ -54,15 +99,38 @@ struct whisper_params_t {
  */
 void whisper_print_usage(const whisper_params_t & params);
 
+/**
+ * 由命令行参数得到 VAD 模式的流式语音检测参数，识别会话和 --bench 共用。
+ *
+ * @param params 命令行参数。
+ * @param vad 输出的检测参数。
+ * @return 成功返回 true，VAD 模型名称未知返回 false。
+ */
+bool whisper_stream_vad_params(const whisper_params_t &params, frame_vad_params_t &vad);
+
+/**
+ * 计算一次推理的音频上下文大小，识别会话和 --bench 共用。
+ *
+ * -ac 为 -1 时按送入推理的样本数加上安全余量换算成编码器帧数，再限制在下限和模型上限之间；
+ * 否则直接使用 -ac 的值。
+ *
+ * @param params 命令行参数。
+ * @param n_samples 本次送入 whisper_full 的样本数。
+ * @param n_ctx_max 模型的音频上下文上限，即 whisper_model_n_audio_ctx()。
+ * @return whisper_full_params::audio_ctx 的值，0 表示全部。
+ */
+int whisper_stream_audio_ctx(const whisper_params_t &params, int n_samples, int n_ctx_max);
+
 /**
  * 运行 Whisper 语音流处理的主函数。
  *
- * @param whisper_fuzzy_ctx 指向 whisper_fuzzy_t 结构体的指针，包含语音处理的上下文信息。
+ * @param task 识别任务，包含参数副本、回调和共享的引擎；推理状态从引擎借用，返回前归还。
  * @return 成功返回 0，失败返回 -1。
  *
  * 该函数负责管理 Whisper 的音频流处理，调用相关的语音识别和匹配功能，
  * 以便实时处理输入音频数据并执行模糊匹配任务。
+ * 多个任务可以在不同线程中同时运行，共享同一份模型。
  */
-int whisper_stream_main(whisper_fuzzy_t *whisper_fuzzy_ctx);
+int whisper_stream_main(whisper_engine_task_t &task);
 
 #endif  // WHISPER_STREAM_H_
\ No newline at end of file